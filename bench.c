@@ -0,0 +1,783 @@
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include "legacy.h"
+#include "frames.h"
+#include "names.h"
+#include "timer.h"
+#include "metrics.h"
+#include "histogram.h"
+#include "recorder.h"
+
+// declare enumeration for constants of the benchmark
+typedef enum bench_constant {
+    BENCH_ROUNDS = 200000,
+    GAME_ROUNDS = 5,
+    ONLINE_PLAYERS = 10000,
+    NAME_ROUNDS = 5000,
+    POOL_GAMES = 64,
+    POOL_ROUNDS = 20000,
+    CLIENT_SIZE = 4400,
+    GAME_SIZE = 64,
+    OUTPUT_SIZE = 128,
+    OUTPUTS_PER_GAME = 12,
+    FAN_OUT_EVENTS = 200000,
+    FAN_OUT_BUFFER = 4096,
+    FLOOD_BYTES = 65536,
+    TIMER_CASES = 1000000,
+    TIMER_SPAN = 600000,
+    METRIC_THREADS = 4,
+    METRIC_CASES = 10000000,
+} bench_constant;
+
+// define struct for a timer of the timer benchmark, which is either in the wheel or in the binary heap
+typedef struct bench_timer {
+    timer wheel_timer;
+    long expires;
+    size_t heap_index;
+    size_t is_armed;
+} bench_timer;
+
+// prototypes for all functions
+void compare(double (*measure_variant)(size_t), const char *legacy_label, const char *label, const char *unit);
+double get_time_in_seconds();
+double get_rate(size_t operations, double start);
+double measure(size_t (*parser)(const char *, size_t *));
+double measure_parsers(size_t is_legacy);
+double measure_decoders(size_t is_legacy);
+size_t legacy_frame_and_decode(const char *msg_buffer, size_t *max_index);
+size_t frame_and_decode(const char *msg_buffer, size_t *max_index);
+size_t play_legacy_games(char *legacy_board, char role);
+size_t play_games(bitboard *board, char role);
+double measure_games(size_t is_legacy);
+double measure_names(size_t is_legacy);
+void* take_object(pool_kind kind, size_t size, size_t is_legacy);
+void give_object(pool_kind kind, void *object, size_t is_legacy);
+void play_allocations(size_t is_legacy, size_t is_ending);
+double measure_pools(size_t is_legacy);
+double measure_fan_out(size_t is_legacy);
+ssize_t send_fan_out(int socket, struct iovec *vectors, size_t is_legacy);
+void* receive_fan_out(void *arg);
+size_t measure_fairness(size_t is_legacy);
+double measure_timers(size_t is_heap);
+void heap_push(bench_timer *t);
+void heap_remove(bench_timer *t);
+void heap_swap(size_t i, size_t j);
+void heap_sift(size_t index);
+double measure_metrics(size_t is_legacy);
+void* count_metrics(void *arg);
+double measure_histograms(size_t is_timed);
+double measure_recorder();
+
+// global variable for the frames that a winning move sends to each player, which is a MOVD and an OVER message
+static const char *FAN_OUT_FRAMES[] = {"MOVD|16|X|XXXOO....|", "OVER|35|W|One player has completed a line.|"};
+
+// global variables for the timers of the timer benchmark and the binary heap that it compares the wheel to
+static bench_timer *timers;
+static bench_timer **heap;
+static size_t heap_length = 0;
+
+// global variables for the counters that every thread adds to atomically, the way a single set of counters would be
+// kept without per-thread blocks, and whether the metrics benchmark uses them
+static uint64_t legacy_metrics[NUMBER_OF_THREAD_METRICS];
+static size_t is_legacy_metrics = 0;
+
+// global variable for the messages that are parsed in the benchmark, in the mix a game sends them
+static const char *WORKLOAD[] = {
+        "PLAY|10|Joe Sally|",
+        "MOVE|6|X|2,2|",
+        "MOVE|6|O|3,3|",
+        "MOVE|6|X|1,2|",
+        "DRAW|2|S|",
+        "DRAW|2|R|",
+        "MOVE|6|O|3,2|",
+        "RSGN|0|",
+};
+
+// driver
+// measures every replaced part of the server against the legacy code it replaced, while ./test checks their behaviour
+int main(int argc, char **argv) {
+    // set stdout and stderr buffer to NULL
+    setbuf(stdout, NULL);
+    setbuf(stderr, NULL);
+    char unit[OUTPUT_SIZE];
+
+    // frame and decode the messages of a game
+    compare(&measure_parsers, "legacy parser:", "single-pass parser:", "frames/sec");
+    compare(&measure_decoders, "legacy decoding:", "decode_message():", "messages/sec");
+
+    // play every possible game on both boards
+    compare(&measure_games, "legacy board:", "bitboard:", "moves/sec");
+
+    // add and remove names on both sets, with the given number of players online
+    names_init();
+    snprintf(unit, sizeof(unit), "handshakes/sec with %d players online", ONLINE_PLAYERS);
+    compare(&measure_names, "legacy names:", "set of names:", unit);
+
+    // allocate the objects of games from the pools and from the heap
+    pool_init(POOL_CLIENT, "client", CLIENT_SIZE);
+    pool_init(POOL_GAME, "game", GAME_SIZE);
+    pool_init(POOL_SHORT_OUTPUT, "short_output", OUTPUT_SIZE);
+    compare(&measure_pools, "malloc() and free():", "pools:", "games/sec");
+
+    // send the frames of winning moves through a small socket buffer one by one and gathered by send_messages()
+    snprintf(unit, sizeof(unit), "events/sec through a socket buffer of %d bytes", FAN_OUT_BUFFER);
+    compare(&measure_fan_out, "write per frame:", "writev per event:", unit);
+
+    // let one socket flood while its opponent sends a single byte, and count what was read before the opponent's turn
+    printf("%-20s%12zu bytes of the flooding socket read before its opponent's turn\n", "first ready socket:",
+           measure_fairness(1));
+    printf("%-20s%12zu bytes of the flooding socket read before its opponent's turn\n", "readiness set:",
+           measure_fairness(0));
+
+    // arm, move and expire a million timers on the wheel and on a binary heap
+    snprintf(unit, sizeof(unit), "timers/sec with %d timers armed", TIMER_CASES);
+    compare(&measure_timers, "binary heap:", "timer wheel:", unit);
+
+    // count from several threads into their own blocks and into one set of shared counters, while snapshots are taken
+    snprintf(unit, sizeof(unit), "updates/sec from %d threads", METRIC_THREADS);
+    compare(&measure_metrics, "shared counters:", "per-thread blocks:", unit);
+
+    // record latencies into a histogram, with and without reading the clock for each of them
+    printf("%-20s%12.1f ns per latency\n", "recording:", 1e9 / measure_histograms(0));
+    printf("%-20s%12.1f ns per latency\n", "clock and record:", 1e9 / measure_histograms(1));
+
+    // record events into the ring of the flight recorder
+    recorder_start(NULL);
+    printf("%-20s%12.1f ns per event\n", "flight recorder:", 1e9 / measure_recorder());
+
+    return EXIT_SUCCESS;
+}
+
+// function that measures the legacy code and the code that replaced it, and prints both rates and the speedup
+// measure_variant() returns the number of operations per second of the legacy code when it is given 1
+void compare(double (*measure_variant)(size_t), const char *legacy_label, const char *label, const char *unit) {
+    double legacy = measure_variant(1);
+    double current = measure_variant(0);
+    printf("%-20s%12.0f %s\n", legacy_label, legacy, unit);
+    printf("%-20s%12.0f %s\n", label, current, unit);
+    printf("%-20s%12.1fx\n", "speedup:", current / legacy);
+}
+
+// function that gets the time of a monotonic clock in seconds
+double get_time_in_seconds() {
+    return get_time_in_ns() / 1e9;
+}
+
+// function that gets how many operations per second were made since the given start
+double get_rate(size_t operations, double start) {
+    return operations / (get_time_in_seconds() - start);
+}
+
+// function that measures how many messages of the workload the parser frames per second
+double measure(size_t (*parser)(const char *, size_t *)) {
+    size_t workload_length = sizeof(WORKLOAD) / sizeof(WORKLOAD[0]);
+    size_t total = 0;
+    double start = get_time_in_seconds();
+    for (size_t i = 0; i < BENCH_ROUNDS; i++) {
+        size_t max_index = 0;
+        if (parser(WORKLOAD[i % workload_length], &max_index) == 0) {
+            fprintf(stderr, "the workload has a message that is not complete\n");
+            exit(EXIT_FAILURE);
+        }
+        total += max_index;
+    }
+    double rate = get_rate(BENCH_ROUNDS, start);
+
+    // use the total, so the loop cannot be optimized away
+    if (total == 0) {
+        exit(EXIT_FAILURE);
+    }
+    return rate;
+}
+
+// function that measures how many frames per second the legacy parser or parse_frame() completes
+double measure_parsers(size_t is_legacy) {
+    return measure(is_legacy == 1 ? &legacy_is_complete_msg : &is_complete_msg);
+}
+
+// function that measures how many messages per second the legacy parse functions or decode_message() decode
+double measure_decoders(size_t is_legacy) {
+    return measure(is_legacy == 1 ? &legacy_frame_and_decode : &frame_and_decode);
+}
+
+// function that frames a message and decodes it the way the server did before decode_message()
+// the parse functions are tried one after the other, and each of them tokenizes the message again
+size_t legacy_frame_and_decode(const char *msg_buffer, size_t *max_index) {
+    if (legacy_is_complete_msg(msg_buffer, max_index) == 0) {
+        return 0;
+    }
+    char *player_name = NULL;
+    char role = '\0';
+    char action = '\0';
+    size_t row = 0;
+    size_t col = 0;
+    if (legacy_parse_play(msg_buffer, &player_name) == 0) {
+        Free(player_name);
+    } else if (legacy_parse_rsgn(msg_buffer) == -1 && legacy_parse_draw(msg_buffer, &action) == -1) {
+        legacy_parse_move(msg_buffer, &role, &row, &col);
+    }
+    return 1;
+}
+
+// function that frames a message with parse_frame() and decodes it with decode_message()
+size_t frame_and_decode(const char *msg_buffer, size_t *max_index) {
+    frame view;
+    if (parse_frame(msg_buffer, &view) == 0) {
+        return 0;
+    }
+    message decoded;
+    decode_message(msg_buffer, &view, &decoded);
+    *max_index = view.length + decoded.code;
+    return 1;
+}
+
+// function that plays every possible continuation of the game on the legacy board, where role moves next
+// returns the number of moves that were made
+size_t play_legacy_games(char *legacy_board, char role) {
+    size_t number_of_moves = 0;
+    for (size_t i = 0; i < NUMBER_OF_CELLS; i++) {
+        char next[NUMBER_OF_CELLS + 1];
+        strcpy(next, legacy_board);
+        if (legacy_make_move(next, role, i / 3, i % 3) == -1) {
+            continue;
+        }
+        number_of_moves++;
+        char status = '\0';
+        char winner = '\0';
+        legacy_get_game_status(next, &status, &winner);
+        if (status == 'N') {
+            number_of_moves += play_legacy_games(next, role == 'X' ? 'O' : 'X');
+        }
+    }
+    return number_of_moves;
+}
+
+// function that plays every possible continuation of the game on the bitboard, where role moves next
+// returns the number of moves that were made
+size_t play_games(bitboard *board, char role) {
+    size_t number_of_moves = 0;
+    for (size_t i = 0; i < NUMBER_OF_CELLS; i++) {
+        bitboard next = *board;
+        if (board_make_move(&next, role, i / 3, i % 3) == -1) {
+            continue;
+        }
+        number_of_moves++;
+        char status = '\0';
+        char winner = '\0';
+        board_get_status(&next, &status, &winner);
+        if (status == 'N') {
+            number_of_moves += play_games(&next, role == 'X' ? 'O' : 'X');
+        }
+    }
+    return number_of_moves;
+}
+
+// function that measures how many moves per second either board makes and checks while playing every possible game
+double measure_games(size_t is_legacy) {
+    size_t total = 0;
+    double start = get_time_in_seconds();
+    for (size_t i = 0; i < GAME_ROUNDS; i++) {
+        if (is_legacy == 1) {
+            char legacy_board[NUMBER_OF_CELLS + 1] = ".........";
+            total += play_legacy_games(legacy_board, 'X');
+        } else {
+            bitboard board;
+            board_init(&board);
+            total += play_games(&board, 'X');
+        }
+    }
+    return get_rate(total, start);
+}
+
+// function that measures how many handshakes per second either set of player names handles while the players are
+// online, where a handshake adds the name of a new player and the player that leaves removes its name
+double measure_names(size_t is_legacy) {
+    size_t (*add)(const char *) = is_legacy == 1 ? &legacy_add_player_name : &add_player_name;
+    void (*remove)(const char *) = is_legacy == 1 ? &legacy_remove_player_name : &remove_player_name;
+    static char names[ONLINE_PLAYERS][32];
+    for (size_t i = 0; i < ONLINE_PLAYERS; i++) {
+        snprintf(names[i], sizeof(names[i]), "Online %zu", i);
+        add(names[i]);
+    }
+
+    // a joining player's name is removed before its buffer is used for the next one
+    char player_name[32];
+
+    size_t total = 0;
+    double start = get_time_in_seconds();
+    for (size_t i = 0; i < NAME_ROUNDS; i++) {
+        snprintf(player_name, sizeof(player_name), "Joining %zu", i);
+        total += add(player_name) == 0;
+        remove(player_name);
+    }
+    double rate = get_rate(NAME_ROUNDS, start);
+
+    for (size_t i = 0; i < ONLINE_PLAYERS; i++) {
+        remove(names[i]);
+    }
+    if (total != NAME_ROUNDS) {
+        fprintf(stderr, "a joining player's name was taken\n");
+        exit(EXIT_FAILURE);
+    }
+    return rate;
+}
+
+// function that takes an object of the given kind from its pool, or an object of the given size from the heap
+void* take_object(pool_kind kind, size_t size, size_t is_legacy) {
+    void *object = is_legacy == 1 ? malloc(size) : pool_alloc(kind);
+    if (object == NULL) {
+        perror("take_object");
+        exit(EXIT_FAILURE);
+    }
+
+    // touch the object, as the server does when it fills it in
+    memset(object, 0, size < 64 ? size : 64);
+    return object;
+}
+
+// function that gives an object of the given kind back to its pool, or back to the heap
+void give_object(pool_kind kind, void *object, size_t is_legacy) {
+    if (is_legacy == 1) {
+        free(object);
+    } else {
+        pool_free(kind, object);
+    }
+}
+
+// function that allocates and frees the objects of overlapping games the way the server does: the two clients, their
+// names, a name in the set of player names each, the game, and the messages of the game
+// when is_ending is 1, the games that are still going on end without starting new ones
+void play_allocations(size_t is_legacy, size_t is_ending) {
+    static void *objects[POOL_GAMES][7 + OUTPUTS_PER_GAME];
+    static size_t is_started = 0;
+    for (size_t i = 0; i < POOL_GAMES; i++) {
+        // end the game that was played in this slot before starting a new one
+        if (is_started == 1) {
+            for (size_t j = 0; j < 2; j++) {
+                give_object(POOL_CLIENT, objects[i][j], is_legacy);
+            }
+            for (size_t j = 2; j < 6; j++) {
+                give_object(POOL_SHORT_NAME, objects[i][j], is_legacy);
+            }
+            give_object(POOL_GAME, objects[i][6], is_legacy);
+        }
+        if (is_ending == 1) {
+            continue;
+        }
+        for (size_t j = 0; j < 2; j++) {
+            objects[i][j] = take_object(POOL_CLIENT, CLIENT_SIZE, is_legacy);
+        }
+        for (size_t j = 2; j < 6; j++) {
+            objects[i][j] = take_object(POOL_SHORT_NAME, 16, is_legacy);
+        }
+        objects[i][6] = take_object(POOL_GAME, GAME_SIZE, is_legacy);
+
+        // every message is freed once it has been sent
+        for (size_t j = 0; j < OUTPUTS_PER_GAME; j++) {
+            objects[i][7 + j] = take_object(POOL_SHORT_OUTPUT, OUTPUT_SIZE, is_legacy);
+            give_object(POOL_SHORT_OUTPUT, objects[i][7 + j], is_legacy);
+        }
+    }
+    is_started = is_ending == 0;
+}
+
+// function that measures how many games per second allocate and free their objects from the pools or the heap
+double measure_pools(size_t is_legacy) {
+    double start = get_time_in_seconds();
+    for (size_t i = 0; i < POOL_ROUNDS / POOL_GAMES; i++) {
+        play_allocations(is_legacy, 0);
+    }
+    play_allocations(is_legacy, 1);
+    return get_rate(POOL_ROUNDS / POOL_GAMES * POOL_GAMES, start);
+}
+
+// function that measures how many events per second send the frames of a winning move to a player, where each frame
+// is written by itself the way the server did before it gathered the frames of a client, or all of them by one writev()
+// the writing socket is non-blocking and its buffer is small, so partial writes and full buffers are exercised
+// exits if the receiving thread does not get every frame in order
+double measure_fan_out(size_t is_legacy) {
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == -1) {
+        perror("socketpair");
+        exit(EXIT_FAILURE);
+    }
+    int buffer_size = FAN_OUT_BUFFER;
+    if (setsockopt(sockets[0], SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size)) == -1 ||
+        fcntl(sockets[0], F_SETFL, O_NONBLOCK) == -1) {
+        perror("measure_fan_out");
+        exit(EXIT_FAILURE);
+    }
+    pthread_t receiver;
+    if (pthread_create(&receiver, NULL, &receive_fan_out, (void *) (uintptr_t) sockets[1]) != 0) {
+        perror("pthread_create");
+        exit(EXIT_FAILURE);
+    }
+
+    double start = get_time_in_seconds();
+    for (size_t i = 0; i < FAN_OUT_EVENTS; i++) {
+        struct iovec vectors[2];
+        for (size_t j = 0; j < 2; j++) {
+            vectors[j].iov_base = (char *) FAN_OUT_FRAMES[j];
+            vectors[j].iov_len = strlen(FAN_OUT_FRAMES[j]);
+        }
+        if (send_fan_out(sockets[0], vectors, is_legacy) == -1) {
+            perror("measure_fan_out");
+            exit(EXIT_FAILURE);
+        }
+    }
+    close(sockets[0]);
+    if (pthread_join(receiver, NULL) != 0) {
+        perror("pthread_join");
+        exit(EXIT_FAILURE);
+    }
+    double rate = get_rate(FAN_OUT_EVENTS, start);
+    close(sockets[1]);
+    return rate;
+}
+
+// function that sends the frames of an event one by one or gathered, and waits for room in the send buffer whenever
+// it fills up, which the server leaves to its event loop
+// returns -1 on error and 0 on success
+ssize_t send_fan_out(int socket, struct iovec *vectors, size_t is_legacy) {
+    struct pollfd poll_socket;
+    memset(&poll_socket, 0, sizeof(struct pollfd));
+    poll_socket.fd = socket;
+    poll_socket.events = POLLOUT;
+    if (is_legacy == 0) {
+        size_t length = vectors[0].iov_len + vectors[1].iov_len;
+        while (length > 0) {
+            ssize_t write_status = send_messages(socket, vectors, 2);
+            if (write_status == -1) {
+                return -1;
+            }
+            length -= write_status;
+            if (length > 0 && poll(&poll_socket, 1, -1) == -1) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+    for (size_t i = 0; i < 2; i++) {
+        size_t bytes_written = 0;
+        while (bytes_written < vectors[i].iov_len) {
+            ssize_t write_status = send_message(socket, (char *) vectors[i].iov_base + bytes_written,
+                                                vectors[i].iov_len - bytes_written);
+            if (write_status == -1) {
+                return -1;
+            }
+            bytes_written += write_status;
+            if (bytes_written < vectors[i].iov_len && poll(&poll_socket, 1, -1) == -1) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+// function that receives the frames of every event of the fan-out benchmark until the socket is closed
+// exits if a byte differs from the frames that were sent or bytes are missing
+void* receive_fan_out(void *arg) {
+    int socket = (uintptr_t) arg;
+    size_t frame = 0;
+    size_t offset = 0;
+    size_t number_of_frames = 0;
+    char buffer[FAN_OUT_BUFFER];
+    ssize_t length;
+    while ((length = read(socket, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t i = 0; i < length; i++) {
+            if (buffer[i] != FAN_OUT_FRAMES[frame][offset]) {
+                fprintf(stderr, "frame %zu was received out of order\n", number_of_frames);
+                exit(EXIT_FAILURE);
+            }
+            if (FAN_OUT_FRAMES[frame][++offset] == '\0') {
+                frame = 1 - frame;
+                offset = 0;
+                number_of_frames++;
+            }
+        }
+    }
+    if (length == -1 || number_of_frames != 2 * FAN_OUT_EVENTS) {
+        fprintf(stderr, "%zu of %d frames were received\n", number_of_frames, 2 * FAN_OUT_EVENTS);
+        exit(EXIT_FAILURE);
+    }
+    return NULL;
+}
+
+// function that lets the first of two sockets flood while the second sends a single byte, and serves whichever socket
+// is ready with one read of at most FAN_OUT_BUFFER bytes at a time, until the second socket has had its turn
+// the legacy way polls for the first ready socket, and the readiness set serves every ready socket in turn
+// returns the number of bytes of the flooding socket that were read before the second socket had its turn
+size_t measure_fairness(size_t is_legacy) {
+    int flooding[2];
+    int quiet[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, flooding) == -1 || socketpair(AF_UNIX, SOCK_STREAM, 0, quiet) == -1) {
+        perror("socketpair");
+        exit(EXIT_FAILURE);
+    }
+    int buffer_size = FLOOD_BYTES;
+    if (setsockopt(flooding[0], SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size)) == -1 ||
+        fcntl(flooding[0], F_SETFL, O_NONBLOCK) == -1) {
+        perror("measure_fairness");
+        exit(EXIT_FAILURE);
+    }
+
+    // fill the flooding socket as far as it goes, then let the quiet socket send its byte
+    char buffer[FAN_OUT_BUFFER];
+    memset(buffer, 'x', sizeof(buffer));
+    size_t number_of_flooded = 0;
+    ssize_t length;
+    while (number_of_flooded < FLOOD_BYTES && (length = write(flooding[0], buffer, sizeof(buffer))) > 0) {
+        number_of_flooded += length;
+    }
+    if (write(quiet[0], "x", 1) != 1) {
+        perror("write");
+        exit(EXIT_FAILURE);
+    }
+
+    int sockets[2] = {flooding[1], quiet[1]};
+    readiness_set set;
+    if (is_legacy == 0 && (readiness_set_init(&set) == -1 ||
+                           watch_socket(set.event_loop, sockets[0], &sockets[0]) == -1 ||
+                           watch_socket(set.event_loop, sockets[1], &sockets[1]) == -1)) {
+        perror("measure_fairness");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t number_of_read = 0;
+    size_t is_served = 0;
+    while (is_served == 0) {
+        // find the sockets that are served in this turn
+        int ready[2];
+        int number_of_ready = 0;
+        if (is_legacy == 1) {
+            ssize_t index = legacy_get_readable_socket(sockets, 2, -1);
+            if (index != -1) {
+                ready[number_of_ready++] = sockets[index];
+            }
+        } else {
+            wait_for_ready(&set, -1);
+            for (int i = 0; i < set.number_of_ready; i++) {
+                ready[number_of_ready++] = *(int *) set.ready[i].data.ptr;
+            }
+        }
+        if (number_of_ready == 0) {
+            perror("measure_fairness");
+            exit(EXIT_FAILURE);
+        }
+
+        for (int i = 0; i < number_of_ready && is_served == 0; i++) {
+            length = read(ready[i], buffer, sizeof(buffer));
+            if (ready[i] == quiet[1]) {
+                is_served = 1;
+            } else if (length > 0) {
+                number_of_read += length;
+            }
+        }
+    }
+
+    if (is_legacy == 0) {
+        close(set.event_loop);
+    }
+    close(flooding[0]);
+    close(flooding[1]);
+    close(quiet[0]);
+    close(quiet[1]);
+    return number_of_read;
+}
+
+// function that measures how many updates per second the threads of the benchmark make while this thread takes
+// snapshots, the way the admin port reads the metrics while the server runs
+double measure_metrics(size_t is_legacy) {
+    is_legacy_metrics = is_legacy;
+    pthread_t threads[METRIC_THREADS];
+    double start = get_time_in_seconds();
+    for (size_t i = 0; i < METRIC_THREADS; i++) {
+        if (pthread_create(&threads[i], NULL, &count_metrics, (void *) (uintptr_t) i) != 0) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // a reader never makes the threads wait
+    uint64_t counted = 0;
+    size_t number_of_snapshots = 0;
+    while (is_legacy == 0 && counted < (uint64_t) 13 * METRIC_CASES && number_of_snapshots < 1000) {
+        metrics_snapshot snapshot;
+        metrics_take_snapshot(&snapshot);
+        counted = snapshot.values[METRIC_BYTES_RECEIVED];
+        number_of_snapshots++;
+        sched_yield();
+    }
+    for (size_t i = 0; i < METRIC_THREADS; i++) {
+        if (pthread_join(threads[i], NULL) != 0) {
+            perror("pthread_join");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return get_rate(3 * (size_t) METRIC_CASES, start);
+}
+
+// function that makes the updates of one thread of the metrics benchmark, which counts a message of each opcode in
+// turn and its bytes, and begins or ends a game, where half of the threads begin the games that the others end
+void* count_metrics(void *arg) {
+    size_t thread = (uintptr_t) arg;
+    for (size_t i = thread; i < METRIC_CASES; i += METRIC_THREADS) {
+        metric_slot slot = METRIC_MESSAGES_RECEIVED + i % METRIC_OPCODES;
+        if (is_legacy_metrics == 1) {
+            __atomic_add_fetch(&legacy_metrics[slot], 1, __ATOMIC_RELAXED);
+            __atomic_add_fetch(&legacy_metrics[METRIC_BYTES_RECEIVED], 13, __ATOMIC_RELAXED);
+            __atomic_add_fetch(&legacy_metrics[METRIC_LIVE_GAMES], i % 2 == 0 ? 1 : -1, __ATOMIC_RELAXED);
+            continue;
+        }
+        metrics_add(slot, 1);
+        metrics_add(METRIC_BYTES_RECEIVED, 13);
+        metrics_add(METRIC_LIVE_GAMES, i % 2 == 0 ? 1 : -1);
+    }
+    return NULL;
+}
+
+// function that measures how many latencies per second are recorded, with or without reading the monotonic clock for
+// each of them the way the server does once for the responses of a write
+double measure_histograms(size_t is_timed) {
+    histogram *h = calloc(1, sizeof(histogram));
+    if (h == NULL) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    double start = get_time_in_seconds();
+    uint64_t random = 40000;
+    for (size_t i = 0; i < BENCH_ROUNDS * 10; i++) {
+        random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t value = random >> 44;
+        if (is_timed == 1) {
+            value = get_time_in_ns() % 1000000;
+        }
+        histogram_record(h, value);
+    }
+    double rate = get_rate(BENCH_ROUNDS * 10, start);
+    if (h->count != BENCH_ROUNDS * 10) {
+        fprintf(stderr, "the histogram counted %" PRIu64 " latencies\n", h->count);
+        exit(EXIT_FAILURE);
+    }
+    h = Free(h);
+    return rate;
+}
+
+// function that measures how many events per second the main thread records, which reads the monotonic clock and
+// writes the event into the ring of the thread, the way the server does for every frame
+double measure_recorder() {
+    double start = get_time_in_seconds();
+    for (size_t i = 0; i < BENCH_ROUNDS * 10; i++) {
+        recorder_record(FLIGHT_FRAME_IN, i, CODE_MOVE, 12);
+    }
+    return get_rate(BENCH_ROUNDS * 10, start);
+}
+
+// function that measures how many timers per second are armed, moved once, and expired on the wheel or on a binary
+// heap, the way a server keeps an idle timer for every connection and moves it whenever the connection is active
+double measure_timers(size_t is_heap) {
+    timers = calloc(TIMER_CASES, sizeof(bench_timer));
+    heap = calloc(TIMER_CASES, sizeof(bench_timer *));
+    if (timers == NULL || heap == NULL) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    srand(2);
+    for (size_t i = 0; i < TIMER_CASES; i++) {
+        timers[i].expires = rand() % TIMER_SPAN;
+    }
+    heap_length = 0;
+    timer_wheel wheel;
+    timer_wheel_init(&wheel, 0);
+
+    double start = get_time_in_seconds();
+    for (size_t i = 0; i < TIMER_CASES; i++) {
+        if (is_heap == 1) {
+            heap_push(&timers[i]);
+        } else {
+            timer_init(&timers[i].wheel_timer, 0, &timers[i]);
+            timer_arm(&wheel, &timers[i].wheel_timer, timers[i].expires);
+        }
+    }
+    for (size_t i = 0; i < TIMER_CASES; i++) {
+        timers[i].expires += TIMER_SPAN / 2;
+        if (is_heap == 1) {
+            heap_remove(&timers[i]);
+            heap_push(&timers[i]);
+        } else {
+            timer_arm(&wheel, &timers[i].wheel_timer, timers[i].expires);
+        }
+    }
+    size_t number_of_expired = 0;
+    for (long now = 0; now < 2 * TIMER_SPAN; now += 10) {
+        if (is_heap == 1) {
+            while (heap_length > 0 && heap[0]->expires <= now) {
+                heap_remove(heap[0]);
+                number_of_expired++;
+            }
+        } else {
+            while (timer_wheel_expire(&wheel, now) != NULL) {
+                number_of_expired++;
+            }
+        }
+    }
+    double rate = get_rate(TIMER_CASES, start);
+
+    if (number_of_expired != TIMER_CASES) {
+        fprintf(stderr, "%zu of %d timers expired\n", number_of_expired, TIMER_CASES);
+        exit(EXIT_FAILURE);
+    }
+    timers = Free(timers);
+    heap = Free(heap);
+    return rate;
+}
+
+// function that adds the timer to the binary heap
+void heap_push(bench_timer *t) {
+    t->heap_index = heap_length;
+    heap[heap_length++] = t;
+    heap_sift(t->heap_index);
+}
+
+// function that removes the timer from the binary heap by moving the last timer into its place
+void heap_remove(bench_timer *t) {
+    size_t index = t->heap_index;
+    heap_swap(index, --heap_length);
+    if (index < heap_length) {
+        heap_sift(index);
+    }
+}
+
+// function that swaps two timers of the binary heap
+void heap_swap(size_t i, size_t j) {
+    bench_timer *t = heap[i];
+    heap[i] = heap[j];
+    heap[j] = t;
+    heap[i]->heap_index = i;
+    heap[j]->heap_index = j;
+}
+
+// function that moves the timer at the index up or down until the binary heap is in order again
+void heap_sift(size_t index) {
+    while (index > 0 && heap[(index - 1) / 2]->expires > heap[index]->expires) {
+        heap_swap(index, (index - 1) / 2);
+        index = (index - 1) / 2;
+    }
+    while (1) {
+        size_t smallest = index;
+        for (size_t child = 2 * index + 1; child <= 2 * index + 2 && child < heap_length; child++) {
+            if (heap[child]->expires < heap[smallest]->expires) {
+                smallest = child;
+            }
+        }
+        if (smallest == index) {
+            return;
+        }
+        heap_swap(index, smallest);
+        index = smallest;
+    }
+}
+
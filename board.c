@@ -0,0 +1,84 @@
+#include "board.h"
+
+// global variable for the masks of the rows, columns and diagonals, which is thread-safe because it is read only
+static const uint16_t WIN_LINES[NUMBER_OF_LINES] = {
+        0x007, 0x038, 0x1C0,
+        0x049, 0x092, 0x124,
+        0x111, 0x054,
+};
+
+// prototypes of internal functions
+static size_t has_line(uint16_t mask);
+
+// function that initializes an empty board
+void board_init(bitboard *board) {
+    board->x = 0;
+    board->o = 0;
+}
+
+// function that makes a move on the board, where row and col are from 0 to 2
+// returns -1 on error, 0 on success
+ssize_t board_make_move(bitboard *board, char role, size_t row, size_t col) {
+    // check row and col
+    if (row >= BOARD_SIZE || col >= BOARD_SIZE) {
+        return -1;
+    }
+
+    // check if the space is empty
+    uint16_t cell = 1 << (row * BOARD_SIZE + col);
+    if (((board->x | board->o) & cell) != 0) {
+        return -1;
+    }
+
+    // make the move
+    if (role == 'X') {
+        board->x |= cell;
+    } else if (role == 'O') {
+        board->o |= cell;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+// function that writes the status of the game ("W" or "D" or "N") and the winner ("X" or "O") if there is one
+void board_get_status(const bitboard *board, char *status, char *winner) {
+    if (has_line(board->x) == 1) {
+        *status = 'W';
+        *winner = 'X';
+    } else if (has_line(board->o) == 1) {
+        *status = 'W';
+        *winner = 'O';
+    } else if ((board->x | board->o) == FULL_BOARD) {
+        *status = 'D';
+        *winner = '.';
+    } else {
+        *status = 'N';
+        *winner = '.';
+    }
+}
+
+// function that writes the grid of the board as 9 characters ("X" or "O" or "." for an empty space)
+// and a null terminator, row by row, so grid must have room for 10 characters
+void board_render(const bitboard *board, char *grid) {
+    for (size_t i = 0; i < NUMBER_OF_CELLS; i++) {
+        if ((board->x >> i) & 1) {
+            grid[i] = 'X';
+        } else if ((board->o >> i) & 1) {
+            grid[i] = 'O';
+        } else {
+            grid[i] = '.';
+        }
+    }
+    grid[NUMBER_OF_CELLS] = '\0';
+}
+
+// function that checks if the cells of the mask complete a row, a column or a diagonal
+static size_t has_line(uint16_t mask) {
+    for (size_t i = 0; i < NUMBER_OF_LINES; i++) {
+        if ((mask & WIN_LINES[i]) == WIN_LINES[i]) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,28 @@
+#ifndef P3_BOARD_H
+#define P3_BOARD_H
+
+#include <stdint.h>
+#include "helper.h"
+
+// declare enumeration for constants of the board
+// cell i of the board is bit i of a mask, counting row by row from the top left corner
+typedef enum board_constant {
+    BOARD_SIZE = 3,
+    NUMBER_OF_CELLS = 9,
+    NUMBER_OF_LINES = 8,
+    FULL_BOARD = 0x1FF,
+} board_constant;
+
+// define struct for the board of a game as one 9-bit mask of the cells taken by each role
+typedef struct bitboard {
+    uint16_t x;
+    uint16_t o;
+} bitboard;
+
+// prototypes of all functions
+void board_init(bitboard *board);
+ssize_t board_make_move(bitboard *board, char role, size_t row, size_t col);
+void board_get_status(const bitboard *board, char *status, char *winner);
+void board_render(const bitboard *board, char *grid);
+
+#endif //P3_BOARD_H
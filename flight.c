@@ -0,0 +1,140 @@
+#define _POSIX_C_SOURCE 200809L
+#include "recorder.h"
+
+// prototypes for all functions
+void check_arguments(int argc);
+char* read_recording(const char *path, size_t *size);
+flight_header* check_recording(char *recording, size_t size);
+size_t collect_events(const flight_header *header, const char *recording, flight_event *events);
+int compare_events(const void *first, const void *second);
+
+// driver
+int main(int argc, char **argv) {
+    // set stdout and stderr buffer to NULL
+    setbuf(stdout, NULL);
+    setbuf(stderr, NULL);
+
+    // check if the arguments are correct
+    check_arguments(argc);
+
+    // read the recording and check that it was written by a server with the same layout of events
+    size_t size = 0;
+    char *recording = read_recording(argv[1], &size);
+    flight_header *header = check_recording(recording, size);
+
+    // merge the rings of every thread into one list of events in the order they happened
+    flight_event *events = malloc((header->number_of_rings * (size_t) FLIGHT_RING_EVENTS + 1) * sizeof(flight_event));
+    if (events == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    size_t number_of_events = collect_events(header, recording, events);
+    qsort(events, number_of_events, sizeof(flight_event), compare_events);
+
+    // print a line for every event
+    printf("pid %u, %u threads, %zu events\n", header->pid, header->number_of_rings, number_of_events);
+    char line[FLIGHT_LINE_SIZE];
+    for (size_t i = 0; i < number_of_events; i++) {
+        if (recorder_describe(header, &events[i], line, sizeof(line)) != -1) {
+            printf("%s\n", line);
+        }
+    }
+
+    events = Free(events);
+    recording = Free(recording);
+
+    // exit the program successfully
+    return EXIT_SUCCESS;
+}
+
+// function that checks if the arguments are correct
+void check_arguments(int argc) {
+    // check if the number of arguments is correct
+    if (argc != 2) {
+        if (write(STDERR_FILENO, "Usage: ./flight <recording>\n", 28) != 28) {
+            perror("write");
+        }
+        exit(EXIT_FAILURE);
+    }
+}
+
+// function that reads the whole recording at the path into memory
+// returns the recording, which the caller frees
+char* read_recording(const char *path, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        perror("fopen");
+        exit(EXIT_FAILURE);
+    }
+    size_t capacity = sizeof(flight_header) + sizeof(flight_ring);
+    char *recording = malloc(capacity);
+    if (recording == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    *size = 0;
+    while (1) {
+        if (*size == capacity) {
+            capacity *= 2;
+            recording = realloc(recording, capacity);
+            if (recording == NULL) {
+                perror("realloc");
+                exit(EXIT_FAILURE);
+            }
+        }
+        size_t length = fread(recording + *size, 1, capacity - *size, file);
+        if (length == 0) {
+            break;
+        }
+        *size += length;
+    }
+    if (ferror(file)) {
+        perror("fread");
+        exit(EXIT_FAILURE);
+    }
+    fclose(file);
+    return recording;
+}
+
+// function that checks the header of the recording and that the recording holds every ring the header counts
+// a recording backed by a file holds every ring the server could have taken, and only the counted ones are read
+// returns the header of the recording
+flight_header* check_recording(char *recording, size_t size) {
+    flight_header *header = (flight_header *) recording;
+    if (size < sizeof(flight_header) || memcmp(header->magic, FLIGHT_MAGIC, sizeof(header->magic)) != 0) {
+        fprintf(stderr, "flight: not a recording of the server\n");
+        exit(EXIT_FAILURE);
+    }
+    if (header->event_size != sizeof(flight_event) || header->ring_events != FLIGHT_RING_EVENTS) {
+        fprintf(stderr, "flight: recording of a server with a different layout of events\n");
+        exit(EXIT_FAILURE);
+    }
+    if (header->number_of_rings > MAX_FLIGHT_RINGS ||
+        size < sizeof(flight_header) + header->number_of_rings * sizeof(flight_ring)) {
+        fprintf(stderr, "flight: recording is truncated\n");
+        exit(EXIT_FAILURE);
+    }
+    return header;
+}
+
+// function that copies the events that every ring still holds, from its oldest to its newest, into events
+// returns the number of events copied
+size_t collect_events(const flight_header *header, const char *recording, flight_event *events) {
+    const flight_ring *rings = (const flight_ring *) (recording + sizeof(flight_header));
+    size_t number_of_events = 0;
+    for (size_t i = 0; i < header->number_of_rings; i++) {
+        uint64_t head = rings[i].head;
+        uint64_t oldest = head > FLIGHT_RING_EVENTS ? head - FLIGHT_RING_EVENTS : 0;
+        for (uint64_t j = oldest; j < head; j++) {
+            events[number_of_events++] = rings[i].events[j & (FLIGHT_RING_EVENTS - 1)];
+        }
+    }
+    return number_of_events;
+}
+
+// function that compares two events by the time they happened, for qsort
+int compare_events(const void *first, const void *second) {
+    const flight_event *event1 = first;
+    const flight_event *event2 = second;
+    return (event1->time > event2->time) - (event1->time < event2->time);
+}
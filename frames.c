@@ -0,0 +1,94 @@
+#include "frames.h"
+
+// global variables for the MOVD frame of every cell of every board and the index of each mask of a board
+// they are filled in once by frames_init() before the shards start, and only read after that
+static char movd_frames[NUMBER_OF_BOARDS][NUMBER_OF_CELLS][MOVD_LENGTH + 1];
+static size_t mask_indexes[FULL_BOARD + 1];
+
+// prototypes of internal functions
+static size_t get_board_index(const bitboard *board);
+
+// function that fills in the MOVD frame of every cell of every board, so the game loop only looks them up
+// the index of a board is the number with the base-3 digits 0 for an empty cell, 1 for X and 2 for O
+void frames_init() {
+    // the index of a mask is the index of the board that only has X on the cells of the mask
+    for (size_t mask = 0; mask <= FULL_BOARD; mask++) {
+        size_t index = 0;
+        for (size_t i = NUMBER_OF_CELLS; i > 0; i--) {
+            index = index * 3 + ((mask >> (i - 1)) & 1);
+        }
+        mask_indexes[mask] = index;
+    }
+
+    for (size_t index = 0; index < NUMBER_OF_BOARDS; index++) {
+        // render the grid of the board
+        char grid[NUMBER_OF_CELLS + 1];
+        size_t digits = index;
+        for (size_t i = 0; i < NUMBER_OF_CELLS; i++, digits /= 3) {
+            grid[i] = ".XO"[digits % 3];
+        }
+        grid[NUMBER_OF_CELLS] = '\0';
+
+        // there is only a frame for the cells that are taken, since the move was made on that cell
+        for (size_t i = 0; i < NUMBER_OF_CELLS; i++) {
+            if (grid[i] == '.') {
+                continue;
+            }
+            char *frame = movd_frames[index][i];
+            memcpy(frame, "MOVD|16|X|1,1|", 14);
+            frame[8] = grid[i];
+            frame[10] = '1' + i / BOARD_SIZE; // NOLINT(cppcoreguidelines-narrowing-conversions)
+            frame[12] = '1' + i % BOARD_SIZE; // NOLINT(cppcoreguidelines-narrowing-conversions)
+            memcpy(frame + 14, grid, NUMBER_OF_CELLS);
+            frame[MOVD_LENGTH - 1] = '|';
+            frame[MOVD_LENGTH] = '\0';
+        }
+    }
+}
+
+// function that looks up the MOVD frame of the move on the given cell of the board, where row and col are from 0 to 2
+// returns -1 on error, 0 on success
+ssize_t get_movd_frame(const bitboard *board, size_t row, size_t col, wire_frame *frame) {
+    // input validation
+    if (board == NULL || frame == NULL || row >= BOARD_SIZE || col >= BOARD_SIZE) {
+        return -1;
+    }
+
+    // the cell of the move must be taken
+    const char *bytes = movd_frames[get_board_index(board)][row * BOARD_SIZE + col];
+    if (bytes[0] == '\0') {
+        return -1;
+    }
+    frame->bytes = bytes;
+    frame->length = MOVD_LENGTH;
+    return 0;
+}
+
+// function that generates a BEGN message in the given buffer, which must have room for BEGN_CAPACITY bytes
+// the name of the opponent is only known once the game starts, so it is the one frame that is not looked up
+// returns -1 on error, 0 on success
+ssize_t generate_BEGN(char role, const char *opponent_name, char *begn_msg, wire_frame *frame) {
+    // input validation
+    if (role != 'X' && role != 'O') {
+        return -1;
+    }
+    if (opponent_name == NULL || strlen(opponent_name) == 0 || begn_msg == NULL || frame == NULL) {
+        return -1;
+    }
+
+    // example of message is BEGN|6|X|bar|, where 6 is the remaining number of bytes after "|" and "X" is the role
+    // and bar is the opponent's name
+    size_t remaining_bytes = 2 + strlen(opponent_name) + 1;
+    int length = snprintf(begn_msg, BEGN_CAPACITY, "BEGN|%zu|%c|%s|", remaining_bytes, role, opponent_name);
+    if (length < 0 || length >= BEGN_CAPACITY) {
+        return -1;
+    }
+    frame->bytes = begn_msg;
+    frame->length = length;
+    return 0;
+}
+
+// function that gets the index of the board in the table of MOVD frames
+static size_t get_board_index(const bitboard *board) {
+    return mask_indexes[board->x] + 2 * mask_indexes[board->o];
+}
@@ -0,0 +1,26 @@
+#ifndef P3_FRAMES_H
+#define P3_FRAMES_H
+
+#include "board.h"
+
+// declare enumeration for constants of the frames that the server sends
+// there is a MOVD frame for every cell of every board, where each cell is empty or taken by X or O
+// a BEGN frame holds a name of at most 998 bytes, which is the most a PLAY message can carry
+typedef enum frames_constant {
+    NUMBER_OF_BOARDS = 19683,
+    MOVD_LENGTH = 24,
+    BEGN_CAPACITY = 1024,
+} frames_constant;
+
+// define struct for a frame that is ready to be sent, the bytes are null-terminated so they can be logged
+typedef struct wire_frame {
+    const char *bytes;
+    size_t length;
+} wire_frame;
+
+// prototypes of all functions
+void frames_init();
+ssize_t get_movd_frame(const bitboard *board, size_t row, size_t col, wire_frame *frame);
+ssize_t generate_BEGN(char role, const char *opponent_name, char *begn_msg, wire_frame *frame);
+
+#endif //P3_FRAMES_H
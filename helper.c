@@ -1,3 +1,5 @@
+#define _POSIX_C_SOURCE 199309L
+#include <time.h>
 #include "helper.h"
 
 // define free function that changes the pointer to NULL after freeing
@@ -530,3 +532,18 @@ char* read_file(int fd) {
     return buffer;
 }
 
+// function that returns the value of the monotonic clock in milliseconds
+long get_time_in_ms() {
+    return (long) (get_time_in_ns() / 1000000);
+}
+
+// function that returns the value of the monotonic clock in nanoseconds, which is never 0
+// a time of 0 can therefore stand for no time at all
+uint64_t get_time_in_ns() {
+    struct timespec now;
+    if (clock_gettime(CLOCK_MONOTONIC, &now) == -1) {
+        perror("clock_gettime");
+        exit(EXIT_FAILURE);
+    }
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec + 1;
+}
@@ -4,11 +4,18 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <strings.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+// declare enumeration for constants that are shared by every module
+// data that different threads change is kept on separate cache lines of this size, so they do not slow each other down
+typedef enum helper_constant {
+    CACHE_LINE_SIZE = 64,
+} helper_constant;
+
 // prototypes of all functions
 void* Free(void *ptr);
 char** strTokenize(const char *str, const char *delimiters, size_t *numOfTokens, const char *specialTokens);
@@ -20,5 +27,7 @@ void* freeArrayOfStrings(char **array, size_t numOfStrings);
 char* strdup(const char *str);
 char** strDupArrayOfStrings(char **array, size_t numOfStrings);
 char* read_file(int fd);
+long get_time_in_ms();
+uint64_t get_time_in_ns();
 
 #endif //P3_HELPER_H
@@ -0,0 +1,90 @@
+#include "histogram.h"
+
+// prototypes of internal functions
+static size_t get_bucket_index(uint64_t value);
+static uint64_t get_bucket_limit(size_t index);
+static void add_to_counter(uint64_t *counter, uint64_t value);
+
+// function that records the value into the histogram, which only the thread that owns the histogram may do
+void histogram_record(histogram *h, uint64_t value) {
+    add_to_counter(&h->buckets[get_bucket_index(value)], 1);
+    add_to_counter(&h->count, 1);
+    add_to_counter(&h->sum, value);
+    if (value > h->max) {
+        __atomic_store_n(&h->max, value, __ATOMIC_RELAXED);
+    }
+}
+
+// function that adds the values of a histogram that another thread may be recording into to the given histogram
+// the counters of the other histogram are read one by one, so the merged count may be a few values ahead of its buckets
+void histogram_merge(histogram *into, const histogram *from) {
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        into->buckets[i] += __atomic_load_n(&from->buckets[i], __ATOMIC_RELAXED);
+    }
+    into->count += __atomic_load_n(&from->count, __ATOMIC_RELAXED);
+    into->sum += __atomic_load_n(&from->sum, __ATOMIC_RELAXED);
+    uint64_t max = __atomic_load_n(&from->max, __ATOMIC_RELAXED);
+    if (max > into->max) {
+        into->max = max;
+    }
+}
+
+// function that returns the value below which the given percentile (between 0 and 100) of the values fall
+// the value is the upper limit of its bucket, so it is never lower than the exact percentile and at most 1/32 above it
+// returns 0 if the histogram is empty
+uint64_t histogram_get_percentile(const histogram *h, double percentile) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        total += h->buckets[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    // the rank of the value is rounded up, so the 100th percentile is the largest value
+    uint64_t rank = (uint64_t) (percentile / 100.0 * total + 0.999999);
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= rank) {
+            uint64_t limit = get_bucket_limit(i);
+            return limit < h->max ? limit : h->max;
+        }
+    }
+    return h->max;
+}
+
+// function that returns the index of the bucket of the value
+// the bits of the value below its highest 6 bits are dropped, and the highest bit picks the group of 32 buckets
+static size_t get_bucket_index(uint64_t value) {
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+        return value;
+    }
+    size_t exponent = 63 - __builtin_clzll(value);
+    if (exponent >= HISTOGRAM_MAX_BITS) {
+        return HISTOGRAM_BUCKETS - 1;
+    }
+    size_t shift = exponent - HISTOGRAM_SUB_BITS;
+    return (shift + 1) * HISTOGRAM_SUB_BUCKETS + (value >> shift) - HISTOGRAM_SUB_BUCKETS;
+}
+
+// function that returns the largest value that falls into the bucket of the given index
+static uint64_t get_bucket_limit(size_t index) {
+    if (index < HISTOGRAM_SUB_BUCKETS) {
+        return index;
+    }
+    if (index == HISTOGRAM_BUCKETS - 1) {
+        return UINT64_MAX;
+    }
+    size_t shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+    uint64_t lowest = (uint64_t) (index % HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BUCKETS) << shift;
+    return lowest + (1ULL << shift) - 1;
+}
+
+// function that adds to a counter that only the current thread writes, so it needs no locked instruction
+static void add_to_counter(uint64_t *counter, uint64_t value) {
+    __atomic_store_n(counter, *counter + value, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,31 @@
+#ifndef P3_HISTOGRAM_H
+#define P3_HISTOGRAM_H
+
+#include <stdint.h>
+#include "helper.h"
+
+// declare enumeration for constants of the histograms
+// values below 32 have a bucket each, and every power of 2 above that is split into 32 buckets, so a bucket is at
+// most 1/32 of its values wide, and values of 2^40 (more than 18 minutes of nanoseconds) or more share the last bucket
+typedef enum histogram_constant {
+    HISTOGRAM_SUB_BITS = 5,
+    HISTOGRAM_SUB_BUCKETS = 32,
+    HISTOGRAM_MAX_BITS = 40,
+    HISTOGRAM_BUCKETS = (HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS,
+} histogram_constant;
+
+// define struct for a log-linear histogram of values, which one thread records into and any thread can read
+// recording a value takes a few instructions and no lock, and histograms of different threads are merged when read
+typedef struct histogram {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[HISTOGRAM_BUCKETS];
+} histogram;
+
+// prototypes of all functions
+void histogram_record(histogram *h, uint64_t value);
+void histogram_merge(histogram *into, const histogram *from);
+uint64_t histogram_get_percentile(const histogram *h, double percentile);
+
+#endif //P3_HISTOGRAM_H
@@ -0,0 +1,472 @@
+#ifndef P3_LEGACY_H
+#define P3_LEGACY_H
+
+#include <poll.h>
+#include "msg.h"
+
+// the way the server parsed messages, kept its board and its player names, and polled its sockets before each of them
+// was replaced, which ./bench measures the replacements against and ./test checks them against
+
+// global variables for the player names the way the server kept them before the set of player names
+static size_t number_of_legacy_players = 0;
+static char **legacy_player_names = NULL;
+
+// prototypes for all functions
+size_t legacy_is_complete_msg(const char *msg_buffer, size_t *max_index);
+ssize_t legacy_parse_play(const char *msg, char **player_name);
+ssize_t legacy_parse_move(const char *msg, char *role, size_t *row, size_t *col);
+ssize_t legacy_parse_rsgn(const char *msg);
+ssize_t legacy_parse_draw(const char *msg, char *action);
+ssize_t legacy_get_game_status(const char *board, char *status, char *winner);
+ssize_t legacy_make_move(char *board, char role, size_t row, size_t col);
+size_t legacy_add_player_name(const char *player_name);
+void legacy_remove_player_name(const char *player_name);
+size_t legacy_is_player_name_taken(const char *player_name);
+ssize_t legacy_get_readable_socket(const int *sockets, size_t number_of_sockets, int timeout);
+
+// function that checks whether given buffer contains a complete message the way msg.h did before parse_frame()
+// it runs check_protocol() once per code, and get_remaining_bytes() and check_num_of_bars() tokenize the buffer again
+size_t legacy_is_complete_msg(const char *msg_buffer, size_t *max_index) {
+    // input validation
+    if (msg_buffer == NULL || max_index == NULL) {
+        return 0;
+    }
+    // no complete message if length of buffer is less than minimum number of bytes required for complete message
+    if (strlen(msg_buffer) < 7) {
+        return 0;
+    }
+
+    size_t remaining_bytes = 0;
+    size_t num_of_digits = 0;
+
+    // check if number of bars is correct based on protocol and is within number of specified bytes
+    if (check_protocol(msg_buffer, "PLAY") == 1) {
+        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
+            return 0;
+        } else {
+            if (check_num_of_bars(msg_buffer, "PLAY", &remaining_bytes, &num_of_digits, max_index) == 0) {
+                return 0;
+            } else {
+                return 1;
+            }
+        }
+    } else if (check_protocol(msg_buffer, "MOVE") == 1) {
+        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
+            return 0;
+        } else {
+            if (check_num_of_bars(msg_buffer, "MOVE", &remaining_bytes, &num_of_digits, max_index) == 0) {
+                return 0;
+            } else {
+                return 1;
+            }
+        }
+    } else if (check_protocol(msg_buffer, "RSGN") == 1) {
+        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
+            return 0;
+        } else {
+            if (check_num_of_bars(msg_buffer, "RSGN", &remaining_bytes, &num_of_digits, max_index) == 0) {
+                return 0;
+            } else {
+                return 1;
+            }
+        }
+    } else if (check_protocol(msg_buffer, "DRAW") == 1) {
+        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
+            return 0;
+        } else {
+            if (check_num_of_bars(msg_buffer, "DRAW", &remaining_bytes, &num_of_digits, max_index) == 0) {
+                return 0;
+            } else {
+                return 1;
+            }
+        }
+    } else if (check_protocol(msg_buffer, "WAIT") == 1) {
+        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
+            return 0;
+        } else {
+            if (check_num_of_bars(msg_buffer, "WAIT", &remaining_bytes, &num_of_digits, max_index) == 0) {
+                return 0;
+            } else {
+                return 1;
+            }
+        }
+    } else if (check_protocol(msg_buffer, "BEGN") == 1) {
+        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
+            return 0;
+        } else {
+            if (check_num_of_bars(msg_buffer, "BEGN", &remaining_bytes, &num_of_digits, max_index) == 0) {
+                return 0;
+            } else {
+                return 1;
+            }
+        }
+    } else if (check_protocol(msg_buffer, "MOVD") == 1) {
+        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
+            return 0;
+        } else {
+            if (check_num_of_bars(msg_buffer, "MOVD", &remaining_bytes, &num_of_digits, max_index) == 0) {
+                return 0;
+            } else {
+                return 1;
+            }
+        }
+    } else if (check_protocol(msg_buffer, "OVER") == 1) {
+        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
+            return 0;
+        } else {
+            if (check_num_of_bars(msg_buffer, "OVER", &remaining_bytes, &num_of_digits, max_index) == 0) {
+                return 0;
+            } else {
+                return 1;
+            }
+        }
+    } else if (check_protocol(msg_buffer, "INVL") == 1) {
+        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
+            return 0;
+        } else {
+            if (check_num_of_bars(msg_buffer, "INVL", &remaining_bytes, &num_of_digits, max_index) == 0) {
+                return 0;
+            } else {
+                return 1;
+            }
+        }
+    } else {
+        return 0;
+    }
+}
+
+// function that decodes a PLAY message the way the server did before decode_message()
+ssize_t legacy_parse_play(const char *msg, char **player_name) {
+    // input validation
+    if (msg == NULL || player_name == NULL || strlen(msg) == 0) {
+        return -1;
+    }
+
+    // check if protocol given is play message
+    if (check_protocol(msg, "PLAY") == 0) {
+        return -1;
+    }
+
+    // tokenize the message
+    size_t num_of_tokens = 0;
+    char **tokens = strTokenize(msg, "|", &num_of_tokens, "");
+    if (tokens == NULL || num_of_tokens == 0) {
+        return -1;
+    }
+
+    // the server used to read past the tokens when the name was empty, which crashed it
+    if (num_of_tokens < 3) {
+        freeArrayOfStrings(tokens, num_of_tokens);
+        return -1;
+    }
+
+    // write name field to player name
+    *player_name = strdup(tokens[2]);
+
+    // free tokens
+    freeArrayOfStrings(tokens, num_of_tokens);
+
+    return 0;
+}
+
+// function that decodes a MOVE message the way the server did before decode_message()
+ssize_t legacy_parse_move(const char *msg, char *role, size_t *row, size_t *col) {
+    // input validation
+    if (msg == NULL || role == NULL || row == NULL || col == NULL || strlen(msg) == 0) {
+        return -1;
+    }
+
+    // check if protocol given is move message
+    if (check_protocol(msg, "MOVE") == 0) {
+        return -1;
+    }
+
+    // tokenize the message
+    size_t num_of_tokens = 0;
+    char **tokens = strTokenize(msg, "|", &num_of_tokens, "");
+    if (tokens == NULL || num_of_tokens == 0) {
+        return -1;
+    }
+
+    if (num_of_tokens != 4) {
+        freeArrayOfStrings(tokens, num_of_tokens);
+        return -1;
+    }
+
+    // write to role
+    if ((strcmp(tokens[2], "X") != 0) && (strcmp(tokens[2], "O") != 0)) {
+        freeArrayOfStrings(tokens, num_of_tokens);
+        return -1;
+    } else {
+        *role = tokens[2][0];
+    }
+
+    size_t num_of_tokens_comma = 0;
+    char **tokens_comma = strTokenize(tokens[3], ",", &num_of_tokens, "");
+    if (tokens_comma == NULL) {
+        freeArrayOfStrings(tokens, num_of_tokens);
+        return -1;
+    }
+    if (num_of_tokens != 2) {
+        freeArrayOfStrings(tokens_comma, num_of_tokens_comma);
+        freeArrayOfStrings(tokens, num_of_tokens);
+        return -1;
+    }
+
+    // extract the row and col
+    if (to_unsigned_long(tokens_comma[0], row) == -1) {
+        freeArrayOfStrings(tokens_comma, num_of_tokens_comma);
+        freeArrayOfStrings(tokens, num_of_tokens);
+        return -1;
+    }
+
+    if (*row < 1 || *row > 3) {
+        freeArrayOfStrings(tokens_comma, num_of_tokens_comma);
+        freeArrayOfStrings(tokens, num_of_tokens);
+        return -1;
+    }
+
+    *row -= 1;
+
+    if (to_unsigned_long(tokens_comma[1], col) == -1) {
+        freeArrayOfStrings(tokens_comma, num_of_tokens_comma);
+        freeArrayOfStrings(tokens, num_of_tokens);
+        return -1;
+    }
+
+    if (*col < 1 || *col > 3) {
+        freeArrayOfStrings(tokens_comma, num_of_tokens_comma);
+        freeArrayOfStrings(tokens, num_of_tokens);
+        return -1;
+    }
+
+    *col -= 1;
+
+    freeArrayOfStrings(tokens_comma, num_of_tokens_comma);
+    freeArrayOfStrings(tokens, num_of_tokens);
+
+    return 0;
+}
+
+// function that decodes a RSGN message the way the server did before decode_message()
+ssize_t legacy_parse_rsgn(const char *msg) {
+    // input validation
+    if (msg == NULL || strlen(msg) == 0) {
+        return -1;
+    }
+
+    // check if protocol given is rsgn message
+    if (check_protocol(msg, "RSGN") == 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+// function that decodes a DRAW message the way the server did before decode_message()
+ssize_t legacy_parse_draw(const char *msg, char *action) {
+    // input validation
+    if (msg == NULL || strlen(msg) == 0) {
+        return -1;
+    }
+
+    // check if protocol given is draw message
+    if (check_protocol(msg, "DRAW") == 0) {
+        return -1;
+    }
+
+    // tokenize the message
+    size_t num_of_tokens = 0;
+    char **tokens = strTokenize(msg, "|", &num_of_tokens, "");
+    if (tokens == NULL || num_of_tokens == 0) {
+        return -1;
+    }
+
+    if (num_of_tokens != 3) {
+        freeArrayOfStrings(tokens, num_of_tokens);
+        return -1;
+    }
+
+    if ((strcmp(tokens[2], "S") != 0) && (strcmp(tokens[2], "R") != 0) && (strcmp(tokens[2], "A") != 0)) {
+        freeArrayOfStrings(tokens, num_of_tokens);
+        return -1;
+    }
+
+    *action = tokens[2][0];
+
+    freeArrayOfStrings(tokens, num_of_tokens);
+    return 0;
+}
+
+// function that writes the status of the game ("W" or "D" or "N") and the winner ("X" or "O") the way the server did
+// before the board became a bitboard
+// returns -1 on error, 0 on success
+ssize_t legacy_get_game_status(const char *board, char *status, char *winner) {
+    // input validation
+    if (board == NULL || status == NULL || winner == NULL || strlen(board) != 9) {
+        return -1;
+    }
+
+    // check if there is a winner horizontally
+    for (size_t i = 0; i < 9; i += 3) {
+        // make sure none of the spaces have a period (empty space)
+        if (board[i] != '.' && board[i] == board[i + 1] && board[i] == board[i + 2]) {
+            *status = 'W';
+            *winner = board[i];
+            return 0;
+        }
+    }
+
+    // check if there is a winner vertically
+    for (size_t i = 0; i < 3; i++) {
+        // make sure none of the spaces have a period (empty space)
+        if (board[i] != '.' && board[i] == board[i + 3] && board[i] == board[i + 6]) {
+            *status = 'W';
+            *winner = board[i];
+            return 0;
+        }
+    }
+
+    // check if there is a winner diagonally
+    if (board[0] != '.' && board[0] == board[4] && board[0] == board[8]) {
+        *status = 'W';
+        *winner = board[0];
+        return 0;
+    }
+    if (board[2] != '.' && board[2] == board[4] && board[2] == board[6]) {
+        *status = 'W';
+        *winner = board[2];
+        return 0;
+    }
+
+    // check if there is a draw
+    for (size_t i = 0; i < 9; i++) {
+        // if there is an empty space, then there is no draw
+        if (board[i] == '.') {
+            *status = 'N';
+            *winner = '.';
+            return 0;
+        }
+    }
+
+    // if there is no winner and no empty spaces, then there is a draw
+    *status = 'D';
+    *winner = '.';
+    return 0;
+}
+
+// function that makes a move on the board the way the server did before the board became a bitboard
+// returns -1 on error, 0 on success
+ssize_t legacy_make_move(char *board, char role, size_t row, size_t col) {
+    // input validation
+    if (board == NULL || strlen(board) != 9) {
+        return -1;
+    }
+
+    // check role
+    if (role != 'X' && role != 'O') {
+        return -1;
+    }
+
+    // check row and col
+    if (row > 2 || col > 2) {
+        return -1;
+    }
+
+    // check if the space is empty
+    if (board[row * 3 + col] != '.') {
+        return -1;
+    }
+
+    // make the move
+    board[row * 3 + col] = role;
+
+    return 0;
+}
+
+// function that adds a player's name to the list of names unless it is taken, the way the server did before the set
+// of player names, without the lock that every call took
+// returns 1 if the name is taken and 0 if it was added
+size_t legacy_add_player_name(const char *player_name) {
+    if (legacy_is_player_name_taken(player_name) == 1) {
+        return 1;
+    }
+
+    // if there is a NULL pointer in the array, replace it with the player name to save space
+    for (size_t i = 0; i < number_of_legacy_players; i++) {
+        if (legacy_player_names[i] == NULL) {
+            legacy_player_names[i] = strdup(player_name);
+            return 0;
+        }
+    }
+
+    number_of_legacy_players++;
+    char **temp = realloc(legacy_player_names, sizeof(char *) * number_of_legacy_players);
+    if (temp == NULL) {
+        perror("realloc");
+        exit(EXIT_FAILURE);
+    }
+    legacy_player_names = temp;
+    legacy_player_names[number_of_legacy_players - 1] = strdup(player_name);
+    return 0;
+}
+
+// function that removes a player's name from the list of names the way the server did before the set of player names
+void legacy_remove_player_name(const char *player_name) {
+    if (player_name == NULL || strlen(player_name) == 0) {
+        return;
+    }
+    for (size_t i = 0; i < number_of_legacy_players; i++) {
+        if (legacy_player_names[i] != NULL && strcmp(legacy_player_names[i], player_name) == 0) {
+            legacy_player_names[i] = Free(legacy_player_names[i]);
+            break;
+        }
+    }
+}
+
+// function that checks if a player's name is in the list of names the way the server did before the set of player
+// names, by comparing it with every name
+size_t legacy_is_player_name_taken(const char *player_name) {
+    if (player_name == NULL || strlen(player_name) == 0) {
+        return 1;
+    }
+    for (size_t i = 0; i < number_of_legacy_players; i++) {
+        if (legacy_player_names[i] != NULL && strcmp(legacy_player_names[i], player_name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// function that polls the given list of sockets and returns the index of the socket that has data to be read, the way
+// the server did before the readiness set, with a pollfd array allocated for every call
+// returns -1 on error or poll timed out (in milliseconds)
+ssize_t legacy_get_readable_socket(const int *sockets, size_t number_of_sockets, int timeout) {
+    if (sockets == NULL || number_of_sockets == 0) {
+        return -1;
+    }
+    struct pollfd *poll_sockets = calloc(number_of_sockets, sizeof(struct pollfd));
+    if (poll_sockets == NULL) {
+        return -1;
+    }
+    for (size_t i = 0; i < number_of_sockets; i++) {
+        poll_sockets[i].fd = sockets[i];
+        poll_sockets[i].events = POLLIN;
+    }
+    if (poll(poll_sockets, number_of_sockets, timeout) <= 0) {
+        Free(poll_sockets);
+        return -1;
+    }
+
+    // the lowest ready index always wins
+    for (size_t i = 0; i < number_of_sockets; i++) {
+        if (poll_sockets[i].revents & POLLIN) {
+            Free(poll_sockets);
+            return (ssize_t) i;
+        }
+    }
+    Free(poll_sockets);
+    return -1;
+}
+
+#endif //P3_LEGACY_H
@@ -0,0 +1,950 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <time.h>
+#include <inttypes.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "msg.h"
+#include "timer.h"
+#include "histogram.h"
+
+// declare enumeration for constants of the load generator
+typedef enum loadgen_constant {
+    DEFAULT_PLAYERS = 1000,
+    DEFAULT_THREADS = 2,
+    DEFAULT_DURATION = 10,
+    MAX_PLAYERS = 1000000,
+    MAX_THREADS = 256,
+    MAX_THINK_TIME = 60000,
+    PLAYER_INPUT_SIZE = 256,
+    PLAYER_NAME_SIZE = 32,
+    MOVE_LENGTH = 13,
+    TIMER_THINK = 0,
+    CONNECT_BACKOFF = 10,
+    MAX_CONNECT_BACKOFF = 1000,
+    MAX_CONNECT_ROUNDS = 10,
+} loadgen_constant;
+
+// declare enumeration for the states of a simulated player
+// a finished player has received OVER and waits for the server to close the connection, so the server (and not the
+// load generator) keeps the TIME_WAIT of the connection and the ports of the load generator are never used up
+typedef enum player_state {
+    PLAYER_IDLE = 0,
+    PLAYER_CONNECTING = 1,
+    PLAYER_HANDSHAKE = 2,
+    PLAYER_WAITING = 3,
+    PLAYER_PLAYING = 4,
+    PLAYER_FINISHED = 5,
+} player_state;
+
+// declare enumeration for how a player picks its next move
+typedef enum move_strategy {
+    STRATEGY_RANDOM = 0,
+    STRATEGY_FIRST = 1,
+    STRATEGY_GREEDY = 2,
+} move_strategy;
+
+// declare enumeration for the latencies that the load generator measures, each from a message it sends to the
+// response it waits for, in the order they are reported
+typedef enum latency_kind {
+    LATENCY_PLAY = 0,
+    LATENCY_PAIRING = 1,
+    LATENCY_MOVE = 2,
+    LATENCY_INVALID = 3,
+    LATENCY_DRAW = 4,
+    LATENCY_RESIGN = 5,
+    NUMBER_OF_LATENCIES = 6,
+    LATENCY_NONE = 6,
+} latency_kind;
+
+// declare enumeration for the counters of the load generator, in the order they are reported
+typedef enum load_counter {
+    COUNT_CONNECTIONS = 0,
+    COUNT_GAMES = 1,
+    COUNT_MOVES = 2,
+    COUNT_INVALID_MOVES = 3,
+    COUNT_DRAW_OFFERS = 4,
+    COUNT_DRAWS = 5,
+    COUNT_RESIGNS = 6,
+    COUNT_MESSAGES_SENT = 7,
+    COUNT_MESSAGES_RECEIVED = 8,
+    COUNT_BYTES_SENT = 9,
+    COUNT_BYTES_RECEIVED = 10,
+    COUNT_ERRORS = 11,
+    COUNT_CONNECT_FAILURES = 12,
+    NUMBER_OF_COUNTERS = 13,
+} load_counter;
+
+// define struct for the options of the load generator
+// the shares of resign, draw and invalid traffic are the percentages of turns that send RSGN, offer a draw, or move
+// onto an occupied space instead of making a move, and may be fractions of a percent
+typedef struct load_config {
+    const char *host;
+    const char *port;
+    size_t number_of_players;
+    size_t number_of_threads;
+    size_t arrival_rate;
+    size_t duration;
+    size_t think_time;
+    move_strategy strategy;
+    double resign_share;
+    double draw_share;
+    double invalid_share;
+    const char *json_path;
+    struct sockaddr_storage address;
+    socklen_t address_length;
+} load_config;
+
+// define struct for a simulated player, which reconnects as a new player once its game is over
+// the board holds 'X', 'O' or '.' for each space, the way the server sends it in MOVD
+typedef struct player {
+    int socket;
+    size_t number;
+    size_t generation;
+    player_state state;
+    char role;
+    char board[9];
+    latency_kind pending;
+    uint64_t sent_at;
+    timer think_timer;
+    struct player *next_idle;
+    size_t input_length;
+    char input[PLAYER_INPUT_SIZE + 1];
+} player;
+
+// define struct for the counters and latencies of a thread, which only that thread writes until it has finished
+typedef struct load_stats {
+    uint64_t counters[NUMBER_OF_COUNTERS];
+    histogram latencies[NUMBER_OF_LATENCIES];
+} load_stats;
+
+// define struct for a thread of the load generator, which drives its share of the players from one event loop
+// after a connection fails, no player arrives until retry_at, and the wait doubles with each round of failures
+typedef struct load_thread {
+    pthread_t thread;
+    size_t index;
+    const load_config *config;
+    size_t number_of_players;
+    player *players;
+    player *idle_players;
+    size_t number_of_arrivals;
+    long started_at;
+    uint64_t random_state;
+    size_t connect_rounds;
+    long retry_at;
+    int connect_error;
+    readiness_set readiness;
+    timer_wheel timers;
+    load_stats stats;
+} load_thread;
+
+// prototypes of all functions
+void parse_arguments(int argc, char **argv, load_config *config);
+ssize_t parse_number(const char *str, size_t *number);
+ssize_t parse_share(const char *str, double *share);
+void print_usage();
+void resolve_server(load_config *config);
+void raise_file_limit();
+void* run_thread(void *arg);
+void start_arrivals(load_thread *t, long now);
+int get_event_timeout(load_thread *t, long now, long ends_at);
+ssize_t start_player(load_thread *t, player *p);
+void finish_connect(load_thread *t, player *p);
+void fail_connect(load_thread *t, player *p, int error);
+void read_player(load_thread *t, player *p);
+void handle_message(load_thread *t, player *p, const char *msg, const frame *view);
+void schedule_turn(load_thread *t, player *p);
+void take_turn(load_thread *t, player *p);
+size_t pick_space(load_thread *t, const player *p);
+ssize_t find_line(const char *board, char role);
+ssize_t send_frame(load_thread *t, player *p, const char *bytes, size_t length, latency_kind pending);
+void record_latency(load_thread *t, player *p, latency_kind kind);
+void close_player(load_thread *t, player *p, size_t is_error);
+uint64_t get_random(load_thread *t);
+void merge_stats(load_stats *into, const load_stats *from);
+void print_report(const load_config *config, const load_stats *stats, double elapsed);
+void write_json_report(const load_config *config, const load_stats *stats, double elapsed);
+
+// global variables for the names of the counters and the latencies in the reports
+static const char *const COUNTER_NAMES[NUMBER_OF_COUNTERS] = {
+        "connections", "games", "moves", "invalid_moves", "draw_offers", "draws", "resigns", "messages_sent",
+        "messages_received", "bytes_sent", "bytes_received", "errors", "connect_failures"};
+static const char *const LATENCY_NAMES[NUMBER_OF_LATENCIES] = {"play", "pairing", "move", "invalid", "draw", "resign"};
+static const char *const LATENCY_LABELS[NUMBER_OF_LATENCIES] = {
+        "PLAY -> WAIT", "WAIT -> BEGN", "MOVE -> MOVD", "MOVE -> INVL", "DRAW -> DRAW", "RSGN -> OVER"};
+
+// global variable for the percentiles of the latencies that are reported
+static const double PERCENTILES[] = {50.0, 90.0, 99.0, 99.9};
+static const char *const PERCENTILE_NAMES[] = {"p50", "p90", "p99", "p999"};
+
+// global variable for the barrier that every thread waits at once the duration is over, so no thread closes its
+// players while the opponents of those players are still playing on another thread
+static pthread_barrier_t end_barrier;
+
+// global variable for whether a thread has given up on connecting to the server, which ends every thread
+static size_t is_unreachable = 0;
+
+// global variable for the 8 lines of the board, as the indexes of their spaces
+static const size_t LINES[8][3] = {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}, {0, 3, 6}, {1, 4, 7}, {2, 5, 8}, {0, 4, 8},
+                                   {2, 4, 6}};
+
+// driver
+int main(int argc, char **argv) {
+    // set stdout and stderr buffer to NULL
+    setbuf(stdout, NULL);
+    setbuf(stderr, NULL);
+
+    // check if the arguments are correct and look up the server once for every connection
+    load_config config;
+    parse_arguments(argc, argv, &config);
+    resolve_server(&config);
+    raise_file_limit();
+
+    // split the players between the threads, and start each thread with its own event loop
+    load_thread *threads = calloc(config.number_of_threads, sizeof(load_thread));
+    if (threads == NULL) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    if (pthread_barrier_init(&end_barrier, NULL, config.number_of_threads) != 0) {
+        perror("pthread_barrier_init");
+        exit(EXIT_FAILURE);
+    }
+    long started_at = get_time_in_ms();
+    for (size_t i = 0; i < config.number_of_threads; i++) {
+        threads[i].index = i;
+        threads[i].config = &config;
+        threads[i].number_of_players = config.number_of_players / config.number_of_threads +
+                                       (i < config.number_of_players % config.number_of_threads);
+        threads[i].started_at = started_at;
+        if (pthread_create(&threads[i].thread, NULL, run_thread, &threads[i]) != 0) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // wait for every thread, then sum their counters and latencies
+    load_stats *stats = calloc(1, sizeof(load_stats));
+    if (stats == NULL) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < config.number_of_threads; i++) {
+        if (pthread_join(threads[i].thread, NULL) != 0) {
+            perror("pthread_join");
+            exit(EXIT_FAILURE);
+        }
+        merge_stats(stats, &threads[i].stats);
+    }
+    double elapsed = (get_time_in_ms() - started_at) / 1000.0;
+
+    print_report(&config, stats, elapsed);
+    if (config.json_path != NULL) {
+        write_json_report(&config, stats, elapsed);
+    }
+
+    // a failed connection is reported once for the whole run, with the error of the last one
+    int connect_error = 0;
+    for (size_t i = 0; i < config.number_of_threads; i++) {
+        connect_error = threads[i].connect_error != 0 ? threads[i].connect_error : connect_error;
+    }
+    if (stats->counters[COUNT_CONNECT_FAILURES] > 0) {
+        fprintf(stderr, "loadgen: %" PRIu64 " connections to %s:%s failed, the last with: %s\n",
+                stats->counters[COUNT_CONNECT_FAILURES], config.host, config.port, strerror(connect_error));
+    }
+    size_t has_given_up = __atomic_load_n(&is_unreachable, __ATOMIC_RELAXED);
+    if (has_given_up == 1) {
+        fprintf(stderr, "loadgen: gave up after %d rounds of failed connections\n", MAX_CONNECT_ROUNDS);
+    }
+
+    pthread_barrier_destroy(&end_barrier);
+    stats = Free(stats);
+    threads = Free(threads);
+
+    // exit the program successfully, unless the server could not be reached
+    return has_given_up == 1 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// function that checks if the arguments are correct and fills in the config
+// usage: ./loadgen [-a arrivals per second] [-c players] [-d seconds] [-i invalid %] [-j json file] [-k think time]
+//                  [-m random|first|greedy] [-o draw %] [-r resign %] [-t threads] <host> <port>
+void parse_arguments(int argc, char **argv, load_config *config) {
+    // set the default options
+    memset(config, 0, sizeof(load_config));
+    config->number_of_players = DEFAULT_PLAYERS;
+    config->number_of_threads = DEFAULT_THREADS;
+    config->duration = DEFAULT_DURATION;
+    config->strategy = STRATEGY_RANDOM;
+
+    // parse the options
+    int option;
+    while ((option = getopt(argc, argv, "a:c:d:i:j:k:m:o:r:t:")) != -1) {
+        ssize_t result = 0;
+        switch (option) {
+            case 'a':
+                result = parse_number(optarg, &config->arrival_rate);
+                break;
+            case 'c':
+                result = parse_number(optarg, &config->number_of_players);
+                if (config->number_of_players == 0 || config->number_of_players > MAX_PLAYERS) {
+                    result = -1;
+                }
+                break;
+            case 'd':
+                result = parse_number(optarg, &config->duration);
+                if (config->duration == 0) {
+                    result = -1;
+                }
+                break;
+            case 'i':
+                result = parse_share(optarg, &config->invalid_share);
+                break;
+            case 'j':
+                config->json_path = optarg;
+                break;
+            case 'k':
+                result = parse_number(optarg, &config->think_time);
+                if (config->think_time > MAX_THINK_TIME) {
+                    result = -1;
+                }
+                break;
+            case 'm':
+                if (strcmp(optarg, "random") == 0) {
+                    config->strategy = STRATEGY_RANDOM;
+                } else if (strcmp(optarg, "first") == 0) {
+                    config->strategy = STRATEGY_FIRST;
+                } else if (strcmp(optarg, "greedy") == 0) {
+                    config->strategy = STRATEGY_GREEDY;
+                } else {
+                    result = -1;
+                }
+                break;
+            case 'o':
+                result = parse_share(optarg, &config->draw_share);
+                break;
+            case 'r':
+                result = parse_share(optarg, &config->resign_share);
+                break;
+            case 't':
+                result = parse_number(optarg, &config->number_of_threads);
+                if (config->number_of_threads == 0 || config->number_of_threads > MAX_THREADS) {
+                    result = -1;
+                }
+                break;
+            default:
+                result = -1;
+                break;
+        }
+        if (result == -1) {
+            print_usage();
+        }
+    }
+
+    // the shares of the turns cannot add up to more than every turn, and every thread needs a player
+    if (config->resign_share + config->draw_share + config->invalid_share > 100 ||
+        config->number_of_threads > config->number_of_players) {
+        print_usage();
+    }
+
+    // check if the number of arguments is correct
+    if (optind != argc - 2) {
+        print_usage();
+    }
+    config->host = argv[optind];
+    config->port = argv[optind + 1];
+}
+
+// function that converts an option to a whole number, which must be nothing but decimal digits
+// returns -1 on error and 0 on success
+ssize_t parse_number(const char *str, size_t *number) {
+    if (str[0] < '0' || str[0] > '9') {
+        return -1;
+    }
+    char *end;
+    errno = 0;
+    unsigned long long converted = strtoull(str, &end, 10);
+    if (errno != 0 || *end != '\0') {
+        return -1;
+    }
+    *number = converted;
+    return 0;
+}
+
+// function that converts an option to a percentage from 0 to 100, which may have a fraction such as 0.1
+// returns -1 on error and 0 on success
+ssize_t parse_share(const char *str, double *share) {
+    if ((str[0] < '0' || str[0] > '9') && str[0] != '.') {
+        return -1;
+    }
+    char *end;
+    errno = 0;
+    double converted = strtod(str, &end);
+    if (errno != 0 || end == str || *end != '\0' || converted > 100) {
+        return -1;
+    }
+    *share = converted;
+    return 0;
+}
+
+// function that prints the usage of the load generator and exits
+void print_usage() {
+    const char *usage = "Usage: ./loadgen [-a arrivals per second] [-c players] [-d seconds] [-i invalid %] "
+                        "[-j json file] [-k think time] [-m random|first|greedy] [-o draw %] [-r resign %] "
+                        "[-t threads] <host> <port>\n";
+    if (write(STDERR_FILENO, usage, strlen(usage)) != strlen(usage)) {
+        perror("write");
+    }
+    exit(EXIT_FAILURE);
+}
+
+// function that looks up the address of the server once, so connecting a player never waits for a lookup
+void resolve_server(load_config *config) {
+    struct addrinfo hints;
+    struct addrinfo *info_list;
+    memset(&hints, 0, sizeof(struct addrinfo));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    int error = getaddrinfo(config->host, config->port, &hints, &info_list);
+    if (error != 0) {
+        fprintf(stderr, "getaddrinfo: %s\n", gai_strerror(error));
+        exit(EXIT_FAILURE);
+    }
+    memcpy(&config->address, info_list->ai_addr, info_list->ai_addrlen);
+    config->address_length = info_list->ai_addrlen;
+    freeaddrinfo(info_list);
+}
+
+// function that raises the limit on open files to the hard limit, so tens of thousands of players can connect
+void raise_file_limit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == -1) {
+        perror("getrlimit");
+        return;
+    }
+    if (limit.rlim_cur != limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &limit) == -1) {
+            perror("setrlimit");
+        }
+    }
+}
+
+// function that runs a thread of the load generator until the duration has passed
+// players arrive at the arrival rate (or all at once without one), play one game each, and arrive again as new
+// players once their game is over, so the number of players is the most that are connected at once
+void* run_thread(void *arg) {
+    load_thread *t = arg;
+    t->random_state = 0x9E3779B97F4A7C15ULL * (t->index + 1) ^ get_time_in_ns();
+    t->players = calloc(t->number_of_players, sizeof(player));
+    if (t->players == NULL) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    if (readiness_set_init(&t->readiness) == -1) {
+        perror("readiness_set_init");
+        exit(EXIT_FAILURE);
+    }
+    timer_wheel_init(&t->timers, t->started_at);
+
+    // every player starts out idle, and the first players in the list arrive first
+    for (size_t i = t->number_of_players; i > 0; i--) {
+        player *p = &t->players[i - 1];
+        p->socket = -1;
+        p->number = i - 1;
+        timer_init(&p->think_timer, TIMER_THINK, p);
+        p->next_idle = t->idle_players;
+        t->idle_players = p;
+    }
+
+    long ends_at = t->started_at + (long) t->config->duration * 1000;
+    while (1) {
+        long now = get_time_in_ms();
+        if (now >= ends_at || __atomic_load_n(&is_unreachable, __ATOMIC_RELAXED) == 1) {
+            break;
+        }
+
+        // start the players that have arrived, and take the turns of the players that have finished thinking
+        start_arrivals(t, now);
+        timer *expired;
+        while ((expired = timer_wheel_expire(&t->timers, now)) != NULL) {
+            take_turn(t, expired->owner);
+        }
+
+        int number_of_ready = wait_for_ready(&t->readiness, get_event_timeout(t, now, ends_at));
+        if (number_of_ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("wait_for_ready");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < number_of_ready; i++) {
+            player *p = t->readiness.ready[i].data.ptr;
+            if (p->state == PLAYER_CONNECTING) {
+                finish_connect(t, p);
+            } else if (p->state != PLAYER_IDLE) {
+                read_player(t, p);
+            }
+        }
+    }
+
+    // the games that are still going when the duration is over are not counted
+    pthread_barrier_wait(&end_barrier);
+    for (size_t i = 0; i < t->number_of_players; i++) {
+        if (t->players[i].socket != -1) {
+            close(t->players[i].socket);
+        }
+    }
+    close(t->readiness.event_loop);
+    t->players = Free(t->players);
+    return NULL;
+}
+
+// function that starts as many idle players as have arrived since the thread started
+// an arrival waits for an idle player if every player of the thread is connected, and no player arrives while the
+// thread backs off after a failed connection, so a server that is down does not keep the thread in this loop
+void start_arrivals(load_thread *t, long now) {
+    const load_config *config = t->config;
+    while (t->idle_players != NULL && now >= t->retry_at) {
+        if (config->arrival_rate > 0 &&
+            (double) t->number_of_arrivals * config->number_of_threads * 1000 / config->arrival_rate >
+            now - t->started_at) {
+            break;
+        }
+        player *p = t->idle_players;
+        t->idle_players = p->next_idle;
+        t->number_of_arrivals++;
+        if (start_player(t, p) == -1) {
+            break;
+        }
+    }
+}
+
+// function that returns how long the thread may wait for its sockets before it has a turn to take, a player to start
+// or the duration is over
+int get_event_timeout(load_thread *t, long now, long ends_at) {
+    long timeout = ends_at - now;
+    long wheel_timeout = timer_wheel_get_timeout(&t->timers, now);
+    if (wheel_timeout != -1 && wheel_timeout < timeout) {
+        timeout = wheel_timeout;
+    }
+    if (t->idle_players != NULL && (t->config->arrival_rate > 0 || t->retry_at > now)) {
+        long next_arrival = t->retry_at;
+        if (t->config->arrival_rate > 0) {
+            long scheduled = t->started_at + (long) ((double) t->number_of_arrivals * t->config->number_of_threads *
+                                                     1000 / t->config->arrival_rate);
+            next_arrival = scheduled > next_arrival ? scheduled : next_arrival;
+        }
+        if (next_arrival - now < timeout) {
+            timeout = next_arrival > now ? next_arrival - now : 0;
+        }
+    }
+    return timeout > INT_MAX ? INT_MAX : (int) timeout;
+}
+
+// function that connects a new player to the server without waiting for the connection to be established
+// returns -1 on error and 0 on success
+ssize_t start_player(load_thread *t, player *p) {
+    const load_config *config = t->config;
+    p->socket = socket(config->address.ss_family, SOCK_STREAM, IPPROTO_TCP);
+    if (p->socket == -1) {
+        perror("socket");
+        close_player(t, p, 1);
+        return -1;
+    }
+    if (set_socket_nonblocking(p->socket) == -1) {
+        perror("set_socket_nonblocking");
+        close_player(t, p, 1);
+        return -1;
+    }
+
+    // a player sends one small message at a time, which must not wait for the acknowledgement of the one before it
+    int is_enabled = 1;
+    if (setsockopt(p->socket, IPPROTO_TCP, TCP_NODELAY, &is_enabled, sizeof(is_enabled)) == -1) {
+        perror("setsockopt");
+    }
+    if (connect(p->socket, (const struct sockaddr *) &config->address, config->address_length) == -1 &&
+        errno != EINPROGRESS) {
+        fail_connect(t, p, errno);
+        return -1;
+    }
+
+    // the socket is writable once the connection is established or has failed
+    if (watch_socket(t->readiness.event_loop, p->socket, p) == -1 ||
+        rewatch_socket(t->readiness.event_loop, p->socket, p, 0, 1) == -1) {
+        perror("watch_socket");
+        close_player(t, p, 1);
+        return -1;
+    }
+    p->state = PLAYER_CONNECTING;
+    p->generation++;
+    p->input_length = 0;
+    p->input[0] = '\0';
+    p->pending = LATENCY_NONE;
+    t->stats.counters[COUNT_CONNECTIONS]++;
+    return 0;
+}
+
+// function that sends PLAY once the connection of the player is established, and watches it for input from then on
+void finish_connect(load_thread *t, player *p) {
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(p->socket, SOL_SOCKET, SO_ERROR, &error, &length) == -1) {
+        error = errno;
+    }
+    if (error != 0) {
+        fail_connect(t, p, error);
+        return;
+    }
+    t->connect_rounds = 0;
+    if (rewatch_socket(t->readiness.event_loop, p->socket, p, 1, 0) == -1) {
+        perror("rewatch_socket");
+        close_player(t, p, 1);
+        return;
+    }
+
+    // the name of a player is unique among the players that are connected at once
+    char name[PLAYER_NAME_SIZE];
+    int name_length = snprintf(name, sizeof(name), "t%zu-%zu-%zu", t->index, p->number, p->generation);
+    char play[PLAYER_NAME_SIZE + 16];
+    int play_length = snprintf(play, sizeof(play), "PLAY|%d|%s|", name_length + 1, name);
+    p->state = PLAYER_HANDSHAKE;
+    send_frame(t, p, play, play_length, LATENCY_PLAY);
+}
+
+// function that closes a player whose connection failed, and backs off before the next player arrives
+// the failures of the connections that were started together are one round, and the wait doubles with each round,
+// up to MAX_CONNECT_BACKOFF, until every thread gives up after MAX_CONNECT_ROUNDS rounds without a connection
+void fail_connect(load_thread *t, player *p, int error) {
+    close_player(t, p, 0);
+    t->stats.counters[COUNT_CONNECT_FAILURES]++;
+    t->connect_error = error;
+    long now = get_time_in_ms();
+    if (now < t->retry_at) {
+        return;
+    }
+    t->connect_rounds++;
+    if (t->connect_rounds >= MAX_CONNECT_ROUNDS) {
+        __atomic_store_n(&is_unreachable, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    long backoff = (long) CONNECT_BACKOFF << (t->connect_rounds - 1);
+    t->retry_at = now + (backoff < MAX_CONNECT_BACKOFF ? backoff : MAX_CONNECT_BACKOFF);
+}
+
+// function that receives what has arrived for the player and handles every complete message
+// a player whose game is over closes its connection once the server has closed it
+void read_player(load_thread *t, player *p) {
+    ssize_t bytes_read = read(p->socket, p->input + p->input_length, PLAYER_INPUT_SIZE - p->input_length);
+    if (bytes_read == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return;
+    }
+    if (bytes_read <= 0) {
+        close_player(t, p, p->state != PLAYER_FINISHED);
+        return;
+    }
+    p->input_length += bytes_read;
+    p->input[p->input_length] = '\0';
+    t->stats.counters[COUNT_BYTES_RECEIVED] += bytes_read;
+
+    // take every complete message from the front of the input
+    frame view;
+    size_t offset = 0;
+    while (p->state != PLAYER_IDLE && parse_frame(p->input + offset, &view) == 1) {
+        t->stats.counters[COUNT_MESSAGES_RECEIVED]++;
+        handle_message(t, p, p->input + offset, &view);
+        offset += view.length;
+    }
+    if (p->state == PLAYER_IDLE) {
+        return;
+    }
+    memmove(p->input, p->input + offset, p->input_length - offset + 1);
+    p->input_length -= offset;
+
+    // an input that is full and does not start with a complete message can never hold one
+    if (p->input_length == PLAYER_INPUT_SIZE) {
+        fprintf(stderr, "loadgen: malformed message from the server\n");
+        close_player(t, p, 1);
+    }
+}
+
+// function that handles a message from the server according to the state of the player
+void handle_message(load_thread *t, player *p, const char *msg, const frame *view) {
+    const char *fields[MAX_FIELDS];
+    for (size_t i = 0; i < view->number_of_fields; i++) {
+        fields[i] = msg + view->field_offsets[i];
+    }
+
+    switch (view->code) {
+        case CODE_WAIT:
+            // the wait for an opponent is timed from the WAIT message to the BEGN message
+            record_latency(t, p, LATENCY_PLAY);
+            p->state = PLAYER_WAITING;
+            p->pending = LATENCY_PAIRING;
+            p->sent_at = get_time_in_ns();
+            return;
+        case CODE_BEGN:
+            record_latency(t, p, LATENCY_PAIRING);
+            p->state = PLAYER_PLAYING;
+            p->role = fields[0][0];
+            memset(p->board, '.', sizeof(p->board));
+            if (p->role == 'X') {
+                schedule_turn(t, p);
+            }
+            return;
+        case CODE_MOVD:
+            // the fields are the role that moved, its space and the board after the move
+            if (view->number_of_fields == 3 && view->field_lengths[2] == sizeof(p->board)) {
+                memcpy(p->board, fields[2], sizeof(p->board));
+            }
+            if (fields[0][0] == p->role) {
+                record_latency(t, p, LATENCY_MOVE);
+                t->stats.counters[COUNT_MOVES]++;
+            } else {
+                schedule_turn(t, p);
+            }
+            return;
+        case CODE_DRAW:
+            // a draw offer is accepted half of the time, and a rejected offer leaves the turn with the player
+            if (fields[0][0] == 'S') {
+                size_t is_accepted = get_random(t) % 2;
+                send_frame(t, p, is_accepted == 1 ? "DRAW|2|A|" : "DRAW|2|R|", 9, LATENCY_NONE);
+            } else if (fields[0][0] == 'R') {
+                record_latency(t, p, LATENCY_DRAW);
+                schedule_turn(t, p);
+            }
+            return;
+        case CODE_INVL:
+            // only a move onto an occupied space is expected to be invalid, and the turn stays with the player
+            if (p->pending == LATENCY_INVALID && strncmp(fields[0], "That space is occupied.", 23) == 0) {
+                record_latency(t, p, LATENCY_INVALID);
+                schedule_turn(t, p);
+                return;
+            }
+            fprintf(stderr, "loadgen: unexpected %s\n", msg);
+            close_player(t, p, 1);
+            return;
+        case CODE_OVER:
+            // every game ends with an OVER message to both players, so a game is counted by its X player
+            if (p->pending == LATENCY_DRAW || p->pending == LATENCY_RESIGN) {
+                record_latency(t, p, p->pending);
+            }
+            if (fields[0][0] == 'D' && strncmp(fields[1], "Both players", 12) == 0) {
+                t->stats.counters[COUNT_DRAWS] += p->role == 'X';
+            }
+            t->stats.counters[COUNT_GAMES] += p->role == 'X';
+            timer_cancel(&t->timers, &p->think_timer);
+            p->state = PLAYER_FINISHED;
+            return;
+        default:
+            fprintf(stderr, "loadgen: unexpected %s\n", msg);
+            close_player(t, p, 1);
+            return;
+    }
+}
+
+// function that gives the player its turn after the think time, which varies between half and one and a half times
+// the think time that was asked for
+void schedule_turn(load_thread *t, player *p) {
+    size_t think_time = t->config->think_time;
+    if (think_time == 0) {
+        take_turn(t, p);
+        return;
+    }
+    long delay = (long) (think_time / 2 + get_random(t) % (think_time + 1));
+    timer_arm(&t->timers, &p->think_timer, get_time_in_ms() + delay);
+}
+
+// function that takes the turn of the player, which resigns, offers a draw, moves onto an occupied space or makes a
+// move, by the shares of the config
+void take_turn(load_thread *t, player *p) {
+    if (p->state != PLAYER_PLAYING) {
+        return;
+    }
+    const load_config *config = t->config;
+    double roll = (double) get_random(t) / (1ULL << 53) * 100;
+    if (roll < config->resign_share) {
+        t->stats.counters[COUNT_RESIGNS]++;
+        send_frame(t, p, "RSGN|0|", 7, LATENCY_RESIGN);
+        return;
+    }
+    roll -= config->resign_share;
+    if (roll < config->draw_share) {
+        t->stats.counters[COUNT_DRAW_OFFERS]++;
+        send_frame(t, p, "DRAW|2|S|", 9, LATENCY_DRAW);
+        return;
+    }
+    roll -= config->draw_share;
+
+    // a move onto an occupied space needs a space that is occupied, so the first move of a game is always made
+    size_t space = pick_space(t, p);
+    latency_kind pending = LATENCY_MOVE;
+    if (roll < config->invalid_share && memchr(p->board, p->role == 'X' ? 'O' : 'X', sizeof(p->board)) != NULL) {
+        for (space = 0; p->board[space] == '.'; space++) {
+        }
+        t->stats.counters[COUNT_INVALID_MOVES]++;
+        pending = LATENCY_INVALID;
+    }
+    char move[MOVE_LENGTH + 1] = "MOVE|6|X|1,1|";
+    move[7] = p->role;
+    move[9] = (char) ('1' + space / 3);
+    move[11] = (char) ('1' + space % 3);
+    send_frame(t, p, move, MOVE_LENGTH, pending);
+}
+
+// function that picks an empty space for the next move of the player by the strategy of the config
+// the greedy strategy completes a line of its own, or else blocks a line of the opponent, or else moves at random
+size_t pick_space(load_thread *t, const player *p) {
+    if (t->config->strategy == STRATEGY_GREEDY) {
+        ssize_t space = find_line(p->board, p->role);
+        if (space == -1) {
+            space = find_line(p->board, p->role == 'X' ? 'O' : 'X');
+        }
+        if (space != -1) {
+            return space;
+        }
+    }
+    size_t number_of_empty = 0;
+    size_t empty[9];
+    for (size_t i = 0; i < sizeof(p->board); i++) {
+        if (p->board[i] == '.') {
+            empty[number_of_empty++] = i;
+        }
+    }
+    if (number_of_empty == 0) {
+        return 0;
+    }
+    if (t->config->strategy == STRATEGY_FIRST) {
+        return empty[0];
+    }
+    return empty[get_random(t) % number_of_empty];
+}
+
+// function that finds the empty space that completes a line of the given role
+// returns -1 if there is none and the index of the space otherwise
+ssize_t find_line(const char *board, char role) {
+    for (size_t i = 0; i < 8; i++) {
+        size_t taken = 0;
+        ssize_t empty = -1;
+        for (size_t j = 0; j < 3; j++) {
+            if (board[LINES[i][j]] == role) {
+                taken++;
+            } else if (board[LINES[i][j]] == '.') {
+                empty = LINES[i][j];
+            }
+        }
+        if (taken == 2 && empty != -1) {
+            return empty;
+        }
+    }
+    return -1;
+}
+
+// function that sends a message to the server for the player and starts timing the response it waits for
+// a message of the protocol is much smaller than the send buffer of a socket, so a short send is an error
+// returns -1 on error and 0 on success
+ssize_t send_frame(load_thread *t, player *p, const char *bytes, size_t length, latency_kind pending) {
+    ssize_t bytes_sent = send(p->socket, bytes, length, MSG_NOSIGNAL);
+    if (bytes_sent != (ssize_t) length) {
+        perror("send");
+        close_player(t, p, 1);
+        return -1;
+    }
+    t->stats.counters[COUNT_MESSAGES_SENT]++;
+    t->stats.counters[COUNT_BYTES_SENT] += length;
+    if (pending != LATENCY_NONE) {
+        p->pending = pending;
+        p->sent_at = get_time_in_ns();
+    }
+    return 0;
+}
+
+// function that records the latency of the response the player waited for, if it is the given kind of response
+void record_latency(load_thread *t, player *p, latency_kind kind) {
+    if (p->pending != kind) {
+        return;
+    }
+    histogram_record(&t->stats.latencies[kind], get_time_in_ns() - p->sent_at);
+    p->pending = LATENCY_NONE;
+}
+
+// function that closes the connection of the player, which becomes idle until it arrives again as a new player
+void close_player(load_thread *t, player *p, size_t is_error) {
+    if (p->socket != -1 && close(p->socket) == -1) {
+        perror("close");
+    }
+    timer_cancel(&t->timers, &p->think_timer);
+    p->socket = -1;
+    p->state = PLAYER_IDLE;
+    p->next_idle = t->idle_players;
+    t->idle_players = p;
+    t->stats.counters[COUNT_ERRORS] += is_error;
+}
+
+// function that returns the next number of the random number generator of the thread (xorshift64*)
+uint64_t get_random(load_thread *t) {
+    t->random_state ^= t->random_state >> 12;
+    t->random_state ^= t->random_state << 25;
+    t->random_state ^= t->random_state >> 27;
+    return (t->random_state * 0x2545F4914F6CDD1DULL) >> 11;
+}
+
+// function that adds the counters and latencies of a thread that has finished to the given stats
+void merge_stats(load_stats *into, const load_stats *from) {
+    for (size_t i = 0; i < NUMBER_OF_COUNTERS; i++) {
+        into->counters[i] += from->counters[i];
+    }
+    for (size_t i = 0; i < NUMBER_OF_LATENCIES; i++) {
+        histogram_merge(&into->latencies[i], &from->latencies[i]);
+    }
+}
+
+// function that prints the throughput and the latency percentiles (in microseconds) of the run
+void print_report(const load_config *config, const load_stats *stats, double elapsed) {
+    printf("loadgen: %zu players on %zu threads for %.1f s against %s:%s\n", config->number_of_players,
+           config->number_of_threads, elapsed, config->host, config->port);
+    for (size_t i = 0; i < NUMBER_OF_COUNTERS; i++) {
+        printf("%-18s %14" PRIu64 " %14.1f/s\n", COUNTER_NAMES[i], stats->counters[i], stats->counters[i] / elapsed);
+    }
+    printf("\n%-18s %10s %10s %10s %10s %10s %10s\n", "latency (us)", "count", "p50", "p90", "p99", "p99.9", "max");
+    for (size_t i = 0; i < NUMBER_OF_LATENCIES; i++) {
+        const histogram *h = &stats->latencies[i];
+        printf("%-18s %10" PRIu64, LATENCY_LABELS[i], h->count);
+        for (size_t j = 0; j < sizeof(PERCENTILES) / sizeof(PERCENTILES[0]); j++) {
+            printf(" %10.1f", histogram_get_percentile(h, PERCENTILES[j]) / 1e3);
+        }
+        printf(" %10.1f\n", h->max / 1e3);
+    }
+}
+
+// function that writes the report of the run as JSON to the file of the config, or to stdout if the file is "-"
+// the latencies are in nanoseconds
+void write_json_report(const load_config *config, const load_stats *stats, double elapsed) {
+    FILE *file = strcmp(config->json_path, "-") == 0 ? stdout : fopen(config->json_path, "w");
+    if (file == NULL) {
+        perror("fopen");
+        exit(EXIT_FAILURE);
+    }
+    fprintf(file, "{\"players\": %zu, \"threads\": %zu, \"arrival_rate\": %zu, \"think_time_ms\": %zu, "
+                  "\"seconds\": %.3f,\n \"counters\": {", config->number_of_players, config->number_of_threads,
+            config->arrival_rate, config->think_time, elapsed);
+    for (size_t i = 0; i < NUMBER_OF_COUNTERS; i++) {
+        fprintf(file, "%s\"%s\": %" PRIu64, i == 0 ? "" : ", ", COUNTER_NAMES[i], stats->counters[i]);
+    }
+    fprintf(file, "},\n \"games_per_second\": %.1f, \"moves_per_second\": %.1f,\n \"latencies_ns\": {",
+            stats->counters[COUNT_GAMES] / elapsed, stats->counters[COUNT_MOVES] / elapsed);
+    for (size_t i = 0; i < NUMBER_OF_LATENCIES; i++) {
+        const histogram *h = &stats->latencies[i];
+        fprintf(file, "%s\n  \"%s\": {\"count\": %" PRIu64, i == 0 ? "" : ",", LATENCY_NAMES[i], h->count);
+        for (size_t j = 0; j < sizeof(PERCENTILES) / sizeof(PERCENTILES[0]); j++) {
+            fprintf(file, ", \"%s\": %" PRIu64, PERCENTILE_NAMES[j], histogram_get_percentile(h, PERCENTILES[j]));
+        }
+        fprintf(file, ", \"max\": %" PRIu64 "}", h->max);
+    }
+    fprintf(file, "}}\n");
+    if (file != stdout && fclose(file) == EOF) {
+        perror("fclose");
+    }
+}
@@ -0,0 +1,300 @@
+#include "logger.h"
+
+// global variables for the rings of the threads that have logged and what a thread does when its ring is full
+// a ring is added once by its thread and never removed, and number_of_rings is only advanced after the ring is set
+static log_ring *rings[MAX_LOG_RINGS];
+static size_t number_of_rings = 0;
+static log_policy full_ring_policy = LOG_BLOCK;
+static size_t is_started = 0;
+static size_t reported_drops = 0;
+
+// global variables for the eventfd that wakes the flusher, and whether the flusher sleeps on it
+// a thread that publishes a record wakes the flusher only if it is sleeping, so a busy flusher costs no system call
+static int flusher_event = -1;
+static size_t is_flusher_sleeping = 0;
+
+// create a mutex lock for adding rings, and one for writing to stdout, so lines written at exit do not interleave
+static pthread_mutex_t rings_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t output_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// global variables for the ring of the current thread, and whether it could not get one
+static __thread log_ring *thread_ring = NULL;
+static __thread size_t has_no_ring = 0;
+
+// prototypes of internal functions
+static void* run_flusher(void *arg);
+static log_ring* get_thread_ring();
+static size_t flush_rings();
+static void wait_for_event(int event);
+static void wake_waiter(int event, size_t *is_waiting);
+static void write_lines(struct iovec *lines, int number_of_lines);
+static size_t format_line(char *line, const char *message, const char *host, const char *port, const size_t *is_sent);
+static size_t append_text(char *line, size_t length, const char *text);
+
+// function that starts the thread that flushes the rings of records to stdout, with the policy for full rings
+// the records that are left when the server exits are flushed by the thread that exits
+void logger_start(log_policy policy) {
+    full_ring_policy = policy;
+    flusher_event = eventfd(0, 0);
+    if (flusher_event == -1) {
+        perror("eventfd");
+        exit(EXIT_FAILURE);
+    }
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, &run_flusher, NULL) != 0) {
+        perror("pthread_create");
+        exit(EXIT_FAILURE);
+    }
+    if (pthread_detach(thread) != 0) {
+        perror("pthread_detach");
+        exit(EXIT_FAILURE);
+    }
+    if (atexit(&logger_flush) != 0) {
+        perror("atexit");
+        exit(EXIT_FAILURE);
+    }
+    __atomic_store_n(&is_started, 1, __ATOMIC_RELEASE);
+}
+
+// function that writes every record that is in the rings to stdout
+void logger_flush() {
+    while (flush_rings() > 0) {
+    }
+}
+
+// function that logs a message to STDOUT for the server
+// the line is formatted into the ring of the current thread and written by the flusher, so the thread never waits
+// for stdout unless its ring is full and the policy is to block
+void log_message(const char *message, const char *host, const char *port, const size_t *is_sent) {
+    log_ring *ring = get_thread_ring();
+
+    // without a ring, the line is written right away
+    if (ring == NULL) {
+        char line[LOG_RECORD_SIZE];
+        struct iovec lines[1];
+        lines[0].iov_base = line;
+        lines[0].iov_len = format_line(line, message, host, port, is_sent);
+        if (pthread_mutex_lock(&output_mutex) != 0) {
+            perror("pthread_mutex_lock");
+            exit(EXIT_FAILURE);
+        }
+        write_lines(lines, 1);
+        pthread_mutex_unlock(&output_mutex);
+        return;
+    }
+
+    // wait for the flusher to make room, or count the line as dropped
+    // the ring is checked again after is_blocked is set, so the flusher cannot make room without waking the thread
+    size_t head = ring->head;
+    while (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == LOG_RING_RECORDS) {
+        if (full_ring_policy == LOG_DROP) {
+            __atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELEASE);
+            return;
+        }
+        __atomic_store_n(&ring->is_blocked, 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == LOG_RING_RECORDS) {
+            wait_for_event(ring->room_event);
+        }
+        __atomic_store_n(&ring->is_blocked, 0, __ATOMIC_RELAXED);
+    }
+
+    // format the line in place, hand it to the flusher and wake the flusher if it is sleeping
+    log_record *record = &ring->records[head & (LOG_RING_RECORDS - 1)];
+    record->length = format_line(record->line, message, host, port, is_sent);
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    wake_waiter(flusher_event, &is_flusher_sleeping);
+}
+
+// function that runs the flusher, which sleeps on its eventfd whenever the rings are empty
+// the rings are checked again after is_flusher_sleeping is set, so a record that is published in between is not missed
+static void* run_flusher(void *arg) {
+    while (1) {
+        if (flush_rings() > 0) {
+            continue;
+        }
+        __atomic_store_n(&is_flusher_sleeping, 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (flush_rings() == 0) {
+            wait_for_event(flusher_event);
+        }
+        __atomic_store_n(&is_flusher_sleeping, 0, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+// function that sleeps on the eventfd until another thread writes to it
+// a wake up that was meant for an earlier sleep returns right away, after which the caller checks its rings again
+static void wait_for_event(int event) {
+    uint64_t wake_ups;
+    while (read(event, &wake_ups, sizeof(wake_ups)) == -1) {
+        if (errno != EINTR) {
+            perror("read");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// function that wakes the thread that sleeps on the eventfd, if is_waiting says there is one
+// only the thread that clears is_waiting writes to the eventfd, so a sleeping thread is woken once
+static void wake_waiter(int event, size_t *is_waiting) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(is_waiting, __ATOMIC_RELAXED) == 0) {
+        return;
+    }
+    if (__atomic_exchange_n(is_waiting, 0, __ATOMIC_SEQ_CST) == 0) {
+        return;
+    }
+    uint64_t wake_up = 1;
+    if (write(event, &wake_up, sizeof(wake_up)) != sizeof(wake_up)) {
+        perror("write");
+    }
+}
+
+// function that gets the ring of the current thread, and adds a ring for the thread the first time it logs
+// returns NULL if the logger has not been started or every ring is taken
+static log_ring* get_thread_ring() {
+    if (thread_ring != NULL || has_no_ring == 1 || __atomic_load_n(&is_started, __ATOMIC_ACQUIRE) == 0) {
+        return thread_ring;
+    }
+
+    log_ring *ring = calloc(1, sizeof(log_ring));
+    if (ring == NULL) {
+        perror("calloc");
+        has_no_ring = 1;
+        return NULL;
+    }
+    ring->room_event = eventfd(0, 0);
+    if (ring->room_event == -1) {
+        perror("eventfd");
+        Free(ring);
+        has_no_ring = 1;
+        return NULL;
+    }
+    if (pthread_mutex_lock(&rings_mutex) != 0) {
+        perror("pthread_mutex_lock");
+        exit(EXIT_FAILURE);
+    }
+    if (number_of_rings < MAX_LOG_RINGS) {
+        rings[number_of_rings] = ring;
+        __atomic_store_n(&number_of_rings, number_of_rings + 1, __ATOMIC_RELEASE);
+        thread_ring = ring;
+    }
+    pthread_mutex_unlock(&rings_mutex);
+
+    if (thread_ring == NULL) {
+        close(ring->room_event);
+        Free(ring);
+        has_no_ring = 1;
+    }
+    return thread_ring;
+}
+
+// function that writes the records that are in the rings to stdout in batches, one writev() per batch
+// also logs how many lines have been dropped since the last time
+// returns the number of records that were written
+static size_t flush_rings() {
+    if (pthread_mutex_lock(&output_mutex) != 0) {
+        perror("pthread_mutex_lock");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t number_of_records = 0;
+    size_t dropped = 0;
+    size_t count = __atomic_load_n(&number_of_rings, __ATOMIC_ACQUIRE);
+    for (size_t i = 0; i < count; i++) {
+        log_ring *ring = rings[i];
+        dropped += __atomic_load_n(&ring->dropped, __ATOMIC_ACQUIRE);
+
+        // the records between the tail and the head are complete
+        size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        size_t tail = ring->tail;
+        while (tail != head) {
+            struct iovec lines[LOG_BATCH_SIZE];
+            int number_of_lines = 0;
+            for (; tail != head && number_of_lines < LOG_BATCH_SIZE; tail++, number_of_lines++) {
+                log_record *record = &ring->records[tail & (LOG_RING_RECORDS - 1)];
+                lines[number_of_lines].iov_base = record->line;
+                lines[number_of_lines].iov_len = record->length;
+            }
+            write_lines(lines, number_of_lines);
+            number_of_records += number_of_lines;
+
+            // give the records back to the thread, and wake it if it waits for room
+            __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+            wake_waiter(ring->room_event, &ring->is_blocked);
+        }
+    }
+
+    // log the number of lines that were dropped because a ring was full
+    if (dropped > reported_drops) {
+        char line[LOG_RECORD_SIZE];
+        struct iovec lines[1];
+        lines[0].iov_base = line;
+        lines[0].iov_len = snprintf(line, sizeof(line), "[SERVER] [LOGGER] [DROPPED %zu LINES]\n", dropped - reported_drops);
+        write_lines(lines, 1);
+        reported_drops = dropped;
+    }
+
+    pthread_mutex_unlock(&output_mutex);
+    return number_of_records;
+}
+
+// function that writes all of the lines to stdout, even if writev() only writes some of them at a time
+// a failed write leaves nothing that can be flushed, so the server exits right away
+static void write_lines(struct iovec *lines, int number_of_lines) {
+    while (number_of_lines > 0) {
+        ssize_t written = writev(STDOUT_FILENO, lines, number_of_lines);
+        if (written == -1 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            perror("writev");
+            _exit(EXIT_FAILURE);
+        }
+
+        // skip the lines that were written completely and the written part of the next one
+        while (number_of_lines > 0 && (size_t) written >= lines->iov_len) {
+            written -= lines->iov_len;
+            lines++;
+            number_of_lines--;
+        }
+        if (number_of_lines > 0) {
+            lines->iov_base = (char *) lines->iov_base + written;
+            lines->iov_len -= written;
+        }
+    }
+}
+
+// function that formats the line of a message in the format [SERVER] [CLIENT host:port] [SENT or RECV] [message]
+// a message that does not fit in a record is cut off
+// returns the length of the line
+static size_t format_line(char *line, const char *message, const char *host, const char *port, const size_t *is_sent) {
+    size_t length = append_text(line, 0, "[SERVER] [CLIENT ");
+    length = append_text(line, length, host);
+    length = append_text(line, length, ":");
+    length = append_text(line, length, port);
+    length = append_text(line, length, "]");
+    if (is_sent == NULL) {
+        length = append_text(line, length, " [");
+    } else if (*is_sent == 0) {
+        length = append_text(line, length, " [RECV] [");
+    } else {
+        length = append_text(line, length, " [SENT] [");
+    }
+    length = append_text(line, length, message);
+    line[length++] = ']';
+    line[length++] = '\n';
+    return length;
+}
+
+// function that copies as much of the text to the end of the line as fits, leaving room for the end of the line
+// returns the new length of the line
+static size_t append_text(char *line, size_t length, const char *text) {
+    size_t text_length = strlen(text);
+    if (text_length > LOG_RECORD_SIZE - 2 - length) {
+        text_length = LOG_RECORD_SIZE - 2 - length;
+    }
+    memcpy(line + length, text, text_length);
+    return length + text_length;
+}
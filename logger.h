@@ -0,0 +1,50 @@
+#ifndef P3_LOGGER_H
+#define P3_LOGGER_H
+
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/uio.h>
+#include <sys/eventfd.h>
+#include "helper.h"
+
+// declare enumeration for constants of the logger
+// a record holds the longest line the server logs, which is a BEGN message with the longest name and an IPv6 address
+// the number of records in a ring must be a power of 2
+typedef enum logger_constant {
+    LOG_RECORD_SIZE = 2048,
+    LOG_RING_RECORDS = 256,
+    MAX_LOG_RINGS = 256,
+    LOG_BATCH_SIZE = 64,
+} logger_constant;
+
+// declare enumeration for what a thread does when its ring of records is full
+typedef enum log_policy {
+    LOG_BLOCK = 0,
+    LOG_DROP = 1,
+} log_policy;
+
+// define struct for a line of the log that is formatted by the thread that logs it
+typedef struct log_record {
+    size_t length;
+    char line[LOG_RECORD_SIZE];
+} log_record;
+
+// define struct for the ring of records of one thread, which only that thread writes and only the flusher reads
+// head is only advanced by the thread and tail only by the flusher, so neither needs a lock
+// a thread that waits for room in its full ring sets is_blocked and sleeps on room_event until the flusher wakes it
+typedef struct log_ring {
+    size_t head;
+    size_t tail;
+    size_t dropped;
+    size_t is_blocked;
+    int room_event;
+    log_record records[LOG_RING_RECORDS];
+} log_ring;
+
+// prototypes of all functions
+void logger_start(log_policy policy);
+void logger_flush();
+void log_message(const char *message, const char *host, const char *port, const size_t *is_sent);
+
+#endif //P3_LOGGER_H
@@ -0,0 +1,350 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdarg.h>
+#include <inttypes.h>
+#include "metrics.h"
+#include "net.h"
+#include "recorder.h"
+
+// global variables for the labels of the metrics that have one value for each value of a label
+// the opcodes are in the same order as message_code, and the pools in the same order as pool_kind
+static const char *const OPCODES[] = {"PLAY", "MOVE", "RSGN", "DRAW", "WAIT", "BEGN", "MOVD", "INVL", "OVER"};
+static const char *const REASONS[] = {"occupied", "protocol_error", "name_in_use"};
+static const char *const POOLS[] = {"client", "game", "short_output", "long_output", "handoff",
+                                     "short_name", "long_name"};
+
+// global variable for the percentiles of the latencies that are reported, and their names in the plain text format
+static const double PERCENTILES[] = {50.0, 90.0, 99.0, 99.9};
+static const char *const QUANTILES[] = {"0.5", "0.9", "0.99", "0.999"};
+static const char *const PERCENTILE_NAMES[] = {"p50", "p90", "p99", "p999"};
+
+// global variable for every family of metrics, in the order they are reported
+static const metric_family FAMILIES[] = {
+        {"connections_accepted_total", "counter", "Connections accepted by every shard.",
+         METRIC_CONNECTIONS_ACCEPTED, 1, NULL, NULL},
+        {"clients_rejected_total", "counter", "Clients closed for a malformed or unfinished message.",
+         METRIC_CLIENTS_REJECTED, 1, NULL, NULL},
+        {"games_started_total", "counter", "Games that have begun.",
+         METRIC_GAMES_STARTED, 1, NULL, NULL},
+        {"bytes_received_total", "counter", "Bytes received from clients.",
+         METRIC_BYTES_RECEIVED, 1, NULL, NULL},
+        {"bytes_sent_total", "counter", "Bytes sent to clients.",
+         METRIC_BYTES_SENT, 1, NULL, NULL},
+        {"handshakes_in_flight", "gauge", "Clients that have connected and not sent a valid PLAY message yet.",
+         METRIC_HANDSHAKES_IN_FLIGHT, 1, NULL, NULL},
+        {"live_games", "gauge", "Games that have begun and not ended yet.",
+         METRIC_LIVE_GAMES, 1, NULL, NULL},
+        {"messages_received_total", "counter", "Complete messages received, by opcode.",
+         METRIC_MESSAGES_RECEIVED, METRIC_OPCODES, "opcode", OPCODES},
+        {"messages_sent_total", "counter", "Messages queued for clients, by opcode.",
+         METRIC_MESSAGES_SENT, METRIC_OPCODES, "opcode", OPCODES},
+        {"invalid_messages_total", "counter", "INVL messages sent, by reason.",
+         METRIC_INVALID_MESSAGES, METRIC_REASONS, "reason", REASONS},
+        {"player_names", "gauge", "Names in the set of player names.",
+         METRIC_PLAYER_NAMES, 1, NULL, NULL},
+        {"pool_objects", "gauge", "Objects carved out of the slabs of a pool.",
+         METRIC_POOL_OBJECTS, NUMBER_OF_POOLS, "pool", POOLS},
+        {"pool_free_objects", "gauge", "Free objects of a pool that no thread keeps in its cache.",
+         METRIC_POOL_FREE, NUMBER_OF_POOLS, "pool", POOLS},
+        {"pairing_queue_depth", "gauge", "Waiting clients handed to the first shard and not taken by it yet.",
+         METRIC_PAIRING_DEPTH, 1, NULL, NULL},
+        {"pairing_pushed_total", "counter", "Waiting clients handed to the first shard.",
+         METRIC_PAIRING_PUSHED, 1, NULL, NULL},
+        {"pairing_wait_nanoseconds_total", "counter",
+         "Nanoseconds that waiting clients spent on their way to the first shard while the metrics were served.",
+         METRIC_PAIRING_WAIT, 1, NULL, NULL},
+};
+
+// global variables for the blocks of the threads that have counted, and whether the metrics are served
+// a block is added once by its thread and never removed, and number_of_blocks is only advanced after the block is set
+// a thread that cannot get a block of its own counts into the shared block, which is only changed atomically
+static metrics_block *blocks[MAX_METRIC_BLOCKS];
+static size_t number_of_blocks = 0;
+static metrics_block shared_block;
+static size_t is_served = 0;
+
+// create a mutex lock for adding blocks
+static pthread_mutex_t blocks_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// global variables for the block of the current thread, and whether it could not get one
+static __thread metrics_block *thread_block = NULL;
+static __thread size_t has_no_block = 0;
+
+// prototypes of internal functions
+static metrics_block* get_thread_block();
+static void* run_admin(void *arg);
+static void answer_request(int peer);
+static void send_recording(int peer, size_t is_http);
+static size_t format_family(const metric_family *family, const metrics_snapshot *snapshot, metrics_format format,
+                            char *report, size_t length, size_t capacity);
+static size_t format_latencies(const metrics_snapshot *snapshot, metrics_format format, char *report, size_t length,
+                               size_t capacity);
+static size_t append_text(char *report, size_t length, size_t capacity, const char *format, ...);
+
+// function that adds the value to the metric of the current thread, which takes a negative value for a gauge
+// only the current thread writes its block, so the value is added without a lock or a locked instruction
+void metrics_add(metric_slot slot, int64_t value) {
+    metrics_block *block = get_thread_block();
+    if (block == NULL) {
+        __atomic_add_fetch(&shared_block.values[slot], (uint64_t) value, __ATOMIC_RELAXED);
+        return;
+    }
+    __atomic_store_n(&block->values[slot], block->values[slot] + (uint64_t) value, __ATOMIC_RELAXED);
+}
+
+// function that records the latency of a response to a message with the given opcode for the current thread
+// a thread without a block of its own does not record latencies, since a histogram only has one writer
+void metrics_record_latency(size_t code, uint64_t nanoseconds) {
+    metrics_block *block = get_thread_block();
+    if (block == NULL || code >= METRIC_LATENCIES) {
+        return;
+    }
+    histogram_record(&block->latencies[code], nanoseconds);
+}
+
+// function that takes a snapshot of every metric, which sums the blocks of every thread and reads the counters of the
+// other modules without a lock, so taking it never makes a shard wait
+void metrics_take_snapshot(metrics_snapshot *snapshot) {
+    memset(snapshot, 0, sizeof(metrics_snapshot));
+    size_t count = __atomic_load_n(&number_of_blocks, __ATOMIC_ACQUIRE);
+    for (size_t i = 0; i <= count; i++) {
+        const metrics_block *block = i < count ? blocks[i] : &shared_block;
+        for (size_t j = 0; j < NUMBER_OF_THREAD_METRICS; j++) {
+            snapshot->values[j] += __atomic_load_n(&block->values[j], __ATOMIC_RELAXED);
+        }
+        for (size_t j = 0; j < METRIC_LATENCIES; j++) {
+            histogram_merge(&snapshot->latencies[j], &block->latencies[j]);
+        }
+    }
+
+    snapshot->values[METRIC_PLAYER_NAMES] = get_number_of_names();
+    for (size_t i = 0; i < NUMBER_OF_POOLS; i++) {
+        pool_stats stats;
+        pool_get_stats(i, &stats);
+        snapshot->values[METRIC_POOL_OBJECTS + i] = stats.number_of_objects;
+        snapshot->values[METRIC_POOL_FREE + i] = stats.number_of_free;
+    }
+}
+
+// function that writes the snapshot into the report in the given format, where the plain text format has a line
+// "<name> <value>" or "<name> <label value> <value>" for each value and the Prometheus format is the text exposition
+// format with every name prefixed by "ttts_"
+// returns the length of the report, which is cut off before the first piece of text that does not fit
+size_t metrics_format_snapshot(const metrics_snapshot *snapshot, metrics_format format, char *report, size_t capacity) {
+    size_t length = 0;
+    if (capacity > 0) {
+        report[0] = '\0';
+    }
+    for (size_t i = 0; i < sizeof(FAMILIES) / sizeof(FAMILIES[0]); i++) {
+        length = format_family(&FAMILIES[i], snapshot, format, report, length, capacity);
+    }
+    return format_latencies(snapshot, format, report, length, capacity);
+}
+
+// function that starts the thread that answers requests for the metrics on the given port of the loopback address
+// a request is answered with a fresh snapshot, in the Prometheus format if it names "metrics" and in plain text
+// otherwise, and with an HTTP response if it is an HTTP GET request, so "curl localhost:<port>/metrics" and
+// "echo stats | nc localhost <port>" both work
+void metrics_serve(const char *port) {
+    int admin_socket = create_loopback_socket(port);
+    if (admin_socket == -1) {
+        perror("create_loopback_socket");
+        exit(EXIT_FAILURE);
+    }
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, &run_admin, (void *) (intptr_t) admin_socket) != 0) {
+        perror("pthread_create");
+        exit(EXIT_FAILURE);
+    }
+    if (pthread_detach(thread) != 0) {
+        perror("pthread_detach");
+        exit(EXIT_FAILURE);
+    }
+    __atomic_store_n(&is_served, 1, __ATOMIC_RELAXED);
+}
+
+// function that tells whether the metrics are served, so metrics that need a clock read are only measured then
+// returns 1 if they are served and 0 otherwise
+size_t metrics_are_served() {
+    return __atomic_load_n(&is_served, __ATOMIC_RELAXED);
+}
+
+// function that gets the block of the current thread, and adds a block for the thread the first time it counts
+// returns NULL if every block is taken
+static metrics_block* get_thread_block() {
+    if (thread_block != NULL || has_no_block == 1) {
+        return thread_block;
+    }
+
+    metrics_block *block = NULL;
+    if (posix_memalign((void **) &block, CACHE_LINE_SIZE, sizeof(metrics_block)) != 0) {
+        perror("posix_memalign");
+        has_no_block = 1;
+        return NULL;
+    }
+    memset(block, 0, sizeof(metrics_block));
+    if (pthread_mutex_lock(&blocks_mutex) != 0) {
+        perror("pthread_mutex_lock");
+        exit(EXIT_FAILURE);
+    }
+    if (number_of_blocks < MAX_METRIC_BLOCKS) {
+        blocks[number_of_blocks] = block;
+        __atomic_store_n(&number_of_blocks, number_of_blocks + 1, __ATOMIC_RELEASE);
+        thread_block = block;
+    } else {
+        block = Free(block);
+        has_no_block = 1;
+    }
+    pthread_mutex_unlock(&blocks_mutex);
+    return thread_block;
+}
+
+// function that runs the admin thread, which answers one request at a time on the admin socket
+static void* run_admin(void *arg) {
+    int admin_socket = (int) (intptr_t) arg;
+    while (1) {
+        int peer = accept(admin_socket, NULL, NULL);
+        if (peer == -1) {
+            if (errno != EINTR) {
+                perror("accept");
+            }
+            continue;
+        }
+        answer_request(peer);
+        close(peer);
+    }
+    return NULL;
+}
+
+// function that reads the request of the peer and sends it a snapshot of the metrics, or the recording of the flight
+// recorder if it asks for the flight
+// a peer that sends nothing within the request timeout gets the plain text format
+static void answer_request(int peer) {
+    char request[METRICS_REQUEST_SIZE];
+    ssize_t request_length = 0;
+    if (wait_for_readable(peer, METRICS_REQUEST_TIMEOUT) == 0) {
+        request_length = recv(peer, request, sizeof(request) - 1, 0);
+    }
+    request[request_length > 0 ? request_length : 0] = '\0';
+    size_t is_http = strncmp(request, "GET ", 4) == 0;
+    if (strstr(request, "flight") != NULL) {
+        send_recording(peer, is_http);
+        return;
+    }
+    metrics_format format = strstr(request, "metrics") != NULL ? METRICS_PROMETHEUS : METRICS_TEXT;
+
+    metrics_snapshot snapshot;
+    metrics_take_snapshot(&snapshot);
+    char report[METRICS_REPORT_SIZE];
+    size_t length = metrics_format_snapshot(&snapshot, format, report, sizeof(report));
+
+    if (is_http == 1) {
+        char header[256];
+        int header_length = snprintf(header, sizeof(header),
+                                     "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                     "Content-Length: %zu\r\nConnection: close\r\n\r\n", length);
+        if (send_message(peer, header, header_length) == -1) {
+            perror("send_message");
+            return;
+        }
+    }
+    if (send_message(peer, report, length) == -1) {
+        perror("send_message");
+    }
+}
+
+// function that sends the recording of the flight recorder to the peer, which the flight tool decodes
+// the recording is written straight from the rings, so the HTTP response ends when the connection closes
+static void send_recording(int peer, size_t is_http) {
+    const char *header = "HTTP/1.0 200 OK\r\nContent-Type: application/octet-stream\r\nConnection: close\r\n\r\n";
+    if (is_http == 1 && send_message(peer, header, strlen(header)) == -1) {
+        perror("send_message");
+        return;
+    }
+    if (recorder_write(peer) == -1) {
+        perror("recorder_write");
+    }
+}
+
+// function that appends every value of the family to the report
+// returns the new length of the report
+static size_t format_family(const metric_family *family, const metrics_snapshot *snapshot, metrics_format format,
+                            char *report, size_t length, size_t capacity) {
+    if (format == METRICS_PROMETHEUS) {
+        length = append_text(report, length, capacity, "# HELP ttts_%s %s\n# TYPE ttts_%s %s\n",
+                             family->name, family->help, family->name, family->type);
+    }
+
+    // a gauge that threads add to and take away from is read as a signed number
+    for (size_t i = 0; i < family->number_of_values; i++) {
+        char value[32];
+        uint64_t raw = snapshot->values[family->first_slot + i];
+        if (strcmp(family->type, "gauge") == 0) {
+            snprintf(value, sizeof(value), "%" PRId64, (int64_t) raw);
+        } else {
+            snprintf(value, sizeof(value), "%" PRIu64, raw);
+        }
+
+        if (family->label == NULL && format == METRICS_PROMETHEUS) {
+            length = append_text(report, length, capacity, "ttts_%s %s\n", family->name, value);
+        } else if (family->label == NULL) {
+            length = append_text(report, length, capacity, "%s %s\n", family->name, value);
+        } else if (format == METRICS_PROMETHEUS) {
+            length = append_text(report, length, capacity, "ttts_%s{%s=\"%s\"} %s\n",
+                                 family->name, family->label, family->label_values[i], value);
+        } else {
+            length = append_text(report, length, capacity, "%s %s %s\n",
+                                 family->name, family->label_values[i], value);
+        }
+    }
+    return length;
+}
+
+// function that appends the percentiles, the sum and the count of the latencies of each opcode to the report, as a
+// Prometheus summary or as one line for each opcode
+// returns the new length of the report
+static size_t format_latencies(const metrics_snapshot *snapshot, metrics_format format, char *report, size_t length,
+                               size_t capacity) {
+    const char *name = "response_latency_nanoseconds";
+    if (format == METRICS_PROMETHEUS) {
+        length = append_text(report, length, capacity, "# HELP ttts_%s Time from the receive that completed a message "
+                             "to the write of each response, by opcode.\n# TYPE ttts_%s summary\n", name, name);
+    }
+    for (size_t i = 0; i < METRIC_LATENCIES; i++) {
+        const histogram *latencies = &snapshot->latencies[i];
+        if (format == METRICS_TEXT) {
+            length = append_text(report, length, capacity, "%s %s count %" PRIu64, name, OPCODES[i],
+                                 latencies->count);
+        }
+        for (size_t j = 0; j < sizeof(PERCENTILES) / sizeof(PERCENTILES[0]); j++) {
+            uint64_t value = histogram_get_percentile(latencies, PERCENTILES[j]);
+            if (format == METRICS_PROMETHEUS) {
+                length = append_text(report, length, capacity, "ttts_%s{opcode=\"%s\",quantile=\"%s\"} %" PRIu64 "\n",
+                                     name, OPCODES[i], QUANTILES[j], value);
+            } else {
+                length = append_text(report, length, capacity, " %s %" PRIu64, PERCENTILE_NAMES[j], value);
+            }
+        }
+        if (format == METRICS_PROMETHEUS) {
+            length = append_text(report, length, capacity, "ttts_%s_sum{opcode=\"%s\"} %" PRIu64 "\n"
+                                 "ttts_%s_count{opcode=\"%s\"} %" PRIu64 "\n", name, OPCODES[i], latencies->sum,
+                                 name, OPCODES[i], latencies->count);
+        } else {
+            length = append_text(report, length, capacity, " max %" PRIu64 "\n", latencies->max);
+        }
+    }
+    return length;
+}
+
+// function that appends the formatted text to the report, unless it does not fit
+// returns the new length of the report
+static size_t append_text(char *report, size_t length, size_t capacity, const char *format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    int written = vsnprintf(report + length, capacity - length, format, arguments);
+    va_end(arguments);
+    if (written < 0 || (size_t) written >= capacity - length) {
+        report[length] = '\0';
+        return length;
+    }
+    return length + written;
+}
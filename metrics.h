@@ -0,0 +1,90 @@
+#ifndef P3_METRICS_H
+#define P3_METRICS_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "pool.h"
+#include "names.h"
+#include "histogram.h"
+
+// declare enumeration for constants of the metrics registry
+// the opcodes are counted in the same order as message_code, and the reasons of INVL in the same order as the INVL
+// frames of the server, which are "That space is occupied.", "!Protocol error." and "Name already in use."
+// the latency of a response is kept for each opcode that clients send, which are the first 4 codes of message_code
+typedef enum metrics_constant {
+    METRIC_OPCODES = 9,
+    METRIC_REASONS = 3,
+    METRIC_LATENCIES = 4,
+    MAX_METRIC_BLOCKS = 512,
+    METRICS_REPORT_SIZE = 16384,
+    METRICS_REQUEST_SIZE = 1024,
+    METRICS_REQUEST_TIMEOUT = 1000,
+} metrics_constant;
+
+// declare enumeration for the values of a snapshot of the metrics
+// the values up to NUMBER_OF_THREAD_METRICS are counted by the threads that change them, and a gauge among them is the
+// sum of what each thread added and took away, so it may be taken away by another thread than the one that added it
+// the values after them are read from the modules that keep them when the snapshot is taken
+typedef enum metric_slot {
+    METRIC_CONNECTIONS_ACCEPTED = 0,
+    METRIC_CLIENTS_REJECTED = 1,
+    METRIC_GAMES_STARTED = 2,
+    METRIC_BYTES_RECEIVED = 3,
+    METRIC_BYTES_SENT = 4,
+    METRIC_HANDSHAKES_IN_FLIGHT = 5,
+    METRIC_LIVE_GAMES = 6,
+    METRIC_MESSAGES_RECEIVED = 7,
+    METRIC_MESSAGES_SENT = METRIC_MESSAGES_RECEIVED + METRIC_OPCODES,
+    METRIC_INVALID_MESSAGES = METRIC_MESSAGES_SENT + METRIC_OPCODES,
+    METRIC_PAIRING_DEPTH = METRIC_INVALID_MESSAGES + METRIC_REASONS,
+    METRIC_PAIRING_PUSHED = METRIC_PAIRING_DEPTH + 1,
+    METRIC_PAIRING_WAIT = METRIC_PAIRING_PUSHED + 1,
+    NUMBER_OF_THREAD_METRICS = METRIC_PAIRING_WAIT + 1,
+    METRIC_PLAYER_NAMES = NUMBER_OF_THREAD_METRICS,
+    METRIC_POOL_OBJECTS = METRIC_PLAYER_NAMES + 1,
+    METRIC_POOL_FREE = METRIC_POOL_OBJECTS + NUMBER_OF_POOLS,
+    NUMBER_OF_METRICS = METRIC_POOL_FREE + NUMBER_OF_POOLS,
+} metric_slot;
+
+// declare enumeration for the formats that a snapshot of the metrics can be written in
+typedef enum metrics_format {
+    METRICS_TEXT = 0,
+    METRICS_PROMETHEUS = 1,
+} metrics_format;
+
+// define struct for the values that one thread counts, which only that thread writes and any thread reads
+// every block starts on its own cache line, so threads never slow each other down by counting
+// the latencies are the nanoseconds from the receive that completed a message of a client to the write of each
+// response to it, for each opcode that clients send
+typedef struct metrics_block {
+    uint64_t values[NUMBER_OF_THREAD_METRICS];
+    histogram latencies[METRIC_LATENCIES];
+} __attribute__((aligned(CACHE_LINE_SIZE))) metrics_block;
+
+// define struct for a snapshot of every metric, where a gauge that is counted by threads wraps around like the
+// unsigned sum of its blocks and is read as a signed number, and the latencies of every thread are merged
+typedef struct metrics_snapshot {
+    uint64_t values[NUMBER_OF_METRICS];
+    histogram latencies[METRIC_LATENCIES];
+} metrics_snapshot;
+
+// define struct for a family of metrics, which is one value or one value for each value of its label
+typedef struct metric_family {
+    const char *name;
+    const char *type;
+    const char *help;
+    metric_slot first_slot;
+    size_t number_of_values;
+    const char *label;
+    const char *const *label_values;
+} metric_family;
+
+// prototypes of all functions
+void metrics_add(metric_slot slot, int64_t value);
+void metrics_record_latency(size_t code, uint64_t nanoseconds);
+void metrics_take_snapshot(metrics_snapshot *snapshot);
+size_t metrics_format_snapshot(const metrics_snapshot *snapshot, metrics_format format, char *report, size_t capacity);
+void metrics_serve(const char *port);
+size_t metrics_are_served();
+
+#endif //P3_METRICS_H
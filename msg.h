@@ -6,71 +6,109 @@
 #include "helper.h"
 #include "net.h"
 
+// declare enumeration for constants of message framing
+typedef enum msg_constant {
+    DEFAULT_MESSAGE_TIMEOUT = 501,
+    NUMBER_OF_CODES = 9,
+    MAX_FIELDS = 3,
+    MAX_DIGITS = 3,
+} msg_constant;
+
+// declare enumeration for the 4-character codes of the protocol, in the same order as translate_protocol()
+typedef enum message_code {
+    CODE_PLAY = 0,
+    CODE_MOVE = 1,
+    CODE_RSGN = 2,
+    CODE_DRAW = 3,
+    CODE_WAIT = 4,
+    CODE_BEGN = 5,
+    CODE_MOVD = 6,
+    CODE_INVL = 7,
+    CODE_OVER = 8,
+} message_code;
+
+// declare enumeration for the states of the frame parser
+typedef enum frame_state {
+    FRAME_CODE = 0,
+    FRAME_LENGTH = 1,
+    FRAME_FIELDS = 2,
+} frame_state;
+
+// define struct for a view of a complete message in a buffer, which points into the buffer by offsets
+// the fields are the parts between the bars after the length field, so "MOVE|6|X|2,2|" has the fields "X" and "2,2"
+typedef struct frame {
+    message_code code;
+    size_t length;
+    size_t number_of_fields;
+    size_t field_offsets[MAX_FIELDS];
+    size_t field_lengths[MAX_FIELDS];
+} frame;
+
+// define struct for a message from a client, decoded once from its frame and tagged with its code
+// a message that is not a valid PLAY, MOVE, RSGN or DRAW message is tagged INVL, since the server answers it with INVL
+// the name of a PLAY message points into the message, so it is only valid as long as the message is
+typedef struct message {
+    message_code code;
+    union {
+        struct {
+            const char *name;
+            size_t name_length;
+        } play;
+        struct {
+            char role;
+            size_t row;
+            size_t col;
+        } move;
+        struct {
+            char action;
+        } draw;
+    } fields;
+} message;
+
+// global variables for the codes of the protocol and the number of bars in a message of each code
+static const char *CODES[NUMBER_OF_CODES] = {"PLAY", "MOVE", "RSGN", "DRAW", "WAIT", "BEGN", "MOVD", "INVL", "OVER"};
+static const size_t NUMBER_OF_BARS[NUMBER_OF_CODES] = {3, 4, 2, 3, 2, 4, 5, 3, 4};
+
+// global variable for the number of milliseconds a partial message may stay quiet before it is malformed
+// it is only set once at startup, before any thread reads it
+static int message_timeout = DEFAULT_MESSAGE_TIMEOUT;
+
 // prototypes of all functions
-void log_message(const char *message, const char *host, const char *port, const size_t *is_sent);
+void set_message_timeout(int timeout);
+int get_message_timeout();
 ssize_t get_message(int socket, char **msg_buffer, char **msg);
 ssize_t receive_and_add(int socket, char **msg_buffer);
-ssize_t parse_play(const char *msg, char **player_name);
+ssize_t add_to_buffer(char **msg_buffer, const char *msg, size_t length);
 size_t check_protocol(const char *msg, const char *protocol);
 size_t is_complete_msg(const char *msg_buffer, size_t *max_index);
+size_t parse_frame(const char *msg_buffer, frame *view);
+ssize_t translate_code(const char *msg_buffer, message_code *code);
+ssize_t parse_length(const char *str_num, size_t num_of_digits, size_t *length);
 ssize_t get_complete_message(char **msg_buffer, char **msg, const size_t *max_size);
 size_t check_num_of_bars(const char *msg_buffer, const char* protocol, const size_t *num_of_remaining_bytes, const size_t *num_of_digits, size_t *max_size);
 ssize_t get_remaining_bytes(const char *msg_buffer, size_t *num_of_remaining_bytes, size_t *num_of_digits);
 ssize_t to_unsigned_long(const char* str_num, size_t *num_of_remaining_bytes);
 ssize_t translate_protocol(const char* protocol, size_t *code);
-ssize_t parse_move(const char *msg, char *role, size_t *row, size_t *col);
-ssize_t parse_rsgn(const char *msg);
-ssize_t parse_draw(const char *msg, char *action);
-
-
-// function that logs a message to STDOUT for the server
-void log_message(const char *message, const char *host, const char *port, const size_t *is_sent) {
-    // log the message in format [SERVER] [CLIENT host:port] [SENT or RECV] [message]
-    size_t log_length =
-            strlen("[SERVER] [CLIENT :] [SENT] []") +
-            strlen(host) +
-            strlen(port) +
-            strlen(message) + 2;
-
-    char *log = malloc(sizeof(char) * log_length);
-
-    if (log == NULL) {
-        perror("malloc");
-        exit(EXIT_FAILURE);
-    }
-
-    // use string concatenation to create the log message
-    strcpy(log, "[SERVER] [CLIENT ");
-    strcat(log, host);
-    strcat(log, ":");
-    strcat(log, port);
-    strcat(log, "]");
-
-    if (is_sent != NULL) {
-        if (*is_sent == 0) {
-            strcat(log, " [RECV] [");
-        } else {
-            strcat(log, " [SENT] [");
-        }
-    } else {
-        strcat(log, " [");
-    }
+void decode_message(const char *msg, const frame *view, message *decoded);
+ssize_t decode_play(const char *msg, const frame *view, message *decoded);
+ssize_t decode_move(const char *msg, const frame *view, message *decoded);
+ssize_t decode_draw(const char *msg, const frame *view, message *decoded);
+ssize_t parse_coordinate(const char *str_num, size_t num_of_digits, size_t *coordinate);
 
-    strcat(log, message);
-    strcat(log, "]\n");
 
-    // write the log message to stdout using strlen()
-    if (write(STDOUT_FILENO, log, strlen(log)) != strlen(log)) {
-        Free(log);
-        perror("write");
-        exit(EXIT_FAILURE);
-    }
+// function that sets the number of milliseconds a partial message may stay quiet before it is malformed
+void set_message_timeout(int timeout) {
+    message_timeout = timeout;
+}
 
-    // free the log buffer
-    Free(log);
+// function that gets the number of milliseconds a partial message may stay quiet before it is malformed
+int get_message_timeout() {
+    return message_timeout;
 }
 
 // function that gets the next message from the socket
+// a message is returned as soon as its last byte arrives, while a partial message that stays quiet for longer
+// than the message timeout is truncated or malformed
 // returns -1 on error and 0 on success
 ssize_t get_message(int socket, char **msg_buffer, char **msg) {
     // input validation
@@ -79,48 +117,29 @@ ssize_t get_message(int socket, char **msg_buffer, char **msg) {
     }
 
     size_t max_index = 0;
+    while (1) {
+        // write complete message if there is one
+        if (is_complete_msg(*msg_buffer, &max_index) == 1) {
+            if (get_complete_message(msg_buffer, msg, &max_index) == -1) {
+                return -1;
+            } else {
+                return 0;
+            }
+        }
 
-    // write complete message if there is one
-    if (is_complete_msg(*msg_buffer, &max_index) == 1) {
-        if (get_complete_message(msg_buffer, msg, &max_index) == -1) {
+        // if there is nothing in the buffer, wait for the first byte of the next message (indefinitely blocking)
+        // otherwise the rest of the message has to arrive before the timeout, or it is a malformed message
+        if (*msg_buffer != NULL && strlen(*msg_buffer) > 0 &&
+            wait_for_readable(socket, message_timeout) == -1) {
+            *msg_buffer = Free(*msg_buffer);
             return -1;
-        } else {
-            return 0;
         }
-    }
 
-    // if there is nothing in the buffer
-    // receive the first message from the socket and add it to the message buffer (indefinitely blocking)
-    if (*msg_buffer == NULL || strlen(*msg_buffer) == 0) {
+        // receive the next bytes from the socket and add them to the message buffer
         if (receive_and_add(socket, msg_buffer) == -1) {
             return -1;
         }
     }
-
-    // get all the messages from the socket within the timeout period
-    while (1) {
-        ssize_t index = get_readable_socket(&socket, 1, 501);
-        if (index == -1) {
-            break;
-        } else {
-            if (receive_and_add(socket, msg_buffer) == -1) {
-                break;
-            }
-        }
-    }
-
-    // if there is no complete message after receiving all packets, then it is a malformed message
-    if (is_complete_msg(*msg_buffer, &max_index) == 0) {
-        *msg_buffer = Free(*msg_buffer);
-        return -1;
-    }
-
-    // write the complete message
-    if (get_complete_message(msg_buffer, msg, &max_index) == -1) {
-        return -1;
-    } else {
-        return 0;
-    }
 }
 
 // function that receives a message from the socket and adds it to the buffer
@@ -134,133 +153,194 @@ ssize_t receive_and_add(int socket, char **msg_buffer) {
     if (msg == NULL) {
         return -1;
     }
+    if (add_to_buffer(msg_buffer, msg, length) == -1) {
+        Free(msg);
+        return -1;
+    }
+    msg = Free(msg);
+
+    return 0;
+
+}
+
+// function that appends the given message of the given length to the buffer
+// returns -1 on error and 0 on success
+ssize_t add_to_buffer(char **msg_buffer, const char *msg, size_t length) {
+    if (msg_buffer == NULL || msg == NULL) {
+        return -1;
+    }
     if (*msg_buffer == NULL) {
         *msg_buffer = strdup("");
     }
-    char *new_buffer = malloc(strlen(*msg_buffer) + length + 1);
+    // the message does not have to be null-terminated, so copy exactly length bytes
+    size_t buffer_length = strlen(*msg_buffer);
+    char *new_buffer = malloc(buffer_length + length + 1);
     if (new_buffer == NULL) {
-        Free(msg);
         return -1;
     }
-    strcpy(new_buffer, *msg_buffer);
-    strcat(new_buffer, msg);
-    msg = Free(msg);
+    memcpy(new_buffer, *msg_buffer, buffer_length);
+    memcpy(new_buffer + buffer_length, msg, length);
+    new_buffer[buffer_length + length] = '\0';
     *msg_buffer = Free(*msg_buffer);
     *msg_buffer = new_buffer;
 
     return 0;
-
 }
 
 
 // function that checks whether given buffer contains a complete message
 size_t is_complete_msg(const char *msg_buffer, size_t *max_index) {
     // input validation
-    if (msg_buffer == NULL || max_index == NULL) {
+    if (max_index == NULL) {
         return 0;
     }
-    // no complete message if length of buffer is less than minimum number of bytes required for complete message
-    if (strlen(msg_buffer) < 7) {
+
+    frame view;
+    if (parse_frame(msg_buffer, &view) == 0) {
         return 0;
     }
+    *max_index = view.length;
+    return 1;
+}
 
-    size_t remaining_bytes = 0;
-    size_t num_of_digits = 0;
+// function that checks whether the given buffer starts with a complete message and fills in a view of it
+// walks the bytes of the message once without allocating, and stops at the end of the message
+// a message is complete once it has as many bytes as its length field says and the right number of bars for its code
+// the bytes are not copied, so the view is only valid as long as the buffer is
+// returns 1 if the message is complete and 0 otherwise
+size_t parse_frame(const char *msg_buffer, frame *view) {
+    // input validation
+    if (msg_buffer == NULL || view == NULL) {
+        return 0;
+    }
 
-    // check if number of bars is correct based on protocol and is within number of specified bytes
-    if (check_protocol(msg_buffer, "PLAY") == 1) {
-        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
-            return 0;
-        } else {
-            if (check_num_of_bars(msg_buffer, "PLAY", &remaining_bytes, &num_of_digits, max_index) == 0) {
-                return 0;
-            } else {
-                return 1;
-            }
-        }
-    } else if (check_protocol(msg_buffer, "MOVE") == 1) {
-        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
-            return 0;
-        } else {
-            if (check_num_of_bars(msg_buffer, "MOVE", &remaining_bytes, &num_of_digits, max_index) == 0) {
-                return 0;
-            } else {
-                return 1;
-            }
-        }
-    } else if (check_protocol(msg_buffer, "RSGN") == 1) {
-        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
-            return 0;
-        } else {
-            if (check_num_of_bars(msg_buffer, "RSGN", &remaining_bytes, &num_of_digits, max_index) == 0) {
-                return 0;
-            } else {
-                return 1;
-            }
-        }
-    } else if (check_protocol(msg_buffer, "DRAW") == 1) {
-        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
-            return 0;
-        } else {
-            if (check_num_of_bars(msg_buffer, "DRAW", &remaining_bytes, &num_of_digits, max_index) == 0) {
-                return 0;
-            } else {
-                return 1;
-            }
-        }
-    } else if (check_protocol(msg_buffer, "WAIT") == 1) {
-        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
-            return 0;
-        } else {
-            if (check_num_of_bars(msg_buffer, "WAIT", &remaining_bytes, &num_of_digits, max_index) == 0) {
-                return 0;
-            } else {
-                return 1;
-            }
-        }
-    } else if (check_protocol(msg_buffer, "BEGN") == 1) {
-        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
-            return 0;
-        } else {
-            if (check_num_of_bars(msg_buffer, "BEGN", &remaining_bytes, &num_of_digits, max_index) == 0) {
-                return 0;
-            } else {
-                return 1;
-            }
-        }
-    } else if (check_protocol(msg_buffer, "MOVD") == 1) {
-        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
-            return 0;
-        } else {
-            if (check_num_of_bars(msg_buffer, "MOVD", &remaining_bytes, &num_of_digits, max_index) == 0) {
-                return 0;
-            } else {
-                return 1;
-            }
-        }
-    } else if (check_protocol(msg_buffer, "OVER") == 1) {
-        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
-            return 0;
-        } else {
-            if (check_num_of_bars(msg_buffer, "OVER", &remaining_bytes, &num_of_digits, max_index) == 0) {
-                return 0;
-            } else {
-                return 1;
-            }
+    frame_state state = FRAME_CODE;
+    size_t bar_count = 0;
+    size_t length_offset = 0;
+    size_t num_of_digits = 0;
+    size_t remaining_bytes = 0;
+    size_t max_size = 0;
+    size_t field_offset = 0;
+    view->number_of_fields = 0;
+
+    for (size_t i = 0; ; i++) {
+        switch (state) {
+            case FRAME_CODE:
+                // the 4-character code has to be followed by a bar, and bars in front of the length field are skipped
+                if (msg_buffer[i] == '\0') {
+                    return 0;
+                }
+                if (i < 4) {
+                    continue;
+                }
+                if (i == 4) {
+                    if (msg_buffer[4] != '|' || translate_code(msg_buffer, &view->code) == -1) {
+                        return 0;
+                    }
+                    bar_count++;
+                } else if (msg_buffer[i] == '|') {
+                    bar_count++;
+                } else {
+                    length_offset = i;
+                    state = FRAME_LENGTH;
+                }
+                break;
+            case FRAME_LENGTH:
+                if (msg_buffer[i] != '|' && msg_buffer[i] != '\0') {
+                    continue;
+                }
+
+                // the length field has 1 to 3 digits and gives the number of bytes after it
+                num_of_digits = i - length_offset;
+                if (num_of_digits > MAX_DIGITS ||
+                    parse_length(msg_buffer + length_offset, num_of_digits, &remaining_bytes) == -1) {
+                    return 0;
+                }
+                max_size = 4 + num_of_digits + remaining_bytes + 2;
+
+                // a message that ends among the bars in front of the length field only has those bars
+                if (max_size <= i) {
+                    size_t end = max_size < length_offset ? max_size : length_offset;
+                    if (end - 4 != NUMBER_OF_BARS[view->code] || msg_buffer[max_size - 1] != '|') {
+                        return 0;
+                    }
+                    view->length = max_size;
+                    return 1;
+                }
+                if (msg_buffer[i] == '\0') {
+                    return 0;
+                }
+                bar_count++;
+                field_offset = i + 1;
+                state = FRAME_FIELDS;
+                break;
+            case FRAME_FIELDS:
+                // the message ends after the number of bytes given by the length field, with a bar
+                if (i == max_size) {
+                    if (bar_count != NUMBER_OF_BARS[view->code] || msg_buffer[max_size - 1] != '|') {
+                        return 0;
+                    }
+                    view->length = max_size;
+                    return 1;
+                }
+                if (msg_buffer[i] == '\0') {
+                    return 0;
+                }
+                if (msg_buffer[i] != '|') {
+                    continue;
+                }
+
+                // every bar ends a field, and a message with too many bars can never be complete
+                bar_count++;
+                if (bar_count > NUMBER_OF_BARS[view->code]) {
+                    return 0;
+                }
+                view->field_offsets[view->number_of_fields] = field_offset;
+                view->field_lengths[view->number_of_fields] = i - field_offset;
+                view->number_of_fields++;
+                field_offset = i + 1;
+                break;
         }
-    } else if (check_protocol(msg_buffer, "INVL") == 1) {
-        if (get_remaining_bytes(msg_buffer, &remaining_bytes, &num_of_digits) == -1) {
+    }
+}
+
+// function that translates the 4-character code at the start of the buffer
+// returns -1 on error and 0 on success
+ssize_t translate_code(const char *msg_buffer, message_code *code) {
+    for (size_t i = 0; i < NUMBER_OF_CODES; i++) {
+        if (msg_buffer[0] == CODES[i][0] && msg_buffer[1] == CODES[i][1] &&
+            msg_buffer[2] == CODES[i][2] && msg_buffer[3] == CODES[i][3]) {
+            *code = i;
             return 0;
-        } else {
-            if (check_num_of_bars(msg_buffer, "INVL", &remaining_bytes, &num_of_digits, max_index) == 0) {
-                return 0;
-            } else {
-                return 1;
-            }
         }
-    } else {
-        return 0;
     }
+    return -1;
+}
+
+// function that converts the length field of the given number of characters to a number, just like strtoull()
+// leading white space and a sign are allowed, and the number ends at the first character that is not a digit
+// returns -1 on error and 0 on success
+ssize_t parse_length(const char *str_num, size_t num_of_digits, size_t *length) {
+    size_t i = 0;
+    while (i < num_of_digits && (str_num[i] == ' ' || (str_num[i] >= '\t' && str_num[i] <= '\r'))) {
+        i++;
+    }
+    size_t is_negative = 0;
+    if (i < num_of_digits && (str_num[i] == '+' || str_num[i] == '-')) {
+        is_negative = str_num[i] == '-';
+        i++;
+    }
+    *length = 0;
+    while (i < num_of_digits && str_num[i] >= '0' && str_num[i] <= '9') {
+        *length = *length * 10 + (str_num[i] - '0');
+        i++;
+    }
+
+    // a negative length wraps around to a number larger than any buffer
+    if (num_of_digits == 0 || (is_negative == 1 && *length != 0)) {
+        return -1;
+    }
+    return 0;
 }
 
 // function that gets the number of remaining bytes in the number field of the message
@@ -468,158 +548,124 @@ size_t check_protocol(const char *msg, const char *protocol) {
 }
 
 
-// function that writes the player_name
-// returns -1 on error and 0 on success
-ssize_t parse_play(const char *msg, char **player_name) {
-    // input validation
-    if (msg == NULL || player_name == NULL || strlen(msg) == 0) {
-        return -1;
-    }
-
-    // check if protocol given is play message
-    if (check_protocol(msg, "PLAY") == 0) {
-        return -1;
+// function that decodes the complete message that the view was made from, so it is only tokenized once
+// the fields are checked here, and a message with fields that are not valid is tagged INVL
+void decode_message(const char *msg, const frame *view, message *decoded) {
+    ssize_t result = -1;
+    switch (view->code) {
+        case CODE_PLAY:
+            result = decode_play(msg, view, decoded);
+            break;
+        case CODE_MOVE:
+            result = decode_move(msg, view, decoded);
+            break;
+        case CODE_RSGN:
+            result = 0;
+            break;
+        case CODE_DRAW:
+            result = decode_draw(msg, view, decoded);
+            break;
+        default:
+            break;
     }
+    decoded->code = result == 0 ? view->code : CODE_INVL;
+}
 
-    // tokenize the message
-    size_t num_of_tokens = 0;
-    char **tokens = strTokenize(msg, "|", &num_of_tokens, "");
-    if (tokens == NULL || num_of_tokens == 0) {
+// function that decodes the name field of a PLAY message, which must not be empty
+// returns -1 on error and 0 on success
+ssize_t decode_play(const char *msg, const frame *view, message *decoded) {
+    if (view->number_of_fields != 1 || view->field_lengths[0] == 0) {
         return -1;
     }
-
-    // write name field to player name
-    *player_name = strdup(tokens[2]);
-
-    // free tokens
-    freeArrayOfStrings(tokens, num_of_tokens);
-
+    decoded->fields.play.name = msg + view->field_offsets[0];
+    decoded->fields.play.name_length = view->field_lengths[0];
     return 0;
 }
 
-ssize_t parse_move(const char *msg, char *role, size_t *row, size_t *col) {
-    // input validation
-    if (msg == NULL || role == NULL || row == NULL || col == NULL || strlen(msg) == 0) {
-        return -1;
-    }
-
-    // check if protocol given is move message
-    if (check_protocol(msg, "MOVE") == 0) {
-        return -1;
-    }
-
-    // tokenize the message
-    size_t num_of_tokens = 0;
-    char **tokens = strTokenize(msg, "|", &num_of_tokens, "");
-    if (tokens == NULL || num_of_tokens == 0) {
-        return -1;
-    }
-
-    if (num_of_tokens != 4) {
-        freeArrayOfStrings(tokens, num_of_tokens);
-        return -1;
-    }
-
-    // write to role
-    if ((strcmp(tokens[2], "X") != 0) && (strcmp(tokens[2], "O") != 0)) {
-        freeArrayOfStrings(tokens, num_of_tokens);
-        return -1;
-    } else {
-        *role = tokens[2][0];
-    }
-
-    size_t num_of_tokens_comma = 0;
-    char **tokens_comma = strTokenize(tokens[3], ",", &num_of_tokens, "");
-    if (tokens_comma == NULL) {
-        freeArrayOfStrings(tokens, num_of_tokens);
-        return -1;
-    }
-    if (num_of_tokens != 2) {
-        freeArrayOfStrings(tokens_comma, num_of_tokens_comma);
-        freeArrayOfStrings(tokens, num_of_tokens);
-        return -1;
-    }
-
-    // extract the row and col
-    if (to_unsigned_long(tokens_comma[0], row) == -1) {
-        freeArrayOfStrings(tokens_comma, num_of_tokens_comma);
-        freeArrayOfStrings(tokens, num_of_tokens);
+// function that decodes the role ("X" or "O") and the coordinates ("row,col") of a MOVE message
+// row and col are written from 0 to 2
+// returns -1 on error and 0 on success
+ssize_t decode_move(const char *msg, const frame *view, message *decoded) {
+    if (view->number_of_fields != 2 || view->field_lengths[0] != 1) {
         return -1;
     }
-
-    if (*row < 1 || *row > 3) {
-        freeArrayOfStrings(tokens_comma, num_of_tokens_comma);
-        freeArrayOfStrings(tokens, num_of_tokens);
+    char role = msg[view->field_offsets[0]];
+    if (role != 'X' && role != 'O') {
         return -1;
     }
 
-    *row -= 1;
-
-    if (to_unsigned_long(tokens_comma[1], col) == -1) {
-        freeArrayOfStrings(tokens_comma, num_of_tokens_comma);
-        freeArrayOfStrings(tokens, num_of_tokens);
-        return -1;
+    // the coordinates are the two parts of the field between commas, and empty parts are skipped like the tokenizer does
+    const char *coordinates = msg + view->field_offsets[1];
+    size_t length = view->field_lengths[1];
+    size_t values[2] = {0, 0};
+    size_t num_of_values = 0;
+    for (size_t i = 0; i < length; ) {
+        if (coordinates[i] == ',') {
+            i++;
+            continue;
+        }
+        size_t start = i;
+        while (i < length && coordinates[i] != ',') {
+            i++;
+        }
+        if (num_of_values == 2 || parse_coordinate(coordinates + start, i - start, &values[num_of_values]) == -1) {
+            return -1;
+        }
+        num_of_values++;
     }
-
-    if (*col < 1 || *col > 3) {
-        freeArrayOfStrings(tokens_comma, num_of_tokens_comma);
-        freeArrayOfStrings(tokens, num_of_tokens);
+    if (num_of_values != 2) {
         return -1;
     }
 
-    *col -= 1;
-
-    freeArrayOfStrings(tokens_comma, num_of_tokens_comma);
-    freeArrayOfStrings(tokens, num_of_tokens);
-
+    decoded->fields.move.role = role;
+    decoded->fields.move.row = values[0] - 1;
+    decoded->fields.move.col = values[1] - 1;
     return 0;
 }
 
-ssize_t parse_rsgn(const char *msg) {
-    // input validation
-    if (msg == NULL || strlen(msg) == 0) {
+// function that decodes the action ("S" or "R" or "A") of a DRAW message
+// returns -1 on error and 0 on success
+ssize_t decode_draw(const char *msg, const frame *view, message *decoded) {
+    if (view->number_of_fields != 1 || view->field_lengths[0] != 1) {
         return -1;
     }
-
-    // check if protocol given is rsgn message
-    if (check_protocol(msg, "RSGN") == 0) {
+    char action = msg[view->field_offsets[0]];
+    if (action != 'S' && action != 'R' && action != 'A') {
         return -1;
     }
-
+    decoded->fields.draw.action = action;
     return 0;
 }
 
-ssize_t parse_draw(const char *msg, char *action) {
-    // input validation
-    if (msg == NULL || strlen(msg) == 0) {
-        return -1;
+// function that converts a coordinate of the given number of characters to a number from 1 to 3, just like strtoull()
+// leading white space and a plus sign are allowed, and the number ends at the first character that is not a digit
+// returns -1 on error and 0 on success
+ssize_t parse_coordinate(const char *str_num, size_t num_of_digits, size_t *coordinate) {
+    size_t i = 0;
+    while (i < num_of_digits && (str_num[i] == ' ' || (str_num[i] >= '\t' && str_num[i] <= '\r'))) {
+        i++;
     }
 
-    // check if protocol given is draw message
-    if (check_protocol(msg, "DRAW") == 0) {
+    // a negative coordinate wraps around to a number larger than 3
+    if (i < num_of_digits && str_num[i] == '-') {
         return -1;
     }
-
-    // tokenize the message
-    size_t num_of_tokens = 0;
-    char **tokens = strTokenize(msg, "|", &num_of_tokens, "");
-    if (tokens == NULL || num_of_tokens == 0) {
-        return -1;
+    if (i < num_of_digits && str_num[i] == '+') {
+        i++;
     }
 
-    if (num_of_tokens != 3) {
-        freeArrayOfStrings(tokens, num_of_tokens);
-        return -1;
+    // stop adding digits once the number is too large, so long numbers cannot overflow
+    size_t value = 0;
+    while (i < num_of_digits && str_num[i] >= '0' && str_num[i] <= '9') {
+        if (value <= 3) {
+            value = value * 10 + (str_num[i] - '0');
+        }
+        i++;
     }
-
-    if ((strcmp(tokens[2], "S") != 0) && (strcmp(tokens[2], "R") != 0) && (strcmp(tokens[2], "A") != 0)) {
-        freeArrayOfStrings(tokens, num_of_tokens);
+    if (value < 1 || value > 3) {
         return -1;
     }
-
-    *action = tokens[2][0];
-
-    freeArrayOfStrings(tokens, num_of_tokens);
+    *coordinate = value;
     return 0;
 }
 
@@ -0,0 +1,242 @@
+#include "names.h"
+
+// global variable for the stripes of the set of player names that are currently in the game
+// the stripes are set up once by names_init() before the shards start, and each one is only changed under its lock
+static name_stripe stripes[NAME_STRIPES];
+
+// global variable for the slot that a removed name leaves behind, so probes for other names go on past it
+static char removed_name;
+
+// prototypes of internal functions
+static uint64_t get_name_hash(const char *player_name);
+static name_stripe* lock_stripe(uint64_t hash);
+static void unlock_stripe(name_stripe *stripe);
+static ssize_t find_name(const name_stripe *stripe, uint64_t hash, const char *player_name, size_t *free_index);
+static void resize_stripe(name_stripe *stripe);
+
+// function that sets up the pools of names and every stripe of the set of player names with an empty table
+void names_init() {
+    pool_init(POOL_SHORT_NAME, "short_name", SHORT_NAME_CAPACITY);
+    pool_init(POOL_LONG_NAME, "long_name", LONG_NAME_CAPACITY);
+    for (size_t i = 0; i < NAME_STRIPES; i++) {
+        if (pthread_mutex_init(&stripes[i].mutex, NULL) != 0) {
+            perror("pthread_mutex_init");
+            exit(EXIT_FAILURE);
+        }
+        stripes[i].slots = calloc(NAME_INITIAL_SLOTS, sizeof(name_slot));
+        if (stripes[i].slots == NULL) {
+            perror("calloc");
+            exit(EXIT_FAILURE);
+        }
+        stripes[i].number_of_slots = NAME_INITIAL_SLOTS;
+        stripes[i].number_of_names = 0;
+        stripes[i].number_of_removed = 0;
+    }
+}
+
+// function that copies the name of the given length into the smallest object that fits it and null-terminates it
+// returns NULL on error, otherwise the copy, which is freed with free_player_name()
+char* copy_player_name(const char *name, size_t length) {
+    char *copy = NULL;
+    if (length < SHORT_NAME_CAPACITY) {
+        copy = pool_alloc(POOL_SHORT_NAME);
+    } else if (length < LONG_NAME_CAPACITY) {
+        copy = pool_alloc(POOL_LONG_NAME);
+    } else {
+        copy = malloc(length + 1);
+    }
+    if (copy == NULL) {
+        return NULL;
+    }
+    memcpy(copy, name, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+// function that gives a name from copy_player_name() back to the pool or the heap that its length picked
+// returns NULL, so it can be used like Free()
+char* free_player_name(char *player_name) {
+    if (player_name == NULL) {
+        return NULL;
+    }
+    size_t length = strlen(player_name);
+    if (length < SHORT_NAME_CAPACITY) {
+        pool_free(POOL_SHORT_NAME, player_name);
+    } else if (length < LONG_NAME_CAPACITY) {
+        pool_free(POOL_LONG_NAME, player_name);
+    } else {
+        free(player_name);
+    }
+    return NULL;
+}
+
+// function that adds a player's name to the set of player names unless it is taken
+// the check and the insert happen under the lock of one stripe, so two shards can never add the same name
+// the set keeps a pointer to the name, which has to stay valid until the name is removed
+// returns 1 if the name is taken and 0 if it was added
+size_t add_player_name(const char *player_name) {
+    // if player_name is NULL or empty, it cannot be added
+    if (player_name == NULL || player_name[0] == '\0') {
+        return 1;
+    }
+
+    uint64_t hash = get_name_hash(player_name);
+    name_stripe *stripe = lock_stripe(hash);
+
+    // if the player name is in the stripe, it is taken
+    size_t free_index = 0;
+    if (find_name(stripe, hash, player_name, &free_index) != -1) {
+        unlock_stripe(stripe);
+        return 1;
+    }
+
+    // keep at least half of the slots empty, so probes stay short, and look for a free slot again after a resize
+    if ((stripe->number_of_names + stripe->number_of_removed + 1) * 2 > stripe->number_of_slots) {
+        resize_stripe(stripe);
+        find_name(stripe, hash, player_name, &free_index);
+    }
+
+    if (stripe->slots[free_index].name == &removed_name) {
+        stripe->number_of_removed--;
+    }
+    stripe->slots[free_index].hash = hash;
+    stripe->slots[free_index].name = player_name;
+    __atomic_store_n(&stripe->number_of_names, stripe->number_of_names + 1, __ATOMIC_RELAXED);
+
+    unlock_stripe(stripe);
+    return 0;
+}
+
+// function that removes a player's name from the set of player names
+void remove_player_name(const char *player_name) {
+    // if player_name is NULL, do nothing
+    if (player_name == NULL || player_name[0] == '\0') {
+        return;
+    }
+
+    uint64_t hash = get_name_hash(player_name);
+    name_stripe *stripe = lock_stripe(hash);
+
+    // the slot of the name is left behind as removed, since other names may have probed past it
+    size_t free_index = 0;
+    ssize_t index = find_name(stripe, hash, player_name, &free_index);
+    if (index != -1) {
+        stripe->slots[index].name = &removed_name;
+        __atomic_store_n(&stripe->number_of_names, stripe->number_of_names - 1, __ATOMIC_RELAXED);
+        stripe->number_of_removed++;
+    }
+
+    unlock_stripe(stripe);
+}
+
+// function that checks if a player's name is in the set of player names
+size_t is_player_name_taken(const char *player_name) {
+    // if player_name is NULL, return 1
+    if (player_name == NULL || player_name[0] == '\0') {
+        return 1;
+    }
+
+    uint64_t hash = get_name_hash(player_name);
+    name_stripe *stripe = lock_stripe(hash);
+    size_t free_index = 0;
+    size_t is_taken = find_name(stripe, hash, player_name, &free_index) != -1;
+    unlock_stripe(stripe);
+    return is_taken;
+}
+
+// function that returns the number of names in the set of player names
+// the count of each stripe is read without its lock, so counting never makes a shard wait for a stripe
+size_t get_number_of_names() {
+    size_t number_of_names = 0;
+    for (size_t i = 0; i < NAME_STRIPES; i++) {
+        number_of_names += __atomic_load_n(&stripes[i].number_of_names, __ATOMIC_RELAXED);
+    }
+    return number_of_names;
+}
+
+// function that returns the 64-bit FNV-1a hash of the name
+static uint64_t get_name_hash(const char *player_name) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char *byte = (const unsigned char *) player_name; *byte != '\0'; byte++) {
+        hash = (hash ^ *byte) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// function that obtains the lock of the stripe that the hash picks and returns the stripe
+// the low bits of the hash pick the stripe and the bits above them pick the slot, so the two do not depend on each other
+static name_stripe* lock_stripe(uint64_t hash) {
+    name_stripe *stripe = &stripes[hash & (NAME_STRIPES - 1)];
+    if (pthread_mutex_lock(&stripe->mutex) != 0) {
+        perror("pthread_mutex_lock");
+        exit(EXIT_FAILURE);
+    }
+    return stripe;
+}
+
+// function that releases the lock of the stripe
+static void unlock_stripe(name_stripe *stripe) {
+    if (pthread_mutex_unlock(&stripe->mutex) != 0) {
+        perror("pthread_mutex_unlock");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// function that probes the stripe for the name, starting at the slot that its hash picks
+// writes the index of the first slot that is free for the name, which is a removed slot or the empty slot that ended
+// the probe, the stripe always has an empty slot because at least half of its slots are empty
+// returns the index of the slot of the name, or -1 if the name is not in the stripe
+static ssize_t find_name(const name_stripe *stripe, uint64_t hash, const char *player_name, size_t *free_index) {
+    size_t mask = stripe->number_of_slots - 1;
+    size_t has_free_index = 0;
+    for (size_t index = (hash / NAME_STRIPES) & mask;; index = (index + 1) & mask) {
+        const name_slot *slot = &stripe->slots[index];
+        if (slot->name == NULL) {
+            if (has_free_index == 0) {
+                *free_index = index;
+            }
+            return -1;
+        }
+        if (slot->name == &removed_name) {
+            if (has_free_index == 0) {
+                *free_index = index;
+                has_free_index = 1;
+            }
+        } else if (slot->hash == hash && strcmp(slot->name, player_name) == 0) {
+            return (ssize_t) index;
+        }
+    }
+}
+
+// function that moves the names of the stripe to a new table without the removed slots
+// the table doubles when the names alone fill a quarter of it, otherwise it keeps its size
+static void resize_stripe(name_stripe *stripe) {
+    size_t number_of_slots = stripe->number_of_slots;
+    if ((stripe->number_of_names + 1) * 4 > number_of_slots) {
+        number_of_slots *= 2;
+    }
+    name_slot *slots = calloc(number_of_slots, sizeof(name_slot));
+    if (slots == NULL) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+
+    // every name goes to the first empty slot from the slot that its hash picks, since the new table has no removed slots
+    size_t mask = number_of_slots - 1;
+    for (size_t i = 0; i < stripe->number_of_slots; i++) {
+        name_slot *slot = &stripe->slots[i];
+        if (slot->name == NULL || slot->name == &removed_name) {
+            continue;
+        }
+        size_t index = (slot->hash / NAME_STRIPES) & mask;
+        while (slots[index].name != NULL) {
+            index = (index + 1) & mask;
+        }
+        slots[index] = *slot;
+    }
+
+    Free(stripe->slots);
+    stripe->slots = slots;
+    stripe->number_of_slots = number_of_slots;
+    stripe->number_of_removed = 0;
+}
@@ -0,0 +1,47 @@
+#ifndef P3_NAMES_H
+#define P3_NAMES_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "pool.h"
+
+// declare enumeration for constants of the set of player names
+// the number of stripes and the number of slots of a stripe must be powers of 2
+// a name and its null terminator take an object of the short or the long pool of names, whichever is the first that
+// fits it, and a longer name is allocated from the heap
+typedef enum names_constant {
+    NAME_STRIPES = 64,
+    NAME_INITIAL_SLOTS = 16,
+    SHORT_NAME_CAPACITY = 64,
+    LONG_NAME_CAPACITY = 256,
+} names_constant;
+
+// define struct for a slot of a stripe, which is empty, points to a name or is left behind by a name that was removed
+// the name belongs to the client that added it, which keeps it until it is removed, so the set holds no copy of it
+// the hash of the name is kept next to it, so a probe only compares the names when their hashes are equal
+typedef struct name_slot {
+    uint64_t hash;
+    const char *name;
+} name_slot;
+
+// define struct for a stripe of the set of player names, which is an open-addressing hash table with its own lock
+// a name always goes to the stripe picked by its hash, so shards only wait for each other on the same stripe
+// every stripe starts on its own cache line, so taking the lock of one stripe does not slow down the others
+typedef struct name_stripe {
+    pthread_mutex_t mutex;
+    name_slot *slots;
+    size_t number_of_slots;
+    size_t number_of_names;
+    size_t number_of_removed;
+} __attribute__((aligned(CACHE_LINE_SIZE))) name_stripe;
+
+// prototypes of all functions
+void names_init();
+char* copy_player_name(const char *name, size_t length);
+char* free_player_name(char *player_name);
+size_t add_player_name(const char *player_name);
+void remove_player_name(const char *player_name);
+size_t is_player_name_taken(const char *player_name);
+size_t get_number_of_names();
+
+#endif //P3_NAMES_H
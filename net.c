@@ -1,8 +1,28 @@
+#define _DEFAULT_SOURCE
 #include "net.h"
 
+// prototypes of internal functions
+static int listen_on_port(const char *host, const char *port, int is_shared);
+
 // function that creates and returns a server socket bound to the localhost and the given port
+// a shared server socket sets SO_REUSEPORT, so several of them can listen on the same port and the kernel
+// spreads the incoming connections across them
+// returns -1 on error
+int create_server_socket(const char *port, int is_shared) {
+    return listen_on_port(NULL, port, is_shared);
+}
+
+// function that creates and returns a server socket bound to the IPv4 loopback address and the given port, so only
+// processes on the same host can connect to it
+// returns -1 on error
+int create_loopback_socket(const char *port) {
+    return listen_on_port("127.0.0.1", port, 0);
+}
+
+// function that creates and returns a server socket bound to the given numeric host and port, or to every address of
+// the port if host is NULL
 // returns -1 on error
-int create_server_socket(const char *port) {
+static int listen_on_port(const char *host, const char *port, int is_shared) {
     // if port is NULL, return -1
     if (port == NULL) {
         return -1;
@@ -19,10 +39,10 @@ int create_server_socket(const char *port) {
     hints.ai_family = AF_UNSPEC;
     hints.ai_socktype = SOCK_STREAM;
     hints.ai_protocol = IPPROTO_TCP;
-    hints.ai_flags = AI_PASSIVE;
+    hints.ai_flags = host == NULL ? AI_PASSIVE : AI_NUMERICHOST;
 
     // get address info and check for errors
-    error = getaddrinfo(NULL, port, &hints, &info_list);
+    error = getaddrinfo(host, port, &hints, &info_list);
     if (error) {
         return -1;
     }
@@ -35,6 +55,18 @@ int create_server_socket(const char *port) {
             continue;
         }
 
+        // allow the address to be bound again while connections that the server closed are in TIME_WAIT, and allow
+        // other shared server sockets to bind to the same address and check for errors
+        int option = 1;
+        if (setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option)) != 0) {
+            close(server_socket);
+            continue;
+        }
+        if (is_shared && setsockopt(server_socket, SOL_SOCKET, SO_REUSEPORT, &option, sizeof(option)) != 0) {
+            close(server_socket);
+            continue;
+        }
+
         // bind socket to address and check for errors
         if (bind(server_socket, info->ai_addr, info->ai_addrlen) != 0) {
             close(server_socket);
@@ -120,9 +152,9 @@ int create_client_socket(const char *host, const char *port) {
 }
 
 // function that accepts an incoming connection on the given server socket and returns the client socket
-// sets the given host and port pointers to new allocated strings containing the numeric host and port of the client
+// writes the numeric host and port of the client to the given buffers of NUMERIC_HOST_LENGTH and NUMERIC_PORT_LENGTH
 // returns -1 on error
-int accept_incoming_connection(int server_socket, char **host, char **port) {
+int accept_incoming_connection(int server_socket, char *host, char *port) {
     // if server socket is invalid, return -1
     if (server_socket < 0) {
         return -1;
@@ -133,50 +165,55 @@ int accept_incoming_connection(int server_socket, char **host, char **port) {
         return -1;
     }
 
-    // initialize host and port pointers to NULL
-    *host = NULL;
-    *port = NULL;
-
     // accept incoming connection and check for errors
-    struct sockaddr_storage client_address;
-    socklen_t client_address_length = sizeof(struct sockaddr_storage);
-    int client_socket = accept(server_socket, (struct sockaddr *) &client_address, &client_address_length);
+    int client_socket = accept(server_socket, NULL, NULL);
     if (client_socket == -1) {
         return -1;
     }
 
     // get numeric host and port of client and check for errors
-    *host = malloc(sizeof(char) * NI_MAXHOST);
-    if (*host == NULL) {
+    if (get_peer_name(client_socket, host, port) == -1) {
         close(client_socket);
         return -1;
     }
-    *port = malloc(sizeof(char) * NI_MAXSERV);
-    if (*port == NULL) {
-        close(client_socket);
-        *host = Free(*host);
+
+    // return client socket
+    return client_socket;
+}
+
+// function that writes the numeric host and port of the peer that the given socket is connected to, to the given
+// buffers of NUMERIC_HOST_LENGTH and NUMERIC_PORT_LENGTH
+// returns -1 on error and 0 on success
+int get_peer_name(int socket, char *host, char *port) {
+    // if socket is invalid or host or port is NULL, return -1
+    if (socket < 0 || host == NULL || port == NULL) {
         return -1;
     }
 
+    // get the address of the peer
+    struct sockaddr_storage client_address;
+    socklen_t client_address_length = sizeof(struct sockaddr_storage);
+    if (getpeername(socket, (struct sockaddr *) &client_address, &client_address_length) == -1) {
+        return -1;
+    }
+
+    // get numeric host and port of the peer and check for errors
     int error = getnameinfo(
             (struct sockaddr *) &client_address,
             client_address_length,
-            *host,
-            NI_MAXHOST,
-            *port,
-            NI_MAXSERV,
+            host,
+            NUMERIC_HOST_LENGTH,
+            port,
+            NUMERIC_PORT_LENGTH,
             NI_NUMERICHOST | NI_NUMERICSERV
     );
 
     if (error) {
-        close(client_socket);
-        *host = Free(*host);
-        *port = Free(*port);
         return -1;
     }
 
-    // return client socket
-    return client_socket;
+    // return 0 on success
+    return 0;
 }
 
 // function that receives a message from the given socket and returns a new allocated string containing the message
@@ -276,7 +313,10 @@ char* receive_message(int socket, size_t *length) {
 }
 
 // function that sends the given message to the given socket
-// returns 0 on success and -1 on error
+// a non-blocking socket whose send buffer is full is not waited for, so a client that does not read can never stall the
+// caller, and the caller keeps the bytes that were not written until the socket is writable again
+// returns -1 on error and the number of bytes written on success, which is less than the length if the send buffer of a
+// non-blocking socket filled up
 ssize_t send_message(int socket, const char *message, size_t length) {
     // if socket is invalid, return -1
     if (socket < 0) {
@@ -293,86 +333,187 @@ ssize_t send_message(int socket, const char *message, size_t length) {
         return 0;
     }
 
-    // send message to the socket using write() and check for errors
-    ssize_t bytes_written = write(socket, message, length);
-    if (bytes_written == -1) {
-        return -1;
-    }
-
-    // if the number of bytes written is not equal to the length, keep writing until all bytes are written
+    // send message to the socket using write() and keep writing until all bytes are written or the send buffer is full
+    size_t bytes_written = 0;
     while (bytes_written < length) {
         ssize_t write_status = write(socket, message + bytes_written, length - bytes_written);
         if (write_status == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
             return -1;
         }
         bytes_written += write_status;
     }
 
-    // return 0 on success
-    return 0;
+    // return the number of bytes written on success
+    return bytes_written;
 }
 
-// function that polls the given list of sockets and returns the index of the socket that has data to be read
-// returns -1 on error or poll timed out (in milliseconds)
-ssize_t get_readable_socket(const int *sockets, size_t number_of_sockets, int timeout) {
-    // if sockets is NULL, return -1
-    if (sockets == NULL) {
+// function that sends every given message to the socket with as few writev() calls as possible, in one if the socket
+// takes every byte, so messages that are sent at the same time leave in as few TCP segments as possible
+// a non-blocking socket whose send buffer is full is not waited for, so the caller keeps the bytes that were not written
+// until the socket is writable again
+// the given messages are changed to point past the bytes that were written, so a message that was written completely
+// is left empty
+// returns -1 on error and the number of bytes written on success, which is less than the length of the messages if the
+// send buffer of a non-blocking socket filled up
+ssize_t send_messages(int socket, struct iovec *messages, int number_of_messages) {
+    // if socket is invalid, return -1
+    if (socket < 0) {
         return -1;
     }
 
-    // if number_of_sockets is 0, return -1
-    if (number_of_sockets == 0) {
+    size_t total_written = 0;
+    while (number_of_messages > 0) {
+        ssize_t write_status = writev(socket, messages, number_of_messages);
+        if (write_status == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return -1;
+        }
+        total_written += write_status;
+
+        // skip the messages that were written completely, and the part of the next one that was written
+        size_t bytes_written = write_status;
+        while (number_of_messages > 0 && bytes_written >= messages->iov_len) {
+            bytes_written -= messages->iov_len;
+            messages->iov_base = (char *) messages->iov_base + messages->iov_len;
+            messages->iov_len = 0;
+            messages++;
+            number_of_messages--;
+        }
+        if (number_of_messages > 0) {
+            messages->iov_base = (char *) messages->iov_base + bytes_written;
+            messages->iov_len -= bytes_written;
+        }
+    }
+
+    // return the number of bytes written on success
+    return total_written;
+}
+
+// function that waits for the timeout (in milliseconds) until the socket has data to be read, or has been closed
+// returns -1 on error or when the timeout expires, and 0 when the socket is readable
+ssize_t wait_for_readable(int socket, int timeout) {
+    // if socket is invalid, return -1
+    if (socket < 0) {
         return -1;
     }
 
-    // allocate memory for pollfd array
-    struct pollfd *poll_sockets = malloc(sizeof(struct pollfd) * number_of_sockets);
-    if (poll_sockets == NULL) {
+    struct pollfd poll_socket;
+    memset(&poll_socket, 0, sizeof(struct pollfd));
+    poll_socket.fd = socket;
+    poll_socket.events = POLLIN;
+    if (poll(&poll_socket, 1, timeout) <= 0) {
         return -1;
     }
+    return 0;
+}
 
-    // memset pollfd array to 0
-    memset(poll_sockets, 0, sizeof(struct pollfd) * number_of_sockets);
+// function that puts the given socket into non-blocking mode
+// returns 0 on success and -1 on error
+int set_socket_nonblocking(int socket) {
+    // if socket is invalid, return -1
+    if (socket < 0) {
+        return -1;
+    }
 
-    // initialize pollfd array
-    for (size_t i = 0; i < number_of_sockets; i++) {
-        poll_sockets[i].fd = sockets[i];
-        poll_sockets[i].events = POLLIN;
+    // get the current flags of the socket and add O_NONBLOCK
+    int flags = fcntl(socket, F_GETFL, 0);
+    if (flags == -1) {
+        return -1;
+    }
+    if (fcntl(socket, F_SETFL, flags | O_NONBLOCK) == -1) {
+        return -1;
     }
 
-    // poll sockets for the timeout period and check for errors
-    int poll_result = poll(poll_sockets, number_of_sockets, timeout);
+    // return 0 on success
+    return 0;
+}
+
+// function that creates an event loop (epoll instance) that sockets can be registered with
+// returns -1 on error
+int create_event_loop(void) {
+    return epoll_create1(0);
+}
+
+// function that creates the event loop of a readiness set, which starts out with no ready sockets
+// returns 0 on success and -1 on error
+int readiness_set_init(readiness_set *set) {
+    set->number_of_ready = 0;
+    set->event_loop = create_event_loop();
+    return set->event_loop == -1 ? -1 : 0;
+}
 
-    // if poll() returned an error, free poll_sockets and return -1
-    if (poll_result <= -1) {
-        Free(poll_sockets);
+// function that waits for the timeout (in milliseconds) until a socket of the set is ready and keeps every ready
+// socket in the set, a timeout of -1 waits indefinitely
+// the kernel moves a level-triggered socket to the back of its ready list once it is returned, and a wait that fills
+// the set leaves the rest for the next wait, so no socket waits more than one turn of every other ready socket
+// returns the number of ready sockets, or -1 on error
+int wait_for_ready(readiness_set *set, int timeout) {
+    set->number_of_ready = 0;
+    int number_of_ready = epoll_wait(set->event_loop, set->ready, MAX_READY_SOCKETS, timeout);
+    if (number_of_ready == -1) {
         return -1;
     }
+    set->number_of_ready = number_of_ready;
+    return number_of_ready;
+}
 
-    // if poll() returned 0, free poll_sockets and return -1
-    if (poll_result == 0) {
-        Free(poll_sockets);
+// function that registers the given socket with the event loop as level-triggered and readable
+// the data pointer is handed back with every event for the socket
+// returns 0 on success and -1 on error
+int watch_socket(int event_loop, int socket, void *data) {
+    // if event loop or socket is invalid, return -1
+    if (event_loop < 0 || socket < 0) {
         return -1;
     }
 
-    // if poll() returns more than the number of sockets, then there is an error so free poll_sockets and return -1
-    if (poll_result > number_of_sockets) {
-        Free(poll_sockets);
+    // register the socket for input, peer hang up and errors in level-triggered mode
+    struct epoll_event event;
+    memset(&event, 0, sizeof(struct epoll_event));
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.ptr = data;
+
+    if (epoll_ctl(event_loop, EPOLL_CTL_ADD, socket, &event) == -1) {
         return -1;
     }
 
-    // at this point poll() returned the number of sockets that may have data to be read
-    // loop through poll_sockets and check if revents is POLLIN
-    ssize_t index = 0;
-    for (size_t i = 0; i < number_of_sockets; i++, index++) {
-        if (poll_sockets[i].revents & POLLIN) {
-            Free(poll_sockets);
-            return index;
-        }
+    // return 0 on success
+    return 0;
+}
+
+// function that changes which events the event loop reports for the given socket that is already registered with it
+// a socket is watched for input and peer hang up while is_reading is 1, and for room in its send buffer while
+// is_writing is 1, and errors are always reported
+// returns 0 on success and -1 on error
+int rewatch_socket(int event_loop, int socket, void *data, int is_reading, int is_writing) {
+    // if event loop or socket is invalid, return -1
+    if (event_loop < 0 || socket < 0) {
+        return -1;
     }
 
-    // at this point, if no sockets have data to be read, then there is an error so free poll_sockets and return -1
-    Free(poll_sockets);
-    return -1;
+    struct epoll_event event;
+    memset(&event, 0, sizeof(struct epoll_event));
+    event.events = (is_reading == 1 ? EPOLLIN | EPOLLRDHUP : 0) | (is_writing == 1 ? EPOLLOUT : 0);
+    event.data.ptr = data;
+    return epoll_ctl(event_loop, EPOLL_CTL_MOD, socket, &event);
 }
 
+// function that removes the given socket from the event loop, so it can be registered with another one
+// returns 0 on success and -1 on error
+int unwatch_socket(int event_loop, int socket) {
+    // if event loop or socket is invalid, return -1
+    if (event_loop < 0 || socket < 0) {
+        return -1;
+    }
+    return epoll_ctl(event_loop, EPOLL_CTL_DEL, socket, NULL);
+}
@@ -13,20 +13,45 @@
 #include <unistd.h>
 #include <netdb.h>
 #include <poll.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
 #include "helper.h"
 
 // declare enumeration for constants
+// a numeric host is at most an IPv6 address, a '%' and the name of an interface, and a numeric port is at most 5 digits
 typedef enum constant {
-    NI_MAXSERV = 32,
-    NI_MAXHOST = 1025,
+    NUMERIC_HOST_LENGTH = 64,
+    NUMERIC_PORT_LENGTH = 8,
+    MAX_READY_SOCKETS = 64,
 } constant;
 
+// define struct for the sockets that a worker watches for input, which is built once and reused by every wait
+// a wait returns every socket that is ready, up to the capacity of the set, in the order they became ready
+// sockets are watched level-triggered, so a socket that still has input after its turn is returned again by the next
+// wait behind the sockets that were ready before it, and every socket gets its turn in round-robin order
+typedef struct readiness_set {
+    int event_loop;
+    int number_of_ready;
+    struct epoll_event ready[MAX_READY_SOCKETS];
+} readiness_set;
+
 // prototypes of all functions
-int create_server_socket(const char *port);
+int create_server_socket(const char *port, int is_shared);
+int create_loopback_socket(const char *port);
 int create_client_socket(const char *host, const char *port);
-int accept_incoming_connection(int server_socket, char **host, char **port);
+int accept_incoming_connection(int server_socket, char *host, char *port);
+int get_peer_name(int socket, char *host, char *port);
 char* receive_message(int socket, size_t *length);
 ssize_t send_message(int socket, const char *message, size_t length);
-ssize_t get_readable_socket(const int *sockets, size_t number_of_sockets, int timeout);
+ssize_t send_messages(int socket, struct iovec *messages, int number_of_messages);
+ssize_t wait_for_readable(int socket, int timeout);
+int set_socket_nonblocking(int socket);
+int create_event_loop(void);
+int readiness_set_init(readiness_set *set);
+int wait_for_ready(readiness_set *set, int timeout);
+int watch_socket(int event_loop, int socket, void *data);
+int rewatch_socket(int event_loop, int socket, void *data, int is_reading, int is_writing);
+int unwatch_socket(int event_loop, int socket);
 
 #endif //P3_NET_H
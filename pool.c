@@ -0,0 +1,166 @@
+#include "pool.h"
+
+// with AddressSanitizer, a free object is poisoned except for its link, so a use after free is still reported
+#ifdef __SANITIZE_ADDRESS__
+#include <sanitizer/asan_interface.h>
+#define POISON_OBJECT(object, size) ASAN_POISON_MEMORY_REGION((char *) (object) + sizeof(pool_object), \
+                                                              (size) - sizeof(pool_object))
+#define UNPOISON_OBJECT(object, size) ASAN_UNPOISON_MEMORY_REGION((object), (size))
+#else
+#define POISON_OBJECT(object, size) ((void) (object), (void) (size))
+#define UNPOISON_OBJECT(object, size) ((void) (object), (void) (size))
+#endif
+
+// global variables for the pools of every kind of object and the caches of the current thread
+// the pools are set up by pool_init() before the threads that use them start
+static object_pool pools[NUMBER_OF_POOLS];
+static __thread pool_cache caches[NUMBER_OF_POOLS];
+
+// prototypes of internal functions
+static void lock_pool(object_pool *pool);
+static void unlock_pool(object_pool *pool);
+static ssize_t refill_cache(object_pool *pool, pool_cache *cache);
+static void return_batch(object_pool *pool, pool_cache *cache);
+static void store_counter(size_t *counter, size_t value);
+
+// function that sets up the pool of the given kind for objects of the given size
+// the size is rounded up to whole cache lines, so objects that different threads use never share a cache line
+void pool_init(pool_kind kind, const char *name, size_t object_size) {
+    object_pool *pool = &pools[kind];
+    if (pthread_mutex_init(&pool->mutex, NULL) != 0) {
+        perror("pthread_mutex_init");
+        exit(EXIT_FAILURE);
+    }
+    pool->name = name;
+    pool->object_size = (object_size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    pool->free_objects = NULL;
+    pool->number_of_free = 0;
+    pool->number_of_slabs = 0;
+    pool->number_of_refills = 0;
+    pool->number_of_returns = 0;
+}
+
+// function that takes an object from the cache of the current thread, which is refilled from the pool when it is empty
+// returns NULL on error, otherwise the object, whose bytes are not cleared
+void* pool_alloc(pool_kind kind) {
+    object_pool *pool = &pools[kind];
+    pool_cache *cache = &caches[kind];
+    if (cache->free_objects == NULL && refill_cache(pool, cache) == -1) {
+        return NULL;
+    }
+    pool_object *object = cache->free_objects;
+    UNPOISON_OBJECT(object, pool->object_size);
+    cache->free_objects = object->next;
+    cache->number_of_free--;
+    return object;
+}
+
+// function that gives an object back to the cache of the current thread, which may be another thread than the one
+// that took it, and hands a batch back to the pool when the cache holds too many
+// returns NULL, so it can be used like Free()
+void* pool_free(pool_kind kind, void *object) {
+    if (object == NULL) {
+        return NULL;
+    }
+    object_pool *pool = &pools[kind];
+    pool_cache *cache = &caches[kind];
+    pool_object *free_object = object;
+    free_object->next = cache->free_objects;
+    cache->free_objects = free_object;
+    cache->number_of_free++;
+    POISON_OBJECT(free_object, pool->object_size);
+    if (cache->number_of_free >= 2 * POOL_BATCH) {
+        return_batch(pool, cache);
+    }
+    return NULL;
+}
+
+// function that copies the counters of the pool of the given kind without taking its lock, so reading them never makes
+// a thread that refills its cache wait, and counters that change in the meantime may be one batch apart
+void pool_get_stats(pool_kind kind, pool_stats *stats) {
+    object_pool *pool = &pools[kind];
+    stats->name = pool->name;
+    stats->object_size = pool->object_size;
+    stats->number_of_slabs = __atomic_load_n(&pool->number_of_slabs, __ATOMIC_RELAXED);
+    stats->number_of_objects = stats->number_of_slabs * POOL_SLAB_OBJECTS;
+    stats->number_of_free = __atomic_load_n(&pool->number_of_free, __ATOMIC_RELAXED);
+    stats->number_of_refills = __atomic_load_n(&pool->number_of_refills, __ATOMIC_RELAXED);
+    stats->number_of_returns = __atomic_load_n(&pool->number_of_returns, __ATOMIC_RELAXED);
+}
+
+// function that obtains the mutex lock of the pool
+static void lock_pool(object_pool *pool) {
+    if (pthread_mutex_lock(&pool->mutex) != 0) {
+        perror("pthread_mutex_lock");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// function that releases the mutex lock of the pool
+static void unlock_pool(object_pool *pool) {
+    if (pthread_mutex_unlock(&pool->mutex) != 0) {
+        perror("pthread_mutex_unlock");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// function that moves a batch of free objects from the pool to the empty cache, and carves a new slab out of the heap
+// when the pool has no free objects left
+// returns -1 on error and 0 on success
+static ssize_t refill_cache(object_pool *pool, pool_cache *cache) {
+    lock_pool(pool);
+    if (pool->free_objects == NULL) {
+        char *slab = malloc(pool->object_size * POOL_SLAB_OBJECTS);
+        if (slab == NULL) {
+            unlock_pool(pool);
+            return -1;
+        }
+        for (size_t i = POOL_SLAB_OBJECTS; i > 0; i--) {
+            pool_object *object = (pool_object *) (slab + (i - 1) * pool->object_size);
+            object->next = pool->free_objects;
+            pool->free_objects = object;
+            POISON_OBJECT(object, pool->object_size);
+        }
+        store_counter(&pool->number_of_free, pool->number_of_free + POOL_SLAB_OBJECTS);
+        store_counter(&pool->number_of_slabs, pool->number_of_slabs + 1);
+    }
+
+    // the links of free objects are never poisoned, so the batch can be split off without touching the rest
+    pool_object *last = pool->free_objects;
+    size_t number_of_objects = 1;
+    while (number_of_objects < POOL_BATCH && last->next != NULL) {
+        last = last->next;
+        number_of_objects++;
+    }
+    cache->free_objects = pool->free_objects;
+    cache->number_of_free = number_of_objects;
+    pool->free_objects = last->next;
+    store_counter(&pool->number_of_free, pool->number_of_free - number_of_objects);
+    last->next = NULL;
+    store_counter(&pool->number_of_refills, pool->number_of_refills + 1);
+    unlock_pool(pool);
+    return 0;
+}
+
+// function that moves a batch of free objects from the cache back to the pool, so another thread can take them
+static void return_batch(object_pool *pool, pool_cache *cache) {
+    pool_object *first = cache->free_objects;
+    pool_object *last = first;
+    for (size_t i = 1; i < POOL_BATCH; i++) {
+        last = last->next;
+    }
+    cache->free_objects = last->next;
+    cache->number_of_free -= POOL_BATCH;
+
+    lock_pool(pool);
+    last->next = pool->free_objects;
+    pool->free_objects = first;
+    store_counter(&pool->number_of_free, pool->number_of_free + POOL_BATCH);
+    store_counter(&pool->number_of_returns, pool->number_of_returns + 1);
+    unlock_pool(pool);
+}
+
+// function that stores a counter of a pool, which is only changed under the lock of the pool but read without it
+static void store_counter(size_t *counter, size_t value) {
+    __atomic_store_n(counter, value, __ATOMIC_RELAXED);
+}
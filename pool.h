@@ -0,0 +1,67 @@
+#ifndef P3_POOL_H
+#define P3_POOL_H
+
+#include <pthread.h>
+#include "helper.h"
+
+// declare enumeration for the kinds of objects that come from a pool instead of the heap
+typedef enum pool_kind {
+    POOL_CLIENT = 0,
+    POOL_GAME = 1,
+    POOL_SHORT_OUTPUT = 2,
+    POOL_LONG_OUTPUT = 3,
+    POOL_HANDOFF = 4,
+    POOL_SHORT_NAME = 5,
+    POOL_LONG_NAME = 6,
+    NUMBER_OF_POOLS = 7,
+} pool_kind;
+
+// declare enumeration for constants of the pools
+typedef enum pool_constant {
+    POOL_SLAB_OBJECTS = 64,
+    POOL_BATCH = 32,
+} pool_constant;
+
+// define struct for a free object of a pool, which links to the next free object
+typedef struct pool_object {
+    struct pool_object *next;
+} pool_object;
+
+// define struct for the objects of one pool that a thread keeps for itself, so it takes and frees them without a lock
+typedef struct pool_cache {
+    pool_object *free_objects;
+    size_t number_of_free;
+} pool_cache;
+
+// define struct for a pool of objects of one size that are carved out of slabs, which are never given back to the heap
+// threads move free objects between their caches and the pool in batches, under the mutex lock of the pool
+typedef struct object_pool {
+    pthread_mutex_t mutex;
+    const char *name;
+    size_t object_size;
+    pool_object *free_objects;
+    size_t number_of_free;
+    size_t number_of_slabs;
+    size_t number_of_refills;
+    size_t number_of_returns;
+} object_pool;
+
+// define struct for the counters of a pool
+// the objects that are not free in the pool are in use or kept in the cache of a thread
+typedef struct pool_stats {
+    const char *name;
+    size_t object_size;
+    size_t number_of_slabs;
+    size_t number_of_objects;
+    size_t number_of_free;
+    size_t number_of_refills;
+    size_t number_of_returns;
+} pool_stats;
+
+// prototypes of all functions
+void pool_init(pool_kind kind, const char *name, size_t object_size);
+void* pool_alloc(pool_kind kind);
+void* pool_free(pool_kind kind, void *object);
+void pool_get_stats(pool_kind kind, pool_stats *stats);
+
+#endif //P3_POOL_H
@@ -0,0 +1,129 @@
+#include "queue.h"
+
+// prototypes of internal functions
+static void queue_restore(byte_queue *queue);
+static void queue_compact(byte_queue *queue);
+
+// function that initializes an empty queue
+void queue_init(byte_queue *queue) {
+    queue->start = 0;
+    queue->end = 0;
+    queue->is_taken = 0;
+    queue->next_byte = '\0';
+    queue->data[0] = '\0';
+}
+
+// function that returns the number of unread bytes in the queue
+size_t queue_length(const byte_queue *queue) {
+    return queue->end - queue->start;
+}
+
+// function that checks if the queue has no room for another byte
+// a full queue that does not start with a complete message can never hold one
+size_t queue_is_full(const byte_queue *queue) {
+    return queue_length(queue) == QUEUE_CAPACITY;
+}
+
+// function that returns the unread bytes of the queue as a null-terminated string
+char* queue_peek(byte_queue *queue) {
+    queue_restore(queue);
+    return queue->data + queue->start;
+}
+
+// function that returns the free space at the end of the queue and its length, so bytes can be read straight into it
+// the unread bytes are only moved to the front when the free space has run out at the end
+char* queue_get_space(byte_queue *queue, size_t *length) {
+    queue_restore(queue);
+    if (queue->end == QUEUE_CAPACITY) {
+        queue_compact(queue);
+    }
+    *length = QUEUE_CAPACITY - queue->end;
+    return queue->data + queue->end;
+}
+
+// function that adds the given number of bytes that were written into the free space to the queue
+void queue_commit(byte_queue *queue, size_t length) {
+    queue->end += length;
+    queue->data[queue->end] = '\0';
+}
+
+// function that copies the given bytes to the end of the queue
+// returns -1 on error and 0 on success
+ssize_t queue_push(byte_queue *queue, const char *bytes, size_t length) {
+    queue_restore(queue);
+    if (QUEUE_CAPACITY - queue->end < length) {
+        queue_compact(queue);
+    }
+    if (QUEUE_CAPACITY - queue->end < length) {
+        errno = ENOBUFS;
+        return -1;
+    }
+    memcpy(queue->data + queue->end, bytes, length);
+    queue_commit(queue, length);
+    return 0;
+}
+
+// function that removes the message of the given length from the start of the queue and returns it
+// the message is null-terminated in place, so it stays valid until the next operation on the queue
+char* queue_take(byte_queue *queue, size_t length) {
+    queue_restore(queue);
+    char *msg = queue->data + queue->start;
+    queue->start += length;
+    queue->next_byte = queue->data[queue->start];
+    queue->data[queue->start] = '\0';
+    queue->is_taken = 1;
+    return msg;
+}
+
+// function that reads once from a non-blocking socket into the free space of the queue
+// a single read fills at most the free space, and whatever the peer sent beyond it stays in the socket for the next
+// receive, so the caller decides when the connection gets its next turn
+// sets is_closed to 1 if the peer closed the connection or the socket failed
+// returns the number of bytes added to the queue
+size_t queue_receive(byte_queue *queue, int socket, size_t *is_closed) {
+    *is_closed = 0;
+    size_t space = 0;
+    char *free_space = queue_get_space(queue, &space);
+    if (space == 0) {
+        return 0;
+    }
+
+    ssize_t bytes_read = read(socket, free_space, space);
+    while (bytes_read == -1 && errno == EINTR) {
+        bytes_read = read(socket, free_space, space);
+    }
+    if (bytes_read <= 0) {
+        if (bytes_read == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            *is_closed = 1;
+        }
+        return 0;
+    }
+    queue_commit(queue, bytes_read);
+    return bytes_read;
+}
+
+// function that puts back the byte that was overwritten by the null terminator of the last message taken
+// the queue starts over at the front once every byte has been read
+static void queue_restore(byte_queue *queue) {
+    if (queue->is_taken == 0) {
+        return;
+    }
+    queue->data[queue->start] = queue->next_byte;
+    queue->is_taken = 0;
+    if (queue->start == queue->end) {
+        queue->start = 0;
+        queue->end = 0;
+        queue->data[0] = '\0';
+    }
+}
+
+// function that moves the unread bytes to the front of the queue to make room at the end
+// the unread bytes are a partial message unless the client is waiting for its game, so little is copied
+static void queue_compact(byte_queue *queue) {
+    if (queue->start == 0) {
+        return;
+    }
+    memmove(queue->data, queue->data + queue->start, queue_length(queue) + 1);
+    queue->end -= queue->start;
+    queue->start = 0;
+}
@@ -0,0 +1,37 @@
+#ifndef P3_QUEUE_H
+#define P3_QUEUE_H
+
+#include <errno.h>
+#include "helper.h"
+
+// declare enumeration for constants of the byte queue
+// the capacity holds the longest possible message (1008 bytes) plus a whole provided buffer of the io_uring backend
+typedef enum queue_constant {
+    QUEUE_CAPACITY = 4096,
+} queue_constant;
+
+// define struct for a fixed-capacity queue of the bytes received from a connection
+// bytes are read straight into the free space at the end, and messages are taken from the start by offset
+// the unread bytes are always followed by a null terminator, so they can be parsed as a string in place
+// a taken message is null-terminated in place as well, and the byte that was overwritten is saved in next_byte
+// until the next operation on the queue puts it back
+typedef struct byte_queue {
+    size_t start;
+    size_t end;
+    size_t is_taken;
+    char next_byte;
+    char data[QUEUE_CAPACITY + 1];
+} byte_queue;
+
+// prototypes of all functions
+void queue_init(byte_queue *queue);
+size_t queue_length(const byte_queue *queue);
+size_t queue_is_full(const byte_queue *queue);
+char* queue_peek(byte_queue *queue);
+char* queue_get_space(byte_queue *queue, size_t *length);
+void queue_commit(byte_queue *queue, size_t length);
+ssize_t queue_push(byte_queue *queue, const char *bytes, size_t length);
+char* queue_take(byte_queue *queue, size_t length);
+size_t queue_receive(byte_queue *queue, int socket, size_t *is_closed);
+
+#endif //P3_QUEUE_H
@@ -0,0 +1,263 @@
+#define _DEFAULT_SOURCE
+#include <inttypes.h>
+#include "recorder.h"
+
+// global variables for the names that the decoder gives to the fields of an event
+// the opcodes are in the same order as message_code, and the states in the same order as client_state
+static const char *const KINDS[] = {"ACCEPT", "FRAME_IN", "FRAME_OUT", "STATE", "ERROR"};
+static const char *const OPCODES[] = {"PLAY", "MOVE", "RSGN", "DRAW", "WAIT", "BEGN", "MOVD", "INVL", "OVER"};
+static const char *const STATES[] = {"HANDSHAKE", "WAITING", "PLAYING", "MOVING", "CLOSED"};
+static const char *const ERRORS[] = {"reject", "queue", "send", "handshake_timeout", "game_abandoned", "handoff"};
+
+// global variable for the signals that make the server write the recording before it dies
+static const int CRASH_SIGNALS[FLIGHT_CRASH_SIGNALS] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+// global variable for the handlers that were set for those signals before, such as the ones of AddressSanitizer
+static struct sigaction previous_actions[FLIGHT_CRASH_SIGNALS];
+
+// global variables for the recording, which is a header followed by the ring of every thread in one mapping
+// a recording backed by a file is a shared mapping of it, so the kernel keeps every event even if the server is killed
+static flight_header *recording = NULL;
+static size_t is_file_backed = 0;
+static pthread_mutex_t rings_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// global variables for the ring of the current thread, and whether it could not get one
+static __thread flight_ring *thread_ring = NULL;
+static __thread size_t has_no_ring = 0;
+
+// prototypes of internal functions
+static flight_ring* get_thread_ring();
+static flight_ring* get_ring(size_t index);
+static void handle_crash(int signal, siginfo_t *info, void *context);
+static ssize_t write_all(int fd, const void *data, size_t length);
+
+// function that maps the recording and sets up the handlers that write it when the server crashes
+// path is the file to keep the recording in, or NULL to keep it in anonymous memory
+void recorder_start(const char *path) {
+    size_t size = sizeof(flight_header) + MAX_FLIGHT_RINGS * sizeof(flight_ring);
+    void *mapping = MAP_FAILED;
+    if (path == NULL) {
+        mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    } else {
+        int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1) {
+            perror("open");
+            exit(EXIT_FAILURE);
+        }
+        if (ftruncate(fd, (off_t) size) == -1) {
+            perror("ftruncate");
+            exit(EXIT_FAILURE);
+        }
+        mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        is_file_backed = 1;
+    }
+    if (mapping == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+
+    // the offset between the clocks turns the monotonic time of an event into the time of day
+    flight_header *header = mapping;
+    struct timespec monotonic, realtime;
+    clock_gettime(CLOCK_MONOTONIC, &monotonic);
+    clock_gettime(CLOCK_REALTIME, &realtime);
+    memcpy(header->magic, FLIGHT_MAGIC, sizeof(header->magic));
+    header->event_size = sizeof(flight_event);
+    header->ring_events = FLIGHT_RING_EVENTS;
+    header->number_of_rings = 0;
+    header->pid = (uint32_t) getpid();
+    header->realtime_offset = (realtime.tv_sec - monotonic.tv_sec) * 1000000000LL +
+                              (realtime.tv_nsec - monotonic.tv_nsec);
+    __atomic_store_n(&recording, header, __ATOMIC_RELEASE);
+
+    // the handlers that were set before are kept, so a crash still reaches them once the recording is written
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = handle_crash;
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    for (size_t i = 0; i < FLIGHT_CRASH_SIGNALS; i++) {
+        if (sigaction(CRASH_SIGNALS[i], &action, &previous_actions[i]) == -1) {
+            perror("sigaction");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// function that records an event into the ring of the current thread
+// only the current thread writes its ring, so the event is written in place without a lock or a locked instruction
+// does nothing if the recorder has not been started or every ring is taken
+void recorder_record(flight_kind kind, uint64_t connection, uint16_t code, uint32_t value) {
+    flight_ring *ring = get_thread_ring();
+    if (ring == NULL) {
+        return;
+    }
+    uint64_t now = get_time_in_ns();
+
+    uint64_t head = ring->head;
+    flight_event *event = &ring->events[head & (FLIGHT_RING_EVENTS - 1)];
+    event->time = now;
+    event->connection = connection;
+    event->value = value;
+    event->kind = (uint16_t) kind;
+    event->code = code;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// function that returns the size of the recording that recorder_write would write now
+// returns 0 if the recorder has not been started
+size_t recorder_get_size() {
+    flight_header *header = __atomic_load_n(&recording, __ATOMIC_ACQUIRE);
+    if (header == NULL) {
+        return 0;
+    }
+    return sizeof(flight_header) + __atomic_load_n(&header->number_of_rings, __ATOMIC_ACQUIRE) * sizeof(flight_ring);
+}
+
+// function that writes the header and every ring that a thread has taken to the file descriptor
+// it only calls write, so a signal handler can call it, and the events that a thread records while its ring is being
+// written may be torn, which the decoder tells apart by their kind
+// returns -1 on error and the number of bytes written on success
+ssize_t recorder_write(int fd) {
+    flight_header *header = __atomic_load_n(&recording, __ATOMIC_ACQUIRE);
+    if (header == NULL) {
+        return -1;
+    }
+    flight_header copy = *header;
+    copy.number_of_rings = __atomic_load_n(&header->number_of_rings, __ATOMIC_ACQUIRE);
+    if (write_all(fd, &copy, sizeof(copy)) == -1) {
+        return -1;
+    }
+    for (size_t i = 0; i < copy.number_of_rings; i++) {
+        if (write_all(fd, get_ring(i), sizeof(flight_ring)) == -1) {
+            return -1;
+        }
+    }
+    return (ssize_t) (sizeof(flight_header) + copy.number_of_rings * sizeof(flight_ring));
+}
+
+// function that writes a line that describes the event of a recording with the given header into the line
+// returns -1 if the event is torn or unknown and the length of the line on success
+ssize_t recorder_describe(const flight_header *header, const flight_event *event, char *line, size_t capacity) {
+    if (event->kind >= NUMBER_OF_FLIGHT_KINDS) {
+        return -1;
+    }
+
+    // the time of day of the event, to the nanosecond
+    int64_t nanoseconds = (int64_t) event->time + header->realtime_offset;
+    time_t seconds = (time_t) (nanoseconds / 1000000000LL);
+    struct tm calendar;
+    gmtime_r(&seconds, &calendar);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &calendar);
+
+    // the id of a connection is the shard that accepted it in the upper 16 bits and its number on the shard below them
+    char prefix[96];
+    snprintf(prefix, sizeof(prefix), "%s.%09" PRId64 " %" PRIu64 ":%" PRIu64 " %-9s", date,
+             (int64_t) (nanoseconds % 1000000000LL), event->connection >> 48,
+             (uint64_t) (event->connection & 0xFFFFFFFFFFFFULL), KINDS[event->kind]);
+
+    int length = 0;
+    switch (event->kind) {
+        case FLIGHT_ACCEPT:
+            length = snprintf(line, capacity, "%s socket %" PRIu32, prefix, event->value);
+            break;
+        case FLIGHT_FRAME_IN:
+        case FLIGHT_FRAME_OUT:
+            if (event->code >= NUMBER_OF_OPCODES) {
+                return -1;
+            }
+            length = snprintf(line, capacity, "%s %s %" PRIu32 " bytes", prefix, OPCODES[event->code], event->value);
+            break;
+        case FLIGHT_STATE:
+            if (event->code >= NUMBER_OF_STATES || event->value >= NUMBER_OF_STATES) {
+                return -1;
+            }
+            length = snprintf(line, capacity, "%s %s -> %s", prefix, STATES[event->value], STATES[event->code]);
+            break;
+        default:
+            if (event->code >= NUMBER_OF_FLIGHT_ERRORS) {
+                return -1;
+            }
+            if (event->value == 0) {
+                length = snprintf(line, capacity, "%s %s", prefix, ERRORS[event->code]);
+            } else {
+                length = snprintf(line, capacity, "%s %s: %s", prefix, ERRORS[event->code],
+                                  strerror((int) event->value));
+            }
+            break;
+    }
+    return length < 0 ? -1 : length;
+}
+
+// function that gets the ring of the current thread, and takes a ring for the thread the first time it records
+// returns NULL if the recorder has not been started or every ring is taken
+static flight_ring* get_thread_ring() {
+    if (thread_ring != NULL || has_no_ring == 1) {
+        return thread_ring;
+    }
+    flight_header *header = __atomic_load_n(&recording, __ATOMIC_ACQUIRE);
+    if (header == NULL) {
+        return NULL;
+    }
+
+    if (pthread_mutex_lock(&rings_mutex) != 0) {
+        perror("pthread_mutex_lock");
+        exit(EXIT_FAILURE);
+    }
+    if (header->number_of_rings < MAX_FLIGHT_RINGS) {
+        thread_ring = get_ring(header->number_of_rings);
+        __atomic_store_n(&header->number_of_rings, header->number_of_rings + 1, __ATOMIC_RELEASE);
+    } else {
+        has_no_ring = 1;
+    }
+    pthread_mutex_unlock(&rings_mutex);
+    return thread_ring;
+}
+
+// function that returns the ring of the given index in the recording
+static flight_ring* get_ring(size_t index) {
+    return (flight_ring *) ((char *) recording + sizeof(flight_header)) + index;
+}
+
+// function that handles a signal that crashes the server, which writes the recording before the signal kills it
+// a recording in anonymous memory is written to the dump file, while a recording backed by a file is already there
+// the handler that was set before is put back, so a fault hits it again once this handler returns, and a signal that
+// was sent by raise() or kill() is raised again for it, which keeps the report of a handler such as AddressSanitizer's
+static void handle_crash(int signal, siginfo_t *info, void *context) {
+    (void) context;
+    if (is_file_backed == 0) {
+        int fd = open(FLIGHT_DUMP_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd != -1) {
+            recorder_write(fd);
+            close(fd);
+        }
+    }
+    for (size_t i = 0; i < FLIGHT_CRASH_SIGNALS; i++) {
+        if (CRASH_SIGNALS[i] == signal) {
+            sigaction(signal, &previous_actions[i], NULL);
+        }
+    }
+    if (info == NULL || info->si_code <= 0) {
+        raise(signal);
+    }
+}
+
+// function that writes all the bytes to the file descriptor, which only calls write so a signal handler can call it
+// returns -1 on error and 0 on success
+static ssize_t write_all(int fd, const void *data, size_t length) {
+    const char *bytes = data;
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+        if (written == -1 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return -1;
+        }
+        bytes += written;
+        length -= (size_t) written;
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+#ifndef P3_RECORDER_H
+#define P3_RECORDER_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "helper.h"
+
+// the file that a recording kept in anonymous memory is written to when the server crashes
+#define FLIGHT_DUMP_FILE "ttts.flight"
+
+// the magic string at the start of every recording
+#define FLIGHT_MAGIC "TTTSFLT1"
+
+// declare enumeration for constants of the flight recorder
+// the number of events in a ring must be a power of 2
+typedef enum recorder_constant {
+    FLIGHT_RING_EVENTS = 4096,
+    MAX_FLIGHT_RINGS = 256,
+    FLIGHT_LINE_SIZE = 256,
+    FLIGHT_CRASH_SIGNALS = 5,
+    NUMBER_OF_OPCODES = 9,
+    NUMBER_OF_STATES = 5,
+} recorder_constant;
+
+// declare enumeration for the kinds of events that the flight recorder keeps
+// an accept keeps the socket, a frame keeps its opcode (in the order of message_code) and length, a state transition
+// keeps the new and the old state of the client (in the order of client_state), and an error keeps where it happened
+// and errno
+typedef enum flight_kind {
+    FLIGHT_ACCEPT = 0,
+    FLIGHT_FRAME_IN = 1,
+    FLIGHT_FRAME_OUT = 2,
+    FLIGHT_STATE = 3,
+    FLIGHT_ERROR = 4,
+    NUMBER_OF_FLIGHT_KINDS = 5,
+} flight_kind;
+
+// declare enumeration for where an error that the flight recorder keeps happened
+typedef enum flight_error {
+    FLIGHT_ERROR_REJECT = 0,
+    FLIGHT_ERROR_QUEUE = 1,
+    FLIGHT_ERROR_SEND = 2,
+    FLIGHT_ERROR_HANDSHAKE_TIMEOUT = 3,
+    FLIGHT_ERROR_GAME_ABANDONED = 4,
+    FLIGHT_ERROR_HANDOFF = 5,
+    NUMBER_OF_FLIGHT_ERRORS = 6,
+} flight_error;
+
+// define struct for an event of the flight recorder, which is written in place into the ring of a thread
+typedef struct flight_event {
+    uint64_t time;
+    uint64_t connection;
+    uint32_t value;
+    uint16_t kind;
+    uint16_t code;
+} flight_event;
+
+// define struct for the header of a recording, which tells the decoder how the rings after it are laid out
+// the offset turns the monotonic time of an event into the time of day
+typedef struct flight_header {
+    char magic[8];
+    uint32_t event_size;
+    uint32_t ring_events;
+    uint32_t number_of_rings;
+    uint32_t pid;
+    int64_t realtime_offset;
+} __attribute__((aligned(CACHE_LINE_SIZE))) flight_header;
+
+// define struct for the ring of events of one thread, which only that thread writes
+// head is the number of events the thread has written, so the ring holds the last FLIGHT_RING_EVENTS of them
+typedef struct flight_ring {
+    uint64_t head;
+    flight_event events[FLIGHT_RING_EVENTS] __attribute__((aligned(CACHE_LINE_SIZE)));
+} flight_ring;
+
+// prototypes of all functions
+void recorder_start(const char *path);
+void recorder_record(flight_kind kind, uint64_t connection, uint16_t code, uint32_t value);
+size_t recorder_get_size();
+ssize_t recorder_write(int fd);
+ssize_t recorder_describe(const flight_header *header, const flight_event *event, char *line, size_t capacity);
+
+#endif //P3_RECORDER_H
@@ -1,5 +1,58 @@
+#define _POSIX_C_SOURCE 200809L
 #include <time.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <sched.h>
+#include <inttypes.h>
 #include "commands.h"
+#include "legacy.h"
+#include "frames.h"
+#include "names.h"
+#include "timer.h"
+#include "metrics.h"
+#include "histogram.h"
+#include "recorder.h"
+
+// declare enumeration for constants of the test suite
+typedef enum test_constant {
+    IDLE_CLIENTS = 1000,
+    PAIRING_TIMEOUT = 500,
+    FLOOD_MOVES = 1000,
+    FLOOD_LIMIT = 67108864,
+    CLOCK_TIME = 300,
+    CLOCK_INCREMENT = 400,
+    CLOCK_PORT_OFFSET = 1,
+    ADMIN_PORT_OFFSET = 2,
+    PORT_SIZE = 24,
+    STATS_SIZE = 16384,
+    STATS_ATTEMPTS = 100,
+    FUZZ_CASES = 20000,
+    FUZZ_LENGTH = 48,
+    NAME_POOL = 4096,
+    NAME_CASES = 50000,
+    POOL_GAMES = 64,
+    POOL_ROUNDS = 2000,
+    CLIENT_SIZE = 4400,
+    GAME_SIZE = 64,
+    OUTPUT_SIZE = 128,
+    OUTPUTS_PER_GAME = 12,
+    FLOOD_BYTES = 65536,
+    READ_SIZE = 4096,
+    TIMER_CASES = 100000,
+    TIMER_SPAN = 600000,
+    METRIC_THREADS = 4,
+    METRIC_CASES = 400000,
+    HISTOGRAM_CASES = 200000,
+    FLIGHT_CASES = 3 * FLIGHT_RING_EVENTS + 5,
+} test_constant;
+
+// define struct for a timer of the timer check, which counts how many times it expired
+typedef struct counted_timer {
+    timer wheel_timer;
+    size_t number_of_expiries;
+} counted_timer;
 
 // prototypes for all functions
 void obtain_mutex_lock(pthread_mutex_t *mutex);
@@ -23,10 +76,36 @@ void* D_client_1(void *arg);
 void* D_client_2(void *arg);
 void* E_client_1(void *arg);
 void* E_client_2(void *arg);
+void* F_client_1(void *arg);
+void* F_client_2(void *arg);
+void start_clock_server();
+ssize_t read_stat(const char *name, long *value);
+void run_checks();
+void compare_parsers(const char *msg_buffer);
+void compare_decoders(const char *msg_buffer, const frame *view);
+void check_corpus();
+void check_fuzz();
+size_t check_games(bitboard *board, char *legacy_board, char role);
+void check_names();
+void* take_object(pool_kind kind, size_t size);
+void play_allocations(size_t is_ending);
+void check_pools();
+void check_fairness();
+void check_timers();
+void check_metrics();
+void* count_metrics(void *arg);
+void check_histograms();
+int compare_values(const void *a, const void *b);
+void check_recorder();
 
 char *host = NULL;
 char *port = NULL;
 
+// the server with time controls that the F clients play on, which runs next to the server under test
+char clock_port[PORT_SIZE];
+char admin_port[PORT_SIZE];
+pid_t clock_server = -1;
+
 static pthread_mutex_t main_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static pthread_mutex_t game_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -35,6 +114,46 @@ size_t game_role = 0;
 
 size_t should_exit = 0;
 
+// global variable for the messages of the test suite, including every message of test_suite/B
+static const char *CORPUS[] = {
+        "PLAY|10|Joe Smith|",
+        "PLAY|10|Joe Sally|",
+        "PLAY|12|X|Joe Smith|",
+        "PLAY|12|X|Joe Sally|",
+        "MOVE|6|X|1,2|",
+        "MOVE|6|X|4,2|",
+        "MOVE|6|X|1,0|",
+        "MOVE|6|O|2,1|",
+        "MOVE|7|X|PLAY|",
+        "MOVD|6|X|1,2|",
+        "MOVD|16|X|2,2|...X...O.|",
+        "INVL|17|!Protocol error.|",
+        "WAIT|0|",
+        "OVER|27|L|One player has resigned.|",
+        "BEGN|11|X|Opponent|",
+        "RSGN|0|",
+        "DRAW|2|S|",
+        "DRAW|2|A|",
+        "DRAW|2|R|",
+        "MOVE|6|X|2,2|MOVE|6|O|3,3|",
+        "PLAY|||0|",
+        "PLAY|| 1|a|",
+        "MOVE|-0|",
+        "MOVE|+6|X|2,2|",
+        "DRAW|2|S|garbage",
+        "hello world|||||",
+        "MOVE|8|X|,2,,3|",
+        "MOVE|8|O| 1,+3|",
+        "MOVE|7|X|2,-1|",
+        "MOVE|8|X|2,3,1|",
+        "MOVE|26|X|00000000000000000002,1x|",
+        "MOVE|25|X|18446744073709551618,1|",
+        "MOVE|7|XO|1,1|",
+        "PLAY|1||",
+        "DRAW|3|SS|",
+        "DRAW|2|s|",
+        "RSGN|0|",
+};
 
 // driver
 int main(int argc, char **argv) {
@@ -49,6 +168,12 @@ int main(int argc, char **argv) {
     host = argv[1];
     port = argv[2];
 
+    // check the modules of the server before playing on it
+    run_checks();
+
+    // start the server with time controls for the F clients
+    start_clock_server();
+
     pthread_t thread;
 
     // A client 1
@@ -102,6 +227,30 @@ int main(int argc, char **argv) {
     thread_create(&thread, &C_client_2);
     thread_detach(&thread);
 
+    // D client 1
+    thread_create(&thread, &D_client_1);
+    thread_detach(&thread);
+
+    // D client 2
+    thread_create(&thread, &D_client_2);
+    thread_detach(&thread);
+
+    // E client 1
+    thread_create(&thread, &E_client_1);
+    thread_detach(&thread);
+
+    // E client 2
+    thread_create(&thread, &E_client_2);
+    thread_detach(&thread);
+
+    // F client 1
+    thread_create(&thread, &F_client_1);
+    thread_detach(&thread);
+
+    // F client 2
+    thread_create(&thread, &F_client_2);
+    thread_detach(&thread);
+
     while (1) {
         nanosleep((const struct timespec[]){{0, 100000000L}}, NULL);
     }
@@ -148,6 +297,698 @@ void thread_detach(pthread_t *thread) {
     }
 }
 
+// function that starts "./ttts -c <clock>+<increment> -a <admin port> <clock port>" on the two ports after the port of
+// the server under test, and waits until it accepts connections
+// the server is killed when the test suite exits, and its output is discarded
+void start_clock_server() {
+    long base_port = strtol(port, NULL, 10);
+    char clock[PORT_SIZE * 2];
+    snprintf(clock_port, sizeof(clock_port), "%ld", base_port + CLOCK_PORT_OFFSET);
+    snprintf(admin_port, sizeof(admin_port), "%ld", base_port + ADMIN_PORT_OFFSET);
+    snprintf(clock, sizeof(clock), "%d+%d", CLOCK_TIME, CLOCK_INCREMENT);
+
+    clock_server = fork();
+    if (clock_server == -1) {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    }
+    if (clock_server == 0) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        if (null_fd == -1 || dup2(null_fd, STDOUT_FILENO) == -1 || dup2(null_fd, STDERR_FILENO) == -1 ||
+            prctl(PR_SET_PDEATHSIG, SIGKILL) == -1) {
+            perror("start_clock_server");
+            _exit(EXIT_FAILURE);
+        }
+        execl("./ttts", "./ttts", "-c", clock, "-a", admin_port, clock_port, (char *) NULL);
+        perror("execl");
+        _exit(EXIT_FAILURE);
+    }
+
+    // the probe is a client that never sends PLAY, which the server closes with the others
+    for (size_t i = 0; i < STATS_ATTEMPTS; i++) {
+        int probe = create_client_socket(host, clock_port);
+        if (probe != -1) {
+            close(probe);
+            return;
+        }
+        nanosleep((const struct timespec[]){{0, 20000000L}}, NULL);
+    }
+    fprintf(stderr, "start_clock_server: ./ttts did not start on port %s\n", clock_port);
+    exit(EXIT_FAILURE);
+}
+
+// function that reads the value of a metric of the server with time controls from its admin port
+// returns -1 on error and 0 on success
+ssize_t read_stat(const char *name, long *value) {
+    int admin_socket = create_client_socket(host, admin_port);
+    if (admin_socket == -1) {
+        return -1;
+    }
+    char report[STATS_SIZE];
+    size_t length = 0;
+    ssize_t bytes_read = 0;
+    if (send_message(admin_socket, "stats", 5) == -1) {
+        close(admin_socket);
+        return -1;
+    }
+    while (length < sizeof(report) - 1 &&
+           (bytes_read = read(admin_socket, report + length, sizeof(report) - 1 - length)) > 0) {
+        length += bytes_read;
+    }
+    close(admin_socket);
+    report[length] = '\0';
+
+    // every value is on a line of its own that starts with the name of its metric
+    char line_start[64];
+    snprintf(line_start, sizeof(line_start), "\n%s ", name);
+    const char *line = strstr(report, line_start);
+    if (line == NULL) {
+        return -1;
+    }
+    *value = strtol(line + strlen(line_start), NULL, 10);
+    return 0;
+}
+
+// function that checks the modules of the server on their own and against the code they replaced, before the clients
+// play on the server under test
+void run_checks() {
+    check_corpus();
+    check_fuzz();
+    printf("PARSERS: PASSED\n");
+
+    frames_init();
+    bitboard board;
+    board_init(&board);
+    char legacy_board[NUMBER_OF_CELLS + 1] = ".........";
+    check_games(&board, legacy_board, 'X');
+    printf("BOARD: PASSED\n");
+
+    names_init();
+    check_names();
+    printf("NAMES: PASSED\n");
+
+    check_pools();
+    printf("POOLS: PASSED\n");
+
+    check_fairness();
+    printf("FAIRNESS: PASSED\n");
+
+    check_timers();
+    printf("TIMERS: PASSED\n");
+
+    check_metrics();
+    printf("METRICS: PASSED\n");
+
+    check_histograms();
+    printf("HISTOGRAMS: PASSED\n");
+
+    check_recorder();
+    printf("RECORDER: PASSED\n");
+}
+
+// function that exits if the two parsers do not agree on whether the buffer starts with a complete message
+void compare_parsers(const char *msg_buffer) {
+    size_t legacy_index = 0;
+    size_t index = 0;
+    size_t legacy_result = legacy_is_complete_msg(msg_buffer, &legacy_index);
+    size_t result = is_complete_msg(msg_buffer, &index);
+    if (legacy_result != result || (result == 1 && legacy_index != index)) {
+        fprintf(stderr, "parsers disagree on \"%s\": legacy %zu (%zu), single-pass %zu (%zu)\n",
+                msg_buffer, legacy_result, legacy_index, result, index);
+        exit(EXIT_FAILURE);
+    }
+    if (result == 1) {
+        frame view;
+        parse_frame(msg_buffer, &view);
+        compare_decoders(msg_buffer, &view);
+    }
+}
+
+// function that exits if decode_message() does not decode the complete message at the start of the buffer
+// exactly like the parse functions it replaced
+void compare_decoders(const char *msg_buffer, const frame *view) {
+    char *msg = strndup(msg_buffer, view->length);
+    if (msg == NULL) {
+        perror("strndup");
+        exit(EXIT_FAILURE);
+    }
+    message decoded;
+    decode_message(msg, view, &decoded);
+
+    // decode the message with the legacy parse functions, and tag it INVL if none of them accepts it
+    message legacy;
+    legacy.code = CODE_INVL;
+    char *player_name = NULL;
+    if (legacy_parse_play(msg, &player_name) == 0) {
+        legacy.code = CODE_PLAY;
+    } else if (legacy_parse_rsgn(msg) == 0) {
+        legacy.code = CODE_RSGN;
+    } else if (legacy_parse_draw(msg, &legacy.fields.draw.action) == 0) {
+        legacy.code = CODE_DRAW;
+    } else if (legacy_parse_move(msg, &legacy.fields.move.role, &legacy.fields.move.row,
+                                 &legacy.fields.move.col) == 0) {
+        legacy.code = CODE_MOVE;
+    }
+
+    size_t is_same = legacy.code == decoded.code;
+    if (is_same == 1 && decoded.code == CODE_PLAY) {
+        is_same = strlen(player_name) == decoded.fields.play.name_length &&
+                  strncmp(player_name, decoded.fields.play.name, decoded.fields.play.name_length) == 0;
+    } else if (is_same == 1 && decoded.code == CODE_DRAW) {
+        is_same = legacy.fields.draw.action == decoded.fields.draw.action;
+    } else if (is_same == 1 && decoded.code == CODE_MOVE) {
+        is_same = legacy.fields.move.role == decoded.fields.move.role &&
+                  legacy.fields.move.row == decoded.fields.move.row &&
+                  legacy.fields.move.col == decoded.fields.move.col;
+    }
+    if (is_same == 0) {
+        fprintf(stderr, "decoders disagree on \"%s\": legacy %s, decode_message() %s\n",
+                msg, CODES[legacy.code], CODES[decoded.code]);
+        exit(EXIT_FAILURE);
+    }
+    Free(player_name);
+    Free(msg);
+}
+
+// function that compares the parsers on every prefix of every message of the corpus
+// every prefix is what the server has buffered while the message is still arriving
+void check_corpus() {
+    char buffer[128];
+    for (size_t i = 0; i < sizeof(CORPUS) / sizeof(CORPUS[0]); i++) {
+        size_t length = strlen(CORPUS[i]);
+        for (size_t j = 0; j <= length; j++) {
+            memcpy(buffer, CORPUS[i], j);
+            buffer[j] = '\0';
+            compare_parsers(buffer);
+        }
+    }
+}
+
+// function that compares the parsers on random mutations of the corpus and on random strings of protocol characters
+void check_fuzz() {
+    const char *alphabet = "PLAYMOVERSGNDWITBXO|||||0123456789 ,,+-\t";
+    size_t alphabet_length = strlen(alphabet);
+    size_t corpus_length = sizeof(CORPUS) / sizeof(CORPUS[0]);
+    char buffer[FUZZ_LENGTH + 1];
+    srand(1);
+
+    for (size_t i = 0; i < FUZZ_CASES; i++) {
+        if (i % 2 == 0) {
+            // change, drop or add a few characters of a message of the corpus
+            strncpy(buffer, CORPUS[rand() % corpus_length], FUZZ_LENGTH);
+            buffer[FUZZ_LENGTH] = '\0';
+            for (size_t j = 0, mutations = 1 + rand() % 3; j < mutations; j++) {
+                size_t length = strlen(buffer);
+                size_t position = length == 0 ? 0 : rand() % length;
+                char character = alphabet[rand() % alphabet_length];
+                if (rand() % 3 == 0 && length > 0) {
+                    memmove(buffer + position, buffer + position + 1, length - position);
+                } else if (rand() % 2 == 0 && length < FUZZ_LENGTH) {
+                    memmove(buffer + position + 1, buffer + position, length - position + 1);
+                    buffer[position] = character;
+                } else if (length > 0) {
+                    buffer[position] = character;
+                }
+            }
+        } else {
+            // start with a code and a bar, followed by random characters
+            size_t length = 5 + rand() % (FUZZ_LENGTH - 5);
+            memcpy(buffer, CODES[rand() % NUMBER_OF_CODES], 4);
+            buffer[4] = '|';
+            for (size_t j = 5; j < length; j++) {
+                buffer[j] = alphabet[rand() % alphabet_length];
+            }
+            buffer[length] = '\0';
+        }
+        compare_parsers(buffer);
+    }
+}
+
+// function that plays every possible continuation of the game on both boards, where role moves next
+// exits if the boards do not agree on a move, the status of the game or the grid
+// returns the number of games that were played to the end
+size_t check_games(bitboard *board, char *legacy_board, char role) {
+    size_t number_of_games = 0;
+    for (size_t i = 0; i < NUMBER_OF_CELLS; i++) {
+        bitboard next = *board;
+        char next_legacy[NUMBER_OF_CELLS + 1];
+        strcpy(next_legacy, legacy_board);
+        ssize_t result = board_make_move(&next, role, i / 3, i % 3);
+        if (result != legacy_make_move(next_legacy, role, i / 3, i % 3)) {
+            fprintf(stderr, "boards disagree on the move %zu of %c on %s\n", i, role, legacy_board);
+            exit(EXIT_FAILURE);
+        }
+        if (result == -1) {
+            continue;
+        }
+
+        // compare the status and the grid after the move
+        char status = '\0';
+        char winner = '\0';
+        char legacy_status = '\0';
+        char legacy_winner = '\0';
+        char grid[NUMBER_OF_CELLS + 1];
+        board_get_status(&next, &status, &winner);
+        board_render(&next, grid);
+        if (legacy_get_game_status(next_legacy, &legacy_status, &legacy_winner) == -1 ||
+            status != legacy_status || winner != legacy_winner || strcmp(grid, next_legacy) != 0) {
+            fprintf(stderr, "boards disagree on %s: legacy %c%c, bitboard %s %c%c\n",
+                    next_legacy, legacy_status, legacy_winner, grid, status, winner);
+            exit(EXIT_FAILURE);
+        }
+
+        // the looked up MOVD frame must be the frame the server used to format
+        wire_frame movd_frame;
+        char movd_msg[MOVD_LENGTH + 1];
+        snprintf(movd_msg, sizeof(movd_msg), "MOVD|16|%c|%zu,%zu|%s|", role, i / 3 + 1, i % 3 + 1, next_legacy);
+        if (get_movd_frame(&next, i / 3, i % 3, &movd_frame) == -1 || movd_frame.length != strlen(movd_msg) ||
+            strcmp(movd_frame.bytes, movd_msg) != 0) {
+            fprintf(stderr, "the MOVD frame of %s is not %s\n", next_legacy, movd_msg);
+            exit(EXIT_FAILURE);
+        }
+
+        if (status == 'N') {
+            number_of_games += check_games(&next, next_legacy, role == 'X' ? 'O' : 'X');
+        } else {
+            number_of_games++;
+        }
+    }
+    return number_of_games;
+}
+
+// function that adds, removes and looks up random names of a pool on both sets of player names
+// the set of player names keeps a pointer to every name it holds, so each name of the pool has a buffer of its own
+// exits if the sets do not agree on whether a name is taken
+void check_names() {
+    static char names[NAME_POOL][32];
+    for (size_t i = 0; i < NAME_POOL; i++) {
+        snprintf(names[i], sizeof(names[i]), "Player %zu", i);
+    }
+    srand(2);
+
+    for (size_t i = 0; i < NAME_CASES; i++) {
+        const char *player_name = names[rand() % NAME_POOL];
+        size_t result = 0;
+        size_t legacy_result = 0;
+        switch (rand() % 3) {
+            case 0:
+                result = add_player_name(player_name);
+                legacy_result = legacy_add_player_name(player_name);
+                break;
+            case 1:
+                remove_player_name(player_name);
+                legacy_remove_player_name(player_name);
+                break;
+            default:
+                break;
+        }
+        if (result != legacy_result ||
+            is_player_name_taken(player_name) != legacy_is_player_name_taken(player_name)) {
+            fprintf(stderr, "the sets of player names disagree on \"%s\"\n", player_name);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // empty both sets
+    for (size_t i = 0; i < NAME_POOL; i++) {
+        remove_player_name(names[i]);
+        legacy_remove_player_name(names[i]);
+    }
+}
+
+// function that takes an object of the given kind from its pool, and touches it the way the server does when it fills
+// it in
+void* take_object(pool_kind kind, size_t size) {
+    void *object = pool_alloc(kind);
+    if (object == NULL) {
+        perror("pool_alloc");
+        exit(EXIT_FAILURE);
+    }
+    memset(object, 0, size < 64 ? size : 64);
+    return object;
+}
+
+// function that allocates and frees the objects of overlapping games from the pools the way the server does: the two
+// clients, their names, a name in the set of player names each, the game, and the messages of the game
+// when is_ending is 1, the games that are still going on end without starting new ones
+void play_allocations(size_t is_ending) {
+    static void *objects[POOL_GAMES][7];
+    static size_t is_started = 0;
+    for (size_t i = 0; i < POOL_GAMES; i++) {
+        // end the game that was played in this slot before starting a new one
+        if (is_started == 1) {
+            for (size_t j = 0; j < 2; j++) {
+                pool_free(POOL_CLIENT, objects[i][j]);
+            }
+            for (size_t j = 2; j < 6; j++) {
+                pool_free(POOL_SHORT_NAME, objects[i][j]);
+            }
+            pool_free(POOL_GAME, objects[i][6]);
+        }
+        if (is_ending == 1) {
+            continue;
+        }
+        for (size_t j = 0; j < 2; j++) {
+            objects[i][j] = take_object(POOL_CLIENT, CLIENT_SIZE);
+        }
+        for (size_t j = 2; j < 6; j++) {
+            objects[i][j] = take_object(POOL_SHORT_NAME, 16);
+        }
+        objects[i][6] = take_object(POOL_GAME, GAME_SIZE);
+
+        // every message is freed once it has been sent
+        for (size_t j = 0; j < OUTPUTS_PER_GAME; j++) {
+            pool_free(POOL_SHORT_OUTPUT, take_object(POOL_SHORT_OUTPUT, OUTPUT_SIZE));
+        }
+    }
+    is_started = is_ending == 0;
+}
+
+// function that checks that the pools stop taking slabs from the heap once the number of games is steady
+void check_pools() {
+    pool_init(POOL_CLIENT, "client", CLIENT_SIZE);
+    pool_init(POOL_GAME, "game", GAME_SIZE);
+    pool_init(POOL_SHORT_OUTPUT, "short_output", OUTPUT_SIZE);
+    play_allocations(0);
+
+    pool_stats before[NUMBER_OF_POOLS];
+    for (size_t i = 0; i < NUMBER_OF_POOLS; i++) {
+        pool_get_stats(i, &before[i]);
+    }
+    for (size_t i = 0; i < POOL_ROUNDS / POOL_GAMES; i++) {
+        play_allocations(0);
+    }
+    for (size_t i = 0; i < NUMBER_OF_POOLS; i++) {
+        pool_stats after;
+        pool_get_stats(i, &after);
+        if (after.number_of_slabs != before[i].number_of_slabs) {
+            fprintf(stderr, "the %s pool took %zu slabs while the number of games was steady\n", after.name,
+                    after.number_of_slabs - before[i].number_of_slabs);
+            exit(EXIT_FAILURE);
+        }
+    }
+    play_allocations(1);
+}
+
+// function that lets the first of two sockets flood while the second sends a single byte, and serves every socket of
+// the readiness set with one read of at most READ_SIZE bytes in turn, until the second socket has had its turn
+// exits if more than one read of the flooding socket came before the turn of the second socket
+void check_fairness() {
+    int flooding[2];
+    int quiet[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, flooding) == -1 || socketpair(AF_UNIX, SOCK_STREAM, 0, quiet) == -1) {
+        perror("socketpair");
+        exit(EXIT_FAILURE);
+    }
+    int buffer_size = FLOOD_BYTES;
+    if (setsockopt(flooding[0], SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size)) == -1 ||
+        fcntl(flooding[0], F_SETFL, O_NONBLOCK) == -1) {
+        perror("check_fairness");
+        exit(EXIT_FAILURE);
+    }
+
+    // fill the flooding socket as far as it goes, then let the quiet socket send its byte
+    char buffer[READ_SIZE];
+    memset(buffer, 'x', sizeof(buffer));
+    size_t number_of_flooded = 0;
+    ssize_t length;
+    while (number_of_flooded < FLOOD_BYTES && (length = write(flooding[0], buffer, sizeof(buffer))) > 0) {
+        number_of_flooded += length;
+    }
+    if (write(quiet[0], "x", 1) != 1) {
+        perror("write");
+        exit(EXIT_FAILURE);
+    }
+
+    int sockets[2] = {flooding[1], quiet[1]};
+    readiness_set set;
+    if (readiness_set_init(&set) == -1 || watch_socket(set.event_loop, sockets[0], &sockets[0]) == -1 ||
+        watch_socket(set.event_loop, sockets[1], &sockets[1]) == -1) {
+        perror("check_fairness");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t number_of_read = 0;
+    size_t is_served = 0;
+    while (is_served == 0) {
+        if (wait_for_ready(&set, -1) == -1 || set.number_of_ready == 0) {
+            perror("check_fairness");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < set.number_of_ready && is_served == 0; i++) {
+            int ready = *(int *) set.ready[i].data.ptr;
+            length = read(ready, buffer, sizeof(buffer));
+            if (ready == quiet[1]) {
+                is_served = 1;
+            } else if (length > 0) {
+                number_of_read += length;
+            }
+        }
+    }
+    if (number_of_read > READ_SIZE) {
+        fprintf(stderr, "the readiness set read %zu bytes of the flooding socket before its opponent\n",
+                number_of_read);
+        exit(EXIT_FAILURE);
+    }
+
+    close(set.event_loop);
+    close(flooding[0]);
+    close(flooding[1]);
+    close(quiet[0]);
+    close(quiet[1]);
+}
+
+// function that arms timers at random ticks, some of them past the range of the wheel, moves or cancels some of them,
+// and advances the wheel by random steps
+// exits unless every armed timer expires exactly once, in the first advance that reaches its tick
+void check_timers() {
+    counted_timer *timers = calloc(TIMER_CASES, sizeof(counted_timer));
+    if (timers == NULL) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    srand(1);
+    timer_wheel wheel;
+    long now = 1000003;
+    timer_wheel_init(&wheel, now);
+    for (size_t i = 0; i < TIMER_CASES; i++) {
+        long delay = i % 100 == 0 ? (long) rand() % (1L << 26) : rand() % TIMER_SPAN;
+        timer_init(&timers[i].wheel_timer, 0, &timers[i]);
+        timer_arm(&wheel, &timers[i].wheel_timer, now + delay);
+    }
+    for (size_t i = 0; i < TIMER_CASES; i += 3) {
+        if (i % 2 == 0) {
+            timer_cancel(&wheel, &timers[i].wheel_timer);
+        } else {
+            timer_arm(&wheel, &timers[i].wheel_timer, now + rand() % TIMER_SPAN);
+        }
+    }
+
+    // the wheel may sleep for the timeout it returns, but never past the earliest expiry
+    long previous = now - 1;
+    while (wheel.number_of_timers > 0) {
+        long timeout = timer_wheel_get_timeout(&wheel, now);
+        long earliest = now + timeout;
+        now += rand() % 4 == 0 ? timeout : 1 + rand() % (timeout + 1);
+        timer *expired;
+        while ((expired = timer_wheel_expire(&wheel, now)) != NULL) {
+            if (expired->expires > now || expired->expires <= previous || expired->expires < earliest) {
+                fprintf(stderr, "a timer for tick %ld expired between ticks %ld and %ld\n", expired->expires,
+                        previous, now);
+                exit(EXIT_FAILURE);
+            }
+            ((counted_timer *) expired->owner)->number_of_expiries++;
+        }
+        previous = now;
+    }
+
+    for (size_t i = 0; i < TIMER_CASES; i++) {
+        size_t is_cancelled = i % 3 == 0 && i % 2 == 0;
+        if (timers[i].number_of_expiries != (is_cancelled ? 0 : 1)) {
+            fprintf(stderr, "timer %zu expired %zu times\n", i, timers[i].number_of_expiries);
+            exit(EXIT_FAILURE);
+        }
+    }
+    timers = Free(timers);
+}
+
+// function that counts from several threads while this thread takes snapshots, and exits if a counter of a snapshot is
+// ever lower than in the snapshot before it, or unless the last snapshot holds every update and both formats report it
+void check_metrics() {
+    pthread_t threads[METRIC_THREADS];
+    for (size_t i = 0; i < METRIC_THREADS; i++) {
+        if (pthread_create(&threads[i], NULL, &count_metrics, (void *) (uintptr_t) i) != 0) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // a reader never makes the threads wait, and sees every counter grow
+    metrics_snapshot snapshot;
+    uint64_t previous = 0;
+    while (previous < (uint64_t) 13 * METRIC_CASES) {
+        metrics_take_snapshot(&snapshot);
+        if (snapshot.values[METRIC_BYTES_RECEIVED] < previous) {
+            fprintf(stderr, "a snapshot counted %" PRIu64 " bytes after one that counted %" PRIu64 "\n",
+                    snapshot.values[METRIC_BYTES_RECEIVED], previous);
+            exit(EXIT_FAILURE);
+        }
+        previous = snapshot.values[METRIC_BYTES_RECEIVED];
+        sched_yield();
+    }
+    for (size_t i = 0; i < METRIC_THREADS; i++) {
+        if (pthread_join(threads[i], NULL) != 0) {
+            perror("pthread_join");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    metrics_take_snapshot(&snapshot);
+    uint64_t number_of_messages = 0;
+    for (size_t i = 0; i < METRIC_OPCODES; i++) {
+        number_of_messages += snapshot.values[METRIC_MESSAGES_RECEIVED + i];
+    }
+    if (number_of_messages != METRIC_CASES || snapshot.values[METRIC_BYTES_RECEIVED] != (uint64_t) 13 * METRIC_CASES ||
+        snapshot.values[METRIC_LIVE_GAMES] != 0) {
+        fprintf(stderr, "the snapshot counted %" PRIu64 " messages, %" PRIu64 " bytes and %" PRId64 " games\n",
+                number_of_messages, snapshot.values[METRIC_BYTES_RECEIVED],
+                (int64_t) snapshot.values[METRIC_LIVE_GAMES]);
+        exit(EXIT_FAILURE);
+    }
+
+    char report[METRICS_REPORT_SIZE];
+    char line[128];
+    metrics_format_snapshot(&snapshot, METRICS_PROMETHEUS, report, sizeof(report));
+    snprintf(line, sizeof(line), "\nttts_bytes_received_total %" PRIu64 "\n", (uint64_t) 13 * METRIC_CASES);
+    size_t is_reported = strstr(report, line) != NULL && strstr(report, "# TYPE ttts_live_games gauge\n") != NULL;
+    metrics_format_snapshot(&snapshot, METRICS_TEXT, report, sizeof(report));
+    snprintf(line, sizeof(line), "\nmessages_received_total PLAY %" PRIu64 "\n",
+             snapshot.values[METRIC_MESSAGES_RECEIVED]);
+    if (is_reported == 0 || strstr(report, line) == NULL) {
+        fprintf(stderr, "the report of the metrics is missing a value\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// function that makes the updates of one thread of the metrics check, which counts a message of each opcode in turn
+// and its bytes, and begins or ends a game, where half of the threads begin the games that the others end
+void* count_metrics(void *arg) {
+    size_t thread = (uintptr_t) arg;
+    for (size_t i = thread; i < METRIC_CASES; i += METRIC_THREADS) {
+        metrics_add(METRIC_MESSAGES_RECEIVED + i % METRIC_OPCODES, 1);
+        metrics_add(METRIC_BYTES_RECEIVED, 13);
+        metrics_add(METRIC_LIVE_GAMES, i % 2 == 0 ? 1 : -1);
+    }
+    return NULL;
+}
+
+// function that records random latencies between nanoseconds and 18 minutes into a histogram, and exits unless every
+// percentile is at least the exact percentile and at most 1/32 above it
+void check_histograms() {
+    uint64_t *values = calloc(HISTOGRAM_CASES, sizeof(uint64_t));
+    histogram *h = calloc(1, sizeof(histogram));
+    histogram *merged = calloc(1, sizeof(histogram));
+    if (values == NULL || h == NULL || merged == NULL) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    srand(1);
+    for (size_t i = 0; i < HISTOGRAM_CASES; i++) {
+        values[i] = ((uint64_t) rand() << 9 ^ rand()) >> (rand() % 41);
+        histogram_record(h, values[i]);
+    }
+    histogram_merge(merged, h);
+    qsort(values, HISTOGRAM_CASES, sizeof(uint64_t), &compare_values);
+
+    const double percentiles[] = {0.0, 1.0, 50.0, 90.0, 99.0, 99.9, 99.99, 100.0};
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
+        size_t rank = (size_t) (percentiles[i] / 100.0 * HISTOGRAM_CASES + 0.999999);
+        uint64_t exact = values[rank == 0 ? 0 : rank - 1];
+        uint64_t value = histogram_get_percentile(merged, percentiles[i]);
+        if (value < exact || value - exact > exact / HISTOGRAM_SUB_BUCKETS) {
+            fprintf(stderr, "the histogram put the %.2fth percentile at %" PRIu64 " instead of %" PRIu64 "\n",
+                    percentiles[i], value, exact);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (merged->count != HISTOGRAM_CASES || merged->max != values[HISTOGRAM_CASES - 1]) {
+        fprintf(stderr, "the histogram counted %" PRIu64 " latencies up to %" PRIu64 "\n", merged->count,
+                merged->max);
+        exit(EXIT_FAILURE);
+    }
+    values = Free(values);
+    h = Free(h);
+    merged = Free(merged);
+}
+
+// function that compares two values for qsort()
+int compare_values(const void *a, const void *b) {
+    uint64_t first = *(const uint64_t *) a;
+    uint64_t second = *(const uint64_t *) b;
+    return first < second ? -1 : first > second;
+}
+
+// function that records more events than the ring of the main thread holds, writes a dump of the recorder and reads it
+// back, and exits unless the dump holds exactly the newest events of the ring in the order they were recorded
+void check_recorder() {
+    recorder_start(NULL);
+    for (size_t i = 0; i < FLIGHT_CASES; i++) {
+        recorder_record(i % NUMBER_OF_FLIGHT_KINDS, i, i % NUMBER_OF_STATES, (uint32_t) i % NUMBER_OF_STATES);
+    }
+
+    FILE *dump = tmpfile();
+    if (dump == NULL) {
+        perror("tmpfile");
+        exit(EXIT_FAILURE);
+    }
+    ssize_t size = recorder_write(fileno(dump));
+    if (size != (ssize_t) recorder_get_size() || size != (ssize_t) (sizeof(flight_header) + sizeof(flight_ring))) {
+        fprintf(stderr, "the dump of the flight recorder took %zd bytes\n", size);
+        exit(EXIT_FAILURE);
+    }
+    char *recording = malloc(size);
+    if (recording == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    rewind(dump);
+    if (fread(recording, 1, size, dump) != (size_t) size) {
+        perror("fread");
+        exit(EXIT_FAILURE);
+    }
+    fclose(dump);
+
+    // the ring holds the newest events, from the oldest one at the head of the ring
+    const flight_header *header = (const flight_header *) recording;
+    const flight_ring *ring = (const flight_ring *) (recording + sizeof(flight_header));
+    if (memcmp(header->magic, FLIGHT_MAGIC, sizeof(header->magic)) != 0 || header->number_of_rings != 1 ||
+        ring->head != FLIGHT_CASES) {
+        fprintf(stderr, "the dump of the flight recorder has %u rings and %" PRIu64 " events\n",
+                header->number_of_rings, ring->head);
+        exit(EXIT_FAILURE);
+    }
+    char line[FLIGHT_LINE_SIZE];
+    uint64_t last_time = 0;
+    for (uint64_t i = FLIGHT_CASES - FLIGHT_RING_EVENTS; i < FLIGHT_CASES; i++) {
+        const flight_event *event = &ring->events[i & (FLIGHT_RING_EVENTS - 1)];
+        if (event->connection != i || event->kind != i % NUMBER_OF_FLIGHT_KINDS || event->time < last_time ||
+            recorder_describe(header, event, line, sizeof(line)) <= 0) {
+            fprintf(stderr, "event %" PRIu64 " of the flight recorder is event %" PRIu64 "\n", i, event->connection);
+            exit(EXIT_FAILURE);
+        }
+        last_time = event->time;
+    }
+
+    // an event with an unknown kind is one the thread was writing while the ring was dumped, and is not decoded
+    flight_event torn = ring->events[0];
+    torn.kind = NUMBER_OF_FLIGHT_KINDS;
+    if (recorder_describe(header, &torn, line, sizeof(line)) != -1) {
+        fprintf(stderr, "the flight recorder decoded a torn event\n");
+        exit(EXIT_FAILURE);
+    }
+    recording = Free(recording);
+}
+
 void* A_client_1(void *arg) {
     while (1) {
         obtain_mutex_lock(&game_mutex);
@@ -918,3 +1759,355 @@ void* C_client_2(void *arg) {
     pthread_exit(NULL);
 }
 
+void* D_client_1(void *arg) {
+    while (1) {
+        obtain_mutex_lock(&game_mutex);
+        if (game_role != 12) {
+            release_mutex_lock(&game_mutex);
+            continue;
+        } else {
+            game_role++;
+            break;
+        }
+    }
+
+    // connect idle clients that never send PLAY, so they stay in the handshake stage
+    int *idle_sockets = malloc(sizeof(int) * IDLE_CLIENTS);
+    if (idle_sockets == NULL) {
+        perror("malloc");
+        pthread_exit(NULL);
+    }
+    for (size_t i = 0; i < IDLE_CLIENTS; i++) {
+        idle_sockets[i] = get_client_socket(host, port);
+    }
+
+    // get client socket
+    long start = get_time_in_ms();
+    int client_socket = get_client_socket(host, port);
+    char *buffer = NULL;
+
+    // PLAY|6|Alice|
+    p_play(client_socket, "6", "Alice");
+    parse_wait(client_socket, &buffer);
+
+    // release the game lock
+    release_mutex_lock(&game_mutex);
+
+    parse_begn(client_socket, "X", "Bob", &buffer);
+
+    // the idle clients must not delay pairing
+    if (get_time_in_ms() - start > PAIRING_TIMEOUT) {
+        perror("BEGN: pairing was delayed by idle clients");
+        pthread_exit(NULL);
+    }
+
+    // MOVE|6|X|2,2|
+    p_move(client_socket, "6", "X", "2,2");
+    parse_movd(client_socket, "X", "2", "2", "....X....", &buffer);
+
+    // Opponent: RSGN|0|
+    parse_over(client_socket, "W", "One player has resigned.", &buffer);
+
+    // close client and idle clients
+    close(client_socket);
+    for (size_t i = 0; i < IDLE_CLIENTS; i++) {
+        close(idle_sockets[i]);
+    }
+    idle_sockets = Free(idle_sockets);
+
+    // print success
+    printf("D CLIENT 1: PASSED\n");
+
+    obtain_mutex_lock(&main_mutex);
+    should_exit++;
+    release_mutex_lock(&main_mutex);
+
+    pthread_exit(NULL);
+}
+
+void* D_client_2(void *arg) {
+    while (1) {
+        obtain_mutex_lock(&game_mutex);
+        if (game_role != 13) {
+            release_mutex_lock(&game_mutex);
+            continue;
+        } else {
+            game_role++;
+            break;
+        }
+    }
+
+    // get client socket
+    long start = get_time_in_ms();
+    int client_socket = get_client_socket(host, port);
+    char *buffer = NULL;
+
+    // PLAY|4|Bob|
+    p_play(client_socket, "4", "Bob");
+    parse_wait(client_socket, &buffer);
+
+    // release the game lock
+    release_mutex_lock(&game_mutex);
+
+    parse_begn(client_socket, "O", "Alice", &buffer);
+
+    // the idle clients of client 1 must not delay pairing
+    if (get_time_in_ms() - start > PAIRING_TIMEOUT) {
+        perror("BEGN: pairing was delayed by idle clients");
+        pthread_exit(NULL);
+    }
+
+    // Opponent: MOVE|6|X|2,2|
+    parse_movd(client_socket, "X", "2", "2", "....X....", &buffer);
+
+    // RSGN|0|
+    p_rsgn(client_socket, "0");
+    parse_over(client_socket, "L", "One player has resigned.", &buffer);
+
+    // close client
+    close(client_socket);
+
+    // print success
+    printf("D CLIENT 2: PASSED\n");
+
+    obtain_mutex_lock(&main_mutex);
+    should_exit++;
+    release_mutex_lock(&main_mutex);
+
+    pthread_exit(NULL);
+}
+
+void* E_client_1(void *arg) {
+    while (1) {
+        obtain_mutex_lock(&game_mutex);
+        if (game_role != 14) {
+            release_mutex_lock(&game_mutex);
+            continue;
+        } else {
+            game_role++;
+            break;
+        }
+    }
+
+    // get client socket
+    int client_socket = get_client_socket(host, port);
+    char *buffer = NULL;
+
+    // PLAY|6|Carol|
+    p_play(client_socket, "6", "Carol");
+    parse_wait(client_socket, &buffer);
+
+    // release the game lock
+    release_mutex_lock(&game_mutex);
+
+    parse_begn(client_socket, "X", "Dave", &buffer);
+
+    // Opponent: never reads, and is dropped once the server has queued too much for it
+    while (check_connection_drop(client_socket) != 0) {}
+
+    // close client
+    close(client_socket);
+
+    // print success
+    printf("E CLIENT 1: PASSED\n");
+
+    obtain_mutex_lock(&main_mutex);
+    should_exit++;
+    release_mutex_lock(&main_mutex);
+
+    pthread_exit(NULL);
+}
+
+void* E_client_2(void *arg) {
+    while (1) {
+        obtain_mutex_lock(&game_mutex);
+        if (game_role != 15) {
+            release_mutex_lock(&game_mutex);
+            continue;
+        } else {
+            game_role++;
+            break;
+        }
+    }
+
+    // get client socket
+    int client_socket = get_client_socket(host, port);
+    char *buffer = NULL;
+
+    // PLAY|5|Dave|
+    p_play(client_socket, "5", "Dave");
+    parse_wait(client_socket, &buffer);
+
+    // release the game lock
+    release_mutex_lock(&game_mutex);
+
+    parse_begn(client_socket, "O", "Carol", &buffer);
+
+    // MOVE|6|O|2,1| out of turn, over and over, without ever reading the INVL messages it is sent
+    const char *move = "MOVE|6|O|2,1|";
+    size_t move_length = strlen(move);
+    char *moves = malloc(FLOOD_MOVES * move_length);
+    if (moves == NULL) {
+        perror("malloc");
+        pthread_exit(NULL);
+    }
+    for (size_t i = 0; i < FLOOD_MOVES; i++) {
+        memcpy(moves + i * move_length, move, move_length);
+    }
+
+    // the server must drop the connection long before FLOOD_LIMIT bytes have been sent
+    size_t bytes_sent = 0;
+    while (bytes_sent < FLOOD_LIMIT) {
+        ssize_t send_status = send(client_socket, moves, FLOOD_MOVES * move_length, MSG_NOSIGNAL);
+        if (send_status == -1) {
+            break;
+        }
+        bytes_sent += send_status;
+    }
+    moves = Free(moves);
+    if (bytes_sent >= FLOOD_LIMIT) {
+        perror("MOVE: the server kept a client that never reads");
+        pthread_exit(NULL);
+    }
+
+    // close client
+    close(client_socket);
+
+    // print success
+    printf("E CLIENT 2: PASSED\n");
+
+    obtain_mutex_lock(&main_mutex);
+    should_exit++;
+    release_mutex_lock(&main_mutex);
+
+    pthread_exit(NULL);
+}
+
+void* F_client_1(void *arg) {
+    while (1) {
+        obtain_mutex_lock(&game_mutex);
+        if (game_role != 16) {
+            release_mutex_lock(&game_mutex);
+            continue;
+        } else {
+            game_role++;
+            break;
+        }
+    }
+
+    // get client socket of the server with time controls
+    int client_socket = get_client_socket(host, clock_port);
+    char *buffer = NULL;
+
+    // PLAY|5|Erin|
+    p_play(client_socket, "5", "Erin");
+    parse_wait(client_socket, &buffer);
+
+    // release the game lock
+    release_mutex_lock(&game_mutex);
+
+    parse_begn(client_socket, "X", "Frank", &buffer);
+
+    // MOVE|6|X|2,2|, which adds the increment to the clock of X
+    p_move(client_socket, "6", "X", "2,2");
+    parse_movd(client_socket, "X", "2", "2", "....X....", &buffer);
+
+    // Opponent: MOVE|6|O|1,1|
+    parse_movd(client_socket, "O", "1", "1", "O...X....", &buffer);
+
+    // think for longer than the clock started with, which only the increment leaves time for
+    nanosleep((const struct timespec[]){{0, (CLOCK_TIME + CLOCK_INCREMENT / 2) * 1000000L}}, NULL);
+
+    // MOVE|6|X|3,3|
+    p_move(client_socket, "6", "X", "3,3");
+    parse_movd(client_socket, "X", "3", "3", "O...X...X", &buffer);
+
+    // Opponent: runs out of time
+    parse_over(client_socket, "W", "One player has run out of time.", &buffer);
+    while (check_connection_drop(client_socket) != 0) {}
+
+    // close client
+    close(client_socket);
+
+    // print success
+    printf("F CLIENT 1: PASSED\n");
+
+    obtain_mutex_lock(&main_mutex);
+    should_exit++;
+    release_mutex_lock(&main_mutex);
+
+    pthread_exit(NULL);
+}
+
+void* F_client_2(void *arg) {
+    while (1) {
+        obtain_mutex_lock(&game_mutex);
+        if (game_role != 17) {
+            release_mutex_lock(&game_mutex);
+            continue;
+        } else {
+            game_role++;
+            break;
+        }
+    }
+
+    // get client socket of the server with time controls
+    int client_socket = get_client_socket(host, clock_port);
+    char *buffer = NULL;
+
+    // PLAY|6|Frank|
+    p_play(client_socket, "6", "Frank");
+    parse_wait(client_socket, &buffer);
+
+    // release the game lock
+    release_mutex_lock(&game_mutex);
+
+    parse_begn(client_socket, "O", "Erin", &buffer);
+
+    // Opponent: MOVE|6|X|2,2|
+    parse_movd(client_socket, "X", "2", "2", "....X....", &buffer);
+
+    // MOVE|6|O|1,1|
+    p_move(client_socket, "6", "O", "1,1");
+    parse_movd(client_socket, "O", "1", "1", "O...X....", &buffer);
+
+    // Opponent: MOVE|6|X|3,3|
+    parse_movd(client_socket, "X", "3", "3", "O...X...X", &buffer);
+
+    // think for longer than the clock with the increment, then move anyway
+    nanosleep((const struct timespec[]){{0, (CLOCK_TIME + CLOCK_INCREMENT + CLOCK_TIME / 2) * 1000000L}}, NULL);
+
+    // MOVE|6|O|1,3| after the clock ran out
+    p_move(client_socket, "6", "O", "1,3");
+    parse_over(client_socket, "L", "One player has run out of time.", &buffer);
+    while (check_connection_drop(client_socket) != 0) {}
+
+    // close client
+    close(client_socket);
+
+    // the game must have been freed, and the names of both players with it
+    long live_games = -1;
+    long player_names = -1;
+    for (size_t i = 0; i < STATS_ATTEMPTS && (live_games != 0 || player_names != 0); i++) {
+        if (read_stat("live_games", &live_games) == -1 || read_stat("player_names", &player_names) == -1) {
+            perror("OVER: cannot read the metrics of the server");
+            pthread_exit(NULL);
+        }
+        nanosleep((const struct timespec[]){{0, 10000000L}}, NULL);
+    }
+    if (live_games != 0 || player_names != 0) {
+        perror("OVER: the game was not freed");
+        pthread_exit(NULL);
+    }
+    kill(clock_server, SIGKILL);
+    waitpid(clock_server, NULL, 0);
+
+    // print success
+    printf("F CLIENT 2: PASSED\n");
+
+    obtain_mutex_lock(&main_mutex);
+    should_exit++;
+    release_mutex_lock(&main_mutex);
+
+    pthread_exit(NULL);
+}
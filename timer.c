@@ -0,0 +1,235 @@
+#include "timer.h"
+
+// prototypes of internal functions
+static void link_timer(timer *list, timer *t);
+static void unlink_timer(timer *t);
+static void place_timer(timer_wheel *wheel, timer *t);
+static void cascade_slots(timer_wheel *wheel, long tick);
+static void advance_wheel(timer_wheel *wheel, long now);
+static uint64_t rotate_slots(uint64_t occupied, size_t current);
+
+// function that initializes an empty timer wheel whose first tick is the given time
+void timer_wheel_init(timer_wheel *wheel, long now) {
+    wheel->now = now;
+    wheel->number_of_timers = 0;
+    for (size_t i = 0; i < TIMER_LEVELS; i++) {
+        wheel->occupied[i] = 0;
+    }
+
+    // every slot and the list of expired timers start out as an empty circular list
+    for (size_t i = 0; i < TIMER_LEVELS * TIMER_SLOTS; i++) {
+        wheel->slots[i].previous = &wheel->slots[i];
+        wheel->slots[i].next = &wheel->slots[i];
+    }
+    wheel->expired.previous = &wheel->expired;
+    wheel->expired.next = &wheel->expired;
+}
+
+// function that initializes a timer that is not armed, the kind and owner tell the caller what expired
+void timer_init(timer *t, size_t kind, void *owner) {
+    t->previous = NULL;
+    t->next = NULL;
+    t->expires = 0;
+    t->slot = 0;
+    t->kind = kind;
+    t->owner = owner;
+}
+
+// function that arms the timer to expire at the given tick, which moves it if it is already armed
+// a tick that has already passed expires the timer the next time the wheel is advanced
+void timer_arm(timer_wheel *wheel, timer *t, long expires) {
+    timer_cancel(wheel, t);
+    t->expires = expires;
+    place_timer(wheel, t);
+}
+
+// function that disarms the timer, whether it waits in a slot or has expired and not been taken yet
+void timer_cancel(timer_wheel *wheel, timer *t) {
+    if (timer_is_armed(t) == 0) {
+        return;
+    }
+    unlink_timer(t);
+    if (t->slot == TIMER_EXPIRED_SLOT) {
+        return;
+    }
+
+    // clear the bit of a slot that is left empty
+    wheel->number_of_timers--;
+    timer *list = &wheel->slots[t->slot];
+    if (list->next == list) {
+        wheel->occupied[t->slot / TIMER_SLOTS] &= ~(1ULL << (t->slot % TIMER_SLOTS));
+    }
+}
+
+// function that checks whether the timer is armed
+size_t timer_is_armed(const timer *t) {
+    return t->previous != NULL;
+}
+
+// function that advances the wheel up to the given time and takes the next timer that has expired
+// the timer is disarmed, so it can be armed again while the caller handles it
+// returns NULL once no timer has expired
+timer* timer_wheel_expire(timer_wheel *wheel, long now) {
+    while (wheel->expired.next == &wheel->expired && wheel->now <= now) {
+        advance_wheel(wheel, now);
+    }
+    if (wheel->expired.next == &wheel->expired) {
+        return NULL;
+    }
+    timer *t = wheel->expired.next;
+    unlink_timer(t);
+    return t;
+}
+
+// function that returns how long (in ticks) the caller may wait before the wheel has to be advanced again
+// that is the expiry of the earliest timer of the first level, or the tick at which the earliest slot of a level above
+// moves its timers down, whichever comes first
+// returns -1 if no timer is armed
+long timer_wheel_get_timeout(const timer_wheel *wheel, long now) {
+    if (wheel->expired.next != &wheel->expired) {
+        return 0;
+    }
+    if (wheel->number_of_timers == 0) {
+        return -1;
+    }
+
+    long base = wheel->now;
+    long earliest = 0;
+    size_t has_earliest = 0;
+    for (size_t level = 0; level < TIMER_LEVELS; level++) {
+        if (wheel->occupied[level] == 0) {
+            continue;
+        }
+        size_t shift = TIMER_SLOT_BITS * level;
+        uint64_t rotated = rotate_slots(wheel->occupied[level], (base >> shift) & (TIMER_SLOTS - 1));
+
+        // the current slot of a level above the first has already moved its timers down unless the wheel is at its
+        // start, so the timers that are in it now come around a whole rotation later
+        size_t distance = __builtin_ctzll(rotated);
+        if (level > 0 && distance == 0 && (base & ((1L << shift) - 1)) != 0) {
+            rotated >>= 1;
+            distance = rotated == 0 ? TIMER_SLOTS : 1 + __builtin_ctzll(rotated);
+        }
+        long tick = level == 0 ? base + (long) distance : ((base >> shift) + (long) distance) << shift;
+        if (has_earliest == 0 || tick < earliest) {
+            earliest = tick;
+            has_earliest = 1;
+        }
+    }
+    return earliest <= now ? 0 : earliest - now;
+}
+
+// function that adds the timer at the end of the circular list
+static void link_timer(timer *list, timer *t) {
+    t->previous = list->previous;
+    t->next = list;
+    list->previous->next = t;
+    list->previous = t;
+}
+
+// function that removes the timer from its circular list and marks it as not armed
+static void unlink_timer(timer *t) {
+    t->previous->next = t->next;
+    t->next->previous = t->previous;
+    t->previous = NULL;
+    t->next = NULL;
+}
+
+// function that puts the timer into the slot of the lowest level that covers the ticks until it expires
+static void place_timer(timer_wheel *wheel, timer *t) {
+    long delta = t->expires - wheel->now;
+    long tick = delta < 0 ? wheel->now : t->expires;
+    size_t level = 0;
+    while (level < TIMER_LEVELS - 1 && delta >= 1L << (TIMER_SLOT_BITS * (level + 1))) {
+        level++;
+    }
+
+    // a timer past the range of the wheel waits in the furthest slot of the last level, and is placed again when
+    // that slot comes around
+    long range = 1L << (TIMER_SLOT_BITS * TIMER_LEVELS);
+    if (delta >= range) {
+        tick = wheel->now + range - 1;
+    }
+
+    size_t index = (tick >> (TIMER_SLOT_BITS * level)) & (TIMER_SLOTS - 1);
+    t->slot = level * TIMER_SLOTS + index;
+    link_timer(&wheel->slots[t->slot], t);
+    wheel->occupied[level] |= 1ULL << index;
+    wheel->number_of_timers++;
+}
+
+// function that moves the timers of every slot that comes around at the given tick one or more levels down
+// the highest level goes first, since its timers may land in the slot of a lower level that comes around now
+static void cascade_slots(timer_wheel *wheel, long tick) {
+    size_t level = 1;
+    while (level < TIMER_LEVELS - 1 && (tick & ((1L << (TIMER_SLOT_BITS * (level + 1))) - 1)) == 0) {
+        level++;
+    }
+
+    for (; level > 0; level--) {
+        size_t index = (tick >> (TIMER_SLOT_BITS * level)) & (TIMER_SLOTS - 1);
+        if ((wheel->occupied[level] & (1ULL << index)) == 0) {
+            continue;
+        }
+        wheel->occupied[level] &= ~(1ULL << index);
+
+        // take the whole slot first, so a timer that is placed again never lands in the list that is being emptied
+        timer *list = &wheel->slots[level * TIMER_SLOTS + index];
+        timer moving;
+        moving.next = list->next;
+        moving.previous = list->previous;
+        moving.next->previous = &moving;
+        moving.previous->next = &moving;
+        list->next = list;
+        list->previous = list;
+
+        while (moving.next != &moving) {
+            timer *t = moving.next;
+            unlink_timer(t);
+            wheel->number_of_timers--;
+            place_timer(wheel, t);
+        }
+    }
+}
+
+// function that handles the current tick of the wheel and moves on to the next tick that can hold a timer
+// the timers of the current slot of the first level move to the list of expired timers
+static void advance_wheel(timer_wheel *wheel, long now) {
+    // without timers, nothing can happen until now
+    if (wheel->number_of_timers == 0) {
+        wheel->now = now + 1;
+        return;
+    }
+
+    long tick = wheel->now;
+    size_t index = tick & (TIMER_SLOTS - 1);
+    if (index == 0) {
+        cascade_slots(wheel, tick);
+    }
+
+    if (wheel->occupied[0] & (1ULL << index)) {
+        timer *list = &wheel->slots[index];
+        while (list->next != list) {
+            timer *t = list->next;
+            unlink_timer(t);
+            t->slot = TIMER_EXPIRED_SLOT;
+            link_timer(&wheel->expired, t);
+            wheel->number_of_timers--;
+        }
+        wheel->occupied[0] &= ~(1ULL << index);
+    }
+
+    // skip to the next occupied slot of the first level in this rotation, or to the end of the rotation where the
+    // levels above move their timers down, but never past now
+    uint64_t later = index == TIMER_SLOTS - 1 ? 0 : wheel->occupied[0] >> (index + 1) << (index + 1);
+    long next = later != 0 ? tick - (long) index + __builtin_ctzll(later) : (tick | (TIMER_SLOTS - 1)) + 1;
+    wheel->now = next <= now ? next : now + 1;
+}
+
+// function that rotates the bits of the occupied slots of a level, so the bit of the current slot comes first
+static uint64_t rotate_slots(uint64_t occupied, size_t current) {
+    if (current == 0) {
+        return occupied;
+    }
+    return (occupied >> current) | (occupied << (TIMER_SLOTS - current));
+}
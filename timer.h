@@ -0,0 +1,49 @@
+#ifndef P3_TIMER_H
+#define P3_TIMER_H
+
+#include <stdint.h>
+#include "helper.h"
+
+// declare enumeration for constants of the timer wheel
+// each of the 4 levels has 64 slots, and a slot of a level covers 64 times the ticks of a slot of the level below,
+// so the wheel covers 2^24 ticks (more than 4 hours of milliseconds) and later timers wait in the last level
+typedef enum timer_constant {
+    TIMER_LEVELS = 4,
+    TIMER_SLOT_BITS = 6,
+    TIMER_SLOTS = 64,
+    TIMER_EXPIRED_SLOT = TIMER_LEVELS * TIMER_SLOTS,
+} timer_constant;
+
+// define struct for a timer, which is embedded in the object that owns it, so arming it allocates nothing
+// an armed timer is linked into a slot of the wheel, or into the list of expired timers once its tick has passed
+typedef struct timer {
+    struct timer *previous;
+    struct timer *next;
+    long expires;
+    size_t slot;
+    size_t kind;
+    void *owner;
+} timer;
+
+// define struct for a hierarchical timer wheel, which is owned by one thread and counts time in ticks (milliseconds)
+// a timer goes into the lowest level whose slots cover its expiry, and moves one level down each time the slot of its
+// level comes around, so arming and cancelling take O(1) and every timer moves at most once per level
+// the bits of occupied tell which slots hold timers, so the wheel skips empty slots instead of visiting every tick
+typedef struct timer_wheel {
+    long now;
+    size_t number_of_timers;
+    uint64_t occupied[TIMER_LEVELS];
+    timer slots[TIMER_LEVELS * TIMER_SLOTS];
+    timer expired;
+} timer_wheel;
+
+// prototypes of all functions
+void timer_wheel_init(timer_wheel *wheel, long now);
+void timer_init(timer *t, size_t kind, void *owner);
+void timer_arm(timer_wheel *wheel, timer *t, long expires);
+void timer_cancel(timer_wheel *wheel, timer *t);
+size_t timer_is_armed(const timer *t);
+timer* timer_wheel_expire(timer_wheel *wheel, long now);
+long timer_wheel_get_timeout(const timer_wheel *wheel, long now);
+
+#endif //P3_TIMER_H
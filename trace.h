@@ -0,0 +1,35 @@
+#ifndef P3_TRACE_H
+#define P3_TRACE_H
+
+// the statically defined tracepoints of the server, which bpftrace and perf attach to as usdt:./ttts:ttts:<probe>
+// with sys/sdt.h, a tracepoint is a single nop in the code and a note in the binary that tells a tracer where it is and
+// where its arguments are, so it costs nothing until a tracer attaches to it
+// without sys/sdt.h, or when the server is built with -DTTTS_NO_TRACEPOINTS, the tracepoints compile to nothing
+#if !defined(TTTS_NO_TRACEPOINTS) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define TTTS_HAS_TRACEPOINTS 1
+#endif
+#endif
+
+// the arguments of every tracepoint start with the id of the connection, which is unique for the life of the server
+// accept: connection id, socket
+// parse: connection id, opcode (in the order of message_code), length of the message
+// move: connection id, role ('X' or 'O'), row, column
+// game_over: connection id of X, connection id of O, number of moves
+// send: connection id, number of messages, number of bytes
+#ifdef TTTS_HAS_TRACEPOINTS
+#define TRACE_ACCEPT(id, socket) DTRACE_PROBE2(ttts, accept, id, socket)
+#define TRACE_PARSE(id, opcode, length) DTRACE_PROBE3(ttts, parse, id, opcode, length)
+#define TRACE_MOVE(id, role, row, col) DTRACE_PROBE4(ttts, move, id, role, row, col)
+#define TRACE_GAME_OVER(id_x, id_o, moves) DTRACE_PROBE3(ttts, game_over, id_x, id_o, moves)
+#define TRACE_SEND(id, messages, bytes) DTRACE_PROBE3(ttts, send, id, messages, bytes)
+#else
+#define TRACE_ACCEPT(id, socket) ((void) (id), (void) (socket))
+#define TRACE_PARSE(id, opcode, length) ((void) (id), (void) (opcode), (void) (length))
+#define TRACE_MOVE(id, role, row, col) ((void) (id), (void) (role), (void) (row), (void) (col))
+#define TRACE_GAME_OVER(id_x, id_o, moves) ((void) (id_x), (void) (id_o), (void) (moves))
+#define TRACE_SEND(id, messages, bytes) ((void) (id), (void) (messages), (void) (bytes))
+#endif
+
+#endif //P3_TRACE_H
@@ -1,68 +1,284 @@
 #define _POSIX_C_SOURCE 200809L
 #include <signal.h>
 #include <pthread.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/eventfd.h>
 #include "msg.h"
+#include "uring.h"
+#include "queue.h"
+#include "frames.h"
+#include "logger.h"
+#include "names.h"
+#include "pool.h"
+#include "timer.h"
+#include "metrics.h"
+#include "trace.h"
+#include "recorder.h"
+
+// declare enumeration for the states of a client connection
+typedef enum client_state {
+    CLIENT_HANDSHAKE = 0,
+    CLIENT_WAITING = 1,
+    CLIENT_PLAYING = 2,
+    CLIENT_MOVING = 3,
+    CLIENT_CLOSED = 4,
+} client_state;
+
+// declare enumeration for constants of the event loop
+typedef enum server_constant {
+    MAX_MESSAGE_TIMEOUT = 60000,
+    DEFAULT_HANDSHAKE_TIMEOUT = 10000,
+    DEFAULT_IDLE_TIMEOUT = 300000,
+    MAX_IDLE_TIMEOUT = 86400000,
+    MAX_GATHERED_MESSAGES = 16,
+    SHORT_OUTPUT_CAPACITY = 96,
+    MAX_QUEUED_MEMORY = 65536,
+    MAX_SHARDS = 256,
+} server_constant;
+
+// declare enumeration for the backends that the event loop can be driven by
+typedef enum server_backend {
+    BACKEND_EPOLL = 0,
+    BACKEND_IO_URING = 1,
+} server_backend;
+
+// declare enumeration for the kinds of io_uring requests, which are stored in the low bits of the user data
+typedef enum request_kind {
+    REQUEST_ACCEPT = 0,
+    REQUEST_RECEIVE = 1,
+    REQUEST_SEND = 2,
+    REQUEST_HANDOFF = 3,
+    REQUEST_KIND_MASK = 3,
+} request_kind;
+
+// declare enumeration for the kinds of timers of a shard
+// a client has a deadline for its partial message and for its PLAY message, and a game has a deadline for its next
+// message, after which it is abandoned, and with time controls a deadline for the clock of the player to move
+typedef enum timer_kind {
+    TIMER_MESSAGE = 0,
+    TIMER_HANDSHAKE = 1,
+    TIMER_GAME = 2,
+    TIMER_CLOCK = 3,
+} timer_kind;
+
+// define struct for the options the server was started with
+typedef struct server_config {
+    const char *port;
+    const char *admin_port;
+    const char *recording_path;
+    server_backend backend;
+    size_t number_of_shards;
+    size_t message_timeout;
+    size_t handshake_timeout;
+    size_t idle_timeout;
+    size_t clock;
+    size_t increment;
+    log_policy log_policy;
+} server_config;
+
+// define struct for a message that is queued for a client (or being sent to it)
+// an output comes from the short pool if its message fits SHORT_OUTPUT_CAPACITY bytes, which every frame but a BEGN
+// message with a long name does, and from the long pool otherwise, whose objects hold the longest BEGN message
+// outputs go back to their pool once they are sent
+// a response to a message of a client keeps the opcode of that message and when it arrived, so the latency of the
+// response is recorded once it has been written
+typedef struct output {
+    struct output *next;
+    size_t length;
+    uint64_t cause_arrived_at;
+    message_code cause_code;
+    char message[];
+} output;
+
+// define struct for a client connection that is owned by the event loop
+// the bytes received from the client are kept in a fixed-capacity queue, so receiving a message allocates nothing
+// the queued messages of a client are gathered by the vectors of its send header, so they leave in a single writev()
+// or sendmsg(), and with io_uring the header stays with the client until its send completes
+// with epoll, the messages that did not fit in the send buffer of the socket stay queued, the bytes of the first one
+// that were already written are skipped, and the client is blocked, so its socket is watched until it is writable
+// output_memory is the memory that the outputs of the queued messages take, which MAX_QUEUED_MEMORY caps
+// clients, games, handoffs and player names come from pools, so a steady stream of games does not allocate from the heap
+typedef struct client {
+    uint64_t id;
+    int socket;
+    char host[NUMERIC_HOST_LENGTH];
+    char port[NUMERIC_PORT_LENGTH];
+    char *player_name;
+    client_state state;
+    struct game *game;
+    size_t index;
+    timer message_timer;
+    timer handshake_timer;
+    struct client *next_closed;
+    output *first_output;
+    output *last_output;
+    size_t output_memory;
+    size_t output_offset;
+    size_t is_blocked;
+    size_t sends_in_flight;
+    struct msghdr send_header;
+    struct iovec send_vectors[MAX_GATHERED_MESSAGES];
+    size_t is_receiving;
+    size_t is_shut_down;
+    size_t is_flushing;
+    struct client *next_flush;
+    uint64_t arrived_at;
+    byte_queue input;
+} client;
 
 // define struct for the game
+// clients[0] plays X and clients[1] plays O
+// with time controls, each player has a clock of the milliseconds they have left, and the clock of the player to move
+// runs from the start of their turn, which the clock timer of the game ends
+// the game is freed once neither client refers to it anymore, since messages of the game may still be in flight after
+// it ends
 typedef struct game {
-    int client1_socket;
-    int client2_socket;
-    char *client1_host;
-    char *client2_host;
-    char *client1_port;
-    char *client2_port;
-    char *player1_name;
-    char *player2_name;
-    char *msg_buffer1;
-    char *msg_buffer2;
+    client *clients[2];
+    bitboard board;
+    size_t turn;
+    size_t draw_response_index;
+    size_t is_draw_suggested;
+    size_t number_of_clients;
+    timer idle_timer;
+    long clocks[2];
+    long turn_started;
+    timer clock_timer;
 } game;
 
+// define struct for clients that are handed from one shard to another
+// a client that is waiting for an opponent is handed to the first shard, which pairs every client,
+// and the two clients of a new game are handed to the shard with the fewest games
+// handed_at is when a waiting client was handed over, which is only read while the metrics are served
+typedef struct handoff {
+    struct client *clients[2];
+    size_t number_of_clients;
+    uint64_t handed_at;
+    struct server *destination;
+    struct handoff *next;
+} handoff;
+
+// define struct for the server that owns the event loop and every client socket
+// the deadlines of the clients and games of a shard are timers of its timer wheel, which the event loop waits for
+// every game and every socket is owned by exactly one shard, and clients only change shards through a handoff,
+// so the state of a game is only ever touched by the thread of its shard
+// every message that a batch of events produces is queued, and each client with queued messages is flushed once
+// while a message of a client is handled, the shard keeps its opcode and when it arrived, which its responses take on
+// with epoll, clients are flushed after the current batch of events, and closed clients are freed after that
+// with io_uring, clients are flushed before waiting and closed clients are freed once their requests complete
+typedef struct server {
+    server_backend backend;
+    int server_socket;
+    int reserve_socket;
+    readiness_set readiness;
+    uring ring;
+    client *waiting_client;
+    timer_wheel timers;
+    long handshake_timeout;
+    long idle_timeout;
+    long clock;
+    long increment;
+    client *closed_clients;
+    client *flush_clients;
+    uint64_t cause_arrived_at;
+    message_code cause_code;
+    uint64_t number_of_connections;
+    struct server *shards;
+    size_t number_of_shards;
+    size_t number_of_games;
+    handoff *departures;
+    int handoff_event;
+    pthread_mutex_t handoff_mutex;
+    handoff *first_arrival;
+    handoff *last_arrival;
+} server;
+
 // prototypes of all functions
-void check_arguments(int argc);
+void parse_arguments(int argc, char **argv, server_config *config);
+void print_usage();
 void setup_signal_handlers();
 void signal_handler(int signal);
 void obtain_mutex_lock(pthread_mutex_t *mutex);
 void release_mutex_lock(pthread_mutex_t *mutex);
-void add_player_name(const char *player_name);
-void remove_player_name(const char *player_name);
-size_t is_player_name_taken(const char *player_name);
-int get_client(int server_socket, char **client_host, char **client_port, char **player_name, char **msg_buffer);
-int get_server(const char *port);
-void simulate_server(const char *port);
-void* handle_game(void *arg);
-void free_game(game *arg);
-ssize_t get_game_status(const char *board, char *status, char *winner);
-ssize_t make_move(char *board, char role, size_t row, size_t col);
-ssize_t generate_MOVD(const char *board, char role, size_t row, size_t col, char **movd_msg);
-ssize_t generate_BEGN(char role, const char *opponent_name, char **begn_msg);
-
-// global variable for the protocol that is thread-safe because it is read only
-static const char* PROTOCOL[] = {
-        "WAIT|0|",
-        "MOVD|16|",
-        "INVL|24|That space is occupied.|",
-        "INVL|17|!Protocol error.|",
-        "INVL|21|Name already in use.|",
-        "DRAW|2|S|",
-        "DRAW|2|A|",
-        "DRAW|2|R|",
-        "BEGN|",
-        "OVER|35|W|One player has completed a line.|",
-        "OVER|35|L|One player has completed a line.|",
-        "OVER|27|W|One player has resigned.|",
-        "OVER|27|L|One player has resigned.|",
-        "OVER|32|D|Both players declared a draw.|",
-        "OVER|20|D|The grid is full.|",
+int get_server(const char *port, int is_shared);
+size_t get_number_of_cores();
+void raise_file_limit();
+void simulate_server(const server_config *config);
+void setup_shard(server *srv, const server_config *config);
+void* run_shard(void *arg);
+void run_epoll_loop(server *srv);
+void run_io_uring_loop(server *srv);
+int get_event_timeout(server *srv);
+void accept_clients(server *srv);
+int shed_connection(server *srv);
+client* create_client(server *srv, int client_socket, const char *client_host, const char *client_port);
+void read_client(server *srv, client *cl);
+void handle_received(server *srv, client *cl, size_t length, size_t is_closed);
+void handle_completion(server *srv, const struct io_uring_cqe *completion);
+void receive_completion(server *srv, client *cl, const struct io_uring_cqe *completion);
+void send_completion(server *srv, client *cl, int result);
+void process_client(server *srv, client *cl);
+void reject_client(server *srv, client *cl, const char *reason);
+void close_client(server *srv, client *cl);
+void free_closed_clients(server *srv);
+void free_client(client *cl);
+void release_client(server *srv, client *cl);
+void set_client_state(client *cl, client_state state);
+ssize_t queue_output(server *srv, client *cl, const char *message, size_t length);
+pool_kind get_output_pool(size_t length);
+size_t get_output_footprint(size_t length);
+void add_flush(server *srv, client *cl);
+void flush_clients(server *srv);
+size_t gather_outputs(client *cl);
+void send_outputs(server *srv, client *cl);
+void write_outputs(server *srv, client *cl);
+void block_client(server *srv, client *cl, size_t is_blocked);
+void free_outputs(client *cl, size_t number_of_outputs);
+void record_latencies(client *cl, size_t number_of_outputs);
+void drop_client(server *srv, client *cl);
+void update_deadline(server *srv, client *cl, size_t has_new_bytes);
+void expire_deadlines(server *srv);
+void expire_timer(server *srv, timer *expired);
+void switch_clocks(server *srv, game *current, size_t index);
+void run_out_of_time(server *srv, game *current);
+void handle_handshake(server *srv, client *cl, const message *decoded);
+void wait_for_opponent(server *srv, client *cl);
+void pair_clients(server *srv, client *client1, client *client2);
+server* get_least_loaded_shard(server *srv);
+void move_clients(server *srv, server *destination, client **clients, size_t number_of_clients);
+size_t is_client_idle(const client *cl);
+void send_handoffs(server *srv);
+void receive_handoffs(server *srv);
+ssize_t adopt_client(server *srv, client *cl);
+void start_game(server *srv, client *client1, client *client2);
+ssize_t handle_game(server *srv, game *current, size_t index, const message *decoded);
+ssize_t handle_draw(server *srv, game *current, size_t index, char action);
+ssize_t handle_move(server *srv, game *current, size_t index, char rol, size_t row, size_t col);
+void free_game(server *srv, game *current);
+void leave_game(client *cl);
+ssize_t send_and_log(server *srv, client *cl, const wire_frame *frame);
+
+// global variable for the frames of the protocol with their lengths, which is thread-safe because it is read only
+static const wire_frame PROTOCOL[] = {
+        {"WAIT|0|", 7},
+        {"MOVD|16|", 8},
+        {"INVL|24|That space is occupied.|", 32},
+        {"INVL|17|!Protocol error.|", 25},
+        {"INVL|21|Name already in use.|", 29},
+        {"DRAW|2|S|", 9},
+        {"DRAW|2|A|", 9},
+        {"DRAW|2|R|", 9},
+        {"BEGN|", 5},
+        {"OVER|35|W|One player has completed a line.|", 43},
+        {"OVER|35|L|One player has completed a line.|", 43},
+        {"OVER|27|W|One player has resigned.|", 35},
+        {"OVER|27|L|One player has resigned.|", 35},
+        {"OVER|32|D|Both players declared a draw.|", 40},
+        {"OVER|20|D|The grid is full.|", 28},
+        {"OVER|34|W|One player has run out of time.|", 42},
+        {"OVER|34|L|One player has run out of time.|", 42},
 };
 
-// global variable for the player names that are currently in the game
-// this is not thread-safe because it is modified by multiple threads, so use a mutex lock
-static size_t number_of_players = 0;
-static char **player_names = NULL;
-
-// create a mutex lock for the set of related shared resources, in this case {number_of_players, player_names}
-static pthread_mutex_t players_mutex = PTHREAD_MUTEX_INITIALIZER;
-
 // driver
 int main(int argc, char **argv) {
     // set stdout and stderr buffer to NULL
@@ -70,27 +286,146 @@ int main(int argc, char **argv) {
     setbuf(stderr, NULL);
 
     // check if the arguments are correct
-    check_arguments(argc);
+    server_config config;
+    parse_arguments(argc, argv, &config);
+    set_message_timeout(config.message_timeout);
+
+    // fill in the MOVD frames and set up the set of player names and the pools of objects before
+    // any shard uses them
+    frames_init();
+    names_init();
+    pool_init(POOL_CLIENT, "client", sizeof(client));
+    pool_init(POOL_GAME, "game", sizeof(game));
+    pool_init(POOL_SHORT_OUTPUT, "short_output", get_output_footprint(SHORT_OUTPUT_CAPACITY));
+    pool_init(POOL_LONG_OUTPUT, "long_output", get_output_footprint(BEGN_CAPACITY));
+    pool_init(POOL_HANDOFF, "handoff", sizeof(handoff));
+
+    // start the thread that writes the log, so the shards never wait for stdout
+    logger_start(config.log_policy);
 
     // set up the signal handlers
     setup_signal_handlers();
 
+    // start the flight recorder, which keeps the last events of every thread and writes them when the server crashes
+    recorder_start(config.recording_path);
+
+    // start the thread that answers requests for the metrics, which only reads snapshots of them
+    if (config.admin_port != NULL) {
+        metrics_serve(config.admin_port);
+    }
+
     // simulate the server
-    simulate_server(argv[1]);
+    simulate_server(&config);
 
     // exit the program successfully
     return EXIT_SUCCESS;
 }
 
-// function that checks if the arguments are correct
-void check_arguments(int argc) {
-    // check if the number of arguments is correct
-    if (argc != 2) {
-        if (write(STDERR_FILENO, "Usage: ./ttts <port>\n", 21) != 21) {
-            perror("write");
+// function that checks if the arguments are correct and fills in the server config
+// usage: ./ttts [-a admin port] [-b epoll|io_uring] [-c clock[+increment]] [-i idle timeout] [-l block|drop]
+//               [-r recording] [-s shards] [-t timeout] [-w handshake timeout] <port>
+void parse_arguments(int argc, char **argv, server_config *config) {
+    // set the default options
+    config->port = NULL;
+    config->admin_port = NULL;
+    config->recording_path = NULL;
+    config->backend = BACKEND_EPOLL;
+    config->number_of_shards = get_number_of_cores();
+    config->message_timeout = DEFAULT_MESSAGE_TIMEOUT;
+    config->handshake_timeout = DEFAULT_HANDSHAKE_TIMEOUT;
+    config->idle_timeout = DEFAULT_IDLE_TIMEOUT;
+    config->clock = 0;
+    config->increment = 0;
+    config->log_policy = LOG_BLOCK;
+
+    // parse the options
+    int option;
+    size_t number_of_shards = 0;
+    size_t message_timeout = 0;
+    size_t timeout = 0;
+    while ((option = getopt(argc, argv, "a:b:c:i:l:r:s:t:w:")) != -1) {
+        switch (option) {
+            case 'a':
+                config->admin_port = optarg;
+                break;
+            case 'b':
+                if (strcmp(optarg, "epoll") == 0) {
+                    config->backend = BACKEND_EPOLL;
+                } else if (strcmp(optarg, "io_uring") == 0) {
+                    config->backend = BACKEND_IO_URING;
+                } else {
+                    print_usage();
+                }
+                break;
+            case 'l':
+                if (strcmp(optarg, "block") == 0) {
+                    config->log_policy = LOG_BLOCK;
+                } else if (strcmp(optarg, "drop") == 0) {
+                    config->log_policy = LOG_DROP;
+                } else {
+                    print_usage();
+                }
+                break;
+            case 'r':
+                config->recording_path = optarg;
+                break;
+            case 's':
+                if (to_unsigned_long(optarg, &number_of_shards) == -1 ||
+                    number_of_shards == 0 || number_of_shards > MAX_SHARDS) {
+                    print_usage();
+                }
+                config->number_of_shards = number_of_shards;
+                break;
+            case 't':
+                if (to_unsigned_long(optarg, &message_timeout) == -1 ||
+                    message_timeout == 0 || message_timeout > MAX_MESSAGE_TIMEOUT) {
+                    print_usage();
+                }
+                config->message_timeout = message_timeout;
+                break;
+            case 'c': {
+                // the clock of each player and the increment after each move, in milliseconds, such as 180000+2000
+                const char *increment = strchr(optarg, '+');
+                if (to_unsigned_long(optarg, &config->clock) == -1 || config->clock == 0 ||
+                    config->clock > MAX_IDLE_TIMEOUT ||
+                    (increment != NULL && (to_unsigned_long(increment + 1, &config->increment) == -1 ||
+                                           config->increment > MAX_IDLE_TIMEOUT))) {
+                    print_usage();
+                }
+                break;
+            }
+            case 'i':
+            case 'w':
+                if (to_unsigned_long(optarg, &timeout) == -1 || timeout == 0 || timeout > MAX_IDLE_TIMEOUT) {
+                    print_usage();
+                }
+                if (option == 'i') {
+                    config->idle_timeout = timeout;
+                } else {
+                    config->handshake_timeout = timeout;
+                }
+                break;
+            default:
+                print_usage();
+                break;
         }
-        exit(EXIT_FAILURE);
     }
+
+    // check if the number of arguments is correct
+    if (optind != argc - 1) {
+        print_usage();
+    }
+    config->port = argv[optind];
+}
+
+// function that prints the usage of the server and exits
+void print_usage() {
+    const char *usage = "Usage: ./ttts [-a admin port] [-b epoll|io_uring] [-c clock[+increment]] [-i idle timeout] "
+                        "[-l block|drop] [-r recording] [-s shards] [-t timeout] [-w handshake timeout] <port>\n";
+    if (write(STDERR_FILENO, usage, strlen(usage)) != strlen(usage)) {
+        perror("write");
+    }
+    exit(EXIT_FAILURE);
 }
 
 // function that sets up the signal handlers
@@ -155,926 +490,1491 @@ void release_mutex_lock(pthread_mutex_t *mutex) {
     }
 }
 
-// function that adds a player's name to the player list of names
-void add_player_name(const char *player_name) {
-    // obtain the mutex lock
-    obtain_mutex_lock(&players_mutex);
 
-    // if player_name is NULL, do nothing
-    if (player_name == NULL || strlen(player_name) == 0) {
-        release_mutex_lock(&players_mutex);
-        return;
+// function that gets a server socket that is ready to begin the game
+int get_server(const char *port, int is_shared) {
+    // create a server socket
+    int server_socket = create_server_socket(port, is_shared);
+    if (server_socket == -1) {
+        perror("create_server_socket");
+        exit(EXIT_FAILURE);
     }
+    return server_socket;
+}
 
-    // if player_names is NULL, allocate memory for it of 1 element
-    if (player_names == NULL) {
-        player_names = malloc(sizeof(char *));
-        if (player_names == NULL) {
-            perror("malloc");
-            exit(EXIT_FAILURE);
-        }
-        player_names[0] = strdup(player_name);
-        number_of_players++;
-        release_mutex_lock(&players_mutex);
-        return;
+
+// function that gets the number of cores that are online, which is the default number of shards
+size_t get_number_of_cores() {
+    long number_of_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (number_of_cores < 1) {
+        return 1;
     }
+    if (number_of_cores > MAX_SHARDS) {
+        return MAX_SHARDS;
+    }
+    return number_of_cores;
+}
 
-    // if there is a NULL pointer in the array, replace it with the player name to save space
-    for (size_t i = 0; i < number_of_players; i++) {
-        if (player_names[i] == NULL) {
-            player_names[i] = strdup(player_name);
-            release_mutex_lock(&players_mutex);
-            return;
+// function that raises the soft limit on open file descriptors to the hard limit
+void raise_file_limit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == -1) {
+        perror("getrlimit");
+        return;
+    }
+    if (limit.rlim_cur != limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &limit) == -1) {
+            perror("setrlimit");
         }
     }
+}
 
-    number_of_players++;
-    char **temp = realloc(player_names, sizeof(char *) * number_of_players);
-    if (temp == NULL) {
-        perror("realloc");
+// function that simulates the server
+// every shard runs its own event loop on its own SO_REUSEPORT server socket, so the kernel spreads new connections
+// across the shards and accepting connections scales with the cores
+// clients are paired by the first shard and every new game is handed to the shard with the fewest games,
+// so the number of threads stays fixed no matter how many games are live
+// the player names are shared by every shard, so a name is still unique across the whole server
+void simulate_server(const server_config *config) {
+    // idle clients that have not finished their handshake hold a socket each, so allow as many sockets as possible
+    raise_file_limit();
+
+    // set up every shard before any of them runs, so a port that cannot be bound fails right away
+    server *servers = malloc(sizeof(server) * config->number_of_shards);
+    if (servers == NULL) {
+        perror("malloc");
         exit(EXIT_FAILURE);
-    } else {
-        player_names = temp;
     }
-    player_names[number_of_players - 1] = strdup(player_name);
+    memset(servers, 0, sizeof(server) * config->number_of_shards);
+    for (size_t i = 0; i < config->number_of_shards; i++) {
+        servers[i].shards = servers;
+        servers[i].number_of_shards = config->number_of_shards;
+        setup_shard(&servers[i], config);
+    }
 
-    // release the mutex lock
-    release_mutex_lock(&players_mutex);
+    // every shard except the first one runs on a thread of its own, and the first one runs on this thread
+    for (size_t i = 1; i < config->number_of_shards; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, &run_shard, &servers[i]) != 0) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+        if (pthread_detach(thread) != 0) {
+            perror("pthread_detach");
+            exit(EXIT_FAILURE);
+        }
+    }
+    run_shard(&servers[0]);
 }
 
-// function that removes a player's name from the player list of names
-void remove_player_name(const char *player_name) {
-    // obtain the mutex lock
-    obtain_mutex_lock(&players_mutex);
+// function that sets up the server socket and the backend of a shard
+void setup_shard(server *srv, const server_config *config) {
+    srv->backend = config->backend;
+    srv->handshake_timeout = config->handshake_timeout;
+    srv->idle_timeout = config->idle_timeout;
+    srv->clock = config->clock;
+    srv->increment = config->increment;
+    timer_wheel_init(&srv->timers, get_time_in_ms());
+
+    // other shards hand clients to this shard through a list that is guarded by a mutex, and wake it with an eventfd
+    srv->handoff_event = eventfd(0, EFD_NONBLOCK);
+    if (srv->handoff_event == -1 || pthread_mutex_init(&srv->handoff_mutex, NULL) != 0) {
+        perror("setup_shard");
+        exit(EXIT_FAILURE);
+    }
 
-    // if player_name is NULL, do nothing
-    if (player_name == NULL || strlen(player_name) == 0) {
-        release_mutex_lock(&players_mutex);
-        return;
+    // keep a spare file descriptor so a connection can still be accepted and closed when there are none left
+    srv->reserve_socket = open("/dev/null", O_RDONLY);
+    if (srv->reserve_socket == -1) {
+        perror("open");
+        exit(EXIT_FAILURE);
     }
 
-    // if the player name is in the array, replace it with a NULL pointer to save space
-    for (size_t i = 0; i < number_of_players; i++) {
-        if (player_names[i] != NULL && strcmp(player_names[i], player_name) == 0) {
-            player_names[i] = Free(player_names[i]);
-            break;
-        }
+    // get a server socket, which has to share its port when there is more than one shard
+    srv->server_socket = get_server(config->port, config->number_of_shards > 1);
+    if (set_socket_nonblocking(srv->server_socket) == -1) {
+        perror("set_socket_nonblocking");
+        exit(EXIT_FAILURE);
     }
 
-    // release the mutex lock
-    release_mutex_lock(&players_mutex);
+    // use io_uring if it was selected and the kernel supports it, otherwise fall back to epoll
+    if (srv->backend == BACKEND_IO_URING && uring_create(&srv->ring) == -1) {
+        perror("uring_create");
+        const char *warning = "io_uring is not supported by this kernel, falling back to epoll\n";
+        if (write(STDERR_FILENO, warning, strlen(warning)) != strlen(warning)) {
+            perror("write");
+        }
+        srv->backend = BACKEND_EPOLL;
+    }
 }
 
-// function that checks if a player's name is in the player list of names
-size_t is_player_name_taken(const char *player_name) {
-    // obtain the mutex lock
-    obtain_mutex_lock(&players_mutex);
+// function that runs the event loop of a shard
+void* run_shard(void *arg) {
+    server *srv = arg;
+    if (srv->backend == BACKEND_IO_URING) {
+        run_io_uring_loop(srv);
+    } else {
+        run_epoll_loop(srv);
+    }
+    return NULL;
+}
 
-    // if player_name is NULL, return 1
-    if (player_name == NULL || strlen(player_name) == 0) {
-        release_mutex_lock(&players_mutex);
-        return 1;
+// function that runs a level-triggered epoll event loop
+// every ready client gets one receive per turn, and a client that still has bytes waits for the turn of every other
+// ready client, so a client that floods the server cannot starve its opponent
+void run_epoll_loop(server *srv) {
+    // register the server socket with the event loop
+    if (readiness_set_init(&srv->readiness) == -1) {
+        perror("readiness_set_init");
+        exit(EXIT_FAILURE);
+    }
+    if (watch_socket(srv->readiness.event_loop, srv->server_socket, NULL) == -1 ||
+        watch_socket(srv->readiness.event_loop, srv->handoff_event, srv) == -1) {
+        perror("watch_socket");
+        exit(EXIT_FAILURE);
     }
 
-    // if the player name is in the array, return 1
-    for (size_t i = 0; i < number_of_players; i++) {
-        if (player_names[i] != NULL && strcmp(player_names[i], player_name) == 0) {
-            release_mutex_lock(&players_mutex);
-            return 1;
+    while (1) {
+        // wait for every ready socket until the earliest deadline of a partial message
+        int number_of_ready = wait_for_ready(&srv->readiness, get_event_timeout(srv));
+        if (number_of_ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("wait_for_ready");
+            exit(EXIT_FAILURE);
         }
-    }
 
-    // release the mutex lock
-    release_mutex_lock(&players_mutex);
+        // the server socket is registered without a client and the handoff eventfd with the server,
+        // every other ready socket belongs to a client
+        // a blocked client is flushed again once its socket is writable, and a client that is being handed off is
+        // only written to
+        for (int i = 0; i < number_of_ready; i++) {
+            client *cl = srv->readiness.ready[i].data.ptr;
+            uint32_t events = srv->readiness.ready[i].events;
+            if (cl == NULL) {
+                accept_clients(srv);
+            } else if (srv->readiness.ready[i].data.ptr == srv) {
+                receive_handoffs(srv);
+            } else if (cl->state != CLIENT_CLOSED) {
+                if ((events & EPOLLOUT) != 0 && cl->is_blocked == 1) {
+                    add_flush(srv, cl);
+                }
+                if ((events & ~EPOLLOUT) != 0 && cl->state != CLIENT_MOVING) {
+                    read_client(srv, cl);
+                }
+            }
+        }
 
-    // otherwise, return 0
-    return 0;
+        // reject clients that did not complete their message in time, send the messages of every client,
+        // hand clients to other shards and free the closed clients
+        expire_deadlines(srv);
+        flush_clients(srv);
+        send_handoffs(srv);
+        free_closed_clients(srv);
+    }
 }
 
-// function that gets the client socket that is waiting to begin the game
-int get_client(int server_socket, char **client_host, char **client_port, char **player_name, char **msg_buffer) {
+// function that runs an io_uring event loop
+// connections are accepted by one multishot accept, every client is read by one multishot receive into the
+// provided buffers, and the queued messages of a client are sent by one sendmsg
+// so a move costs one io_uring_enter() for the whole batch instead of several system calls per client
+void run_io_uring_loop(server *srv) {
+    if (uring_accept_multishot(&srv->ring, srv->server_socket, REQUEST_ACCEPT) == -1 ||
+        uring_poll_multishot(&srv->ring, srv->handoff_event, REQUEST_HANDOFF) == -1) {
+        perror("run_io_uring_loop");
+        exit(EXIT_FAILURE);
+    }
+
     while (1) {
-        // accept an incoming connection
-        int client_socket = accept_incoming_connection(server_socket, client_host, client_port);
-        if (client_socket == -1) {
-            perror("accept_incoming_connection");
-            continue;
+        // queue the messages of every client, then submit and wait until the earliest deadline of a partial message
+        flush_clients(srv);
+        if (uring_wait(&srv->ring, get_event_timeout(srv)) == -1) {
+            perror("uring_wait");
+            exit(EXIT_FAILURE);
         }
 
-        // log the client's host and port using log_message()
-        log_message("Connected", *client_host, *client_port, NULL);
-
-        // declare a variable to determine if the message was sent or received
-        size_t is_sent = 0;
+        // handle every completion, consuming it first so that the completion queue does not fill up
+        struct io_uring_cqe *next;
+        while ((next = uring_get_completion(&srv->ring)) != NULL) {
+            struct io_uring_cqe completion = *next;
+            uring_complete(&srv->ring);
+            handle_completion(srv, &completion);
+        }
 
-        // declare a variable to determine if the server should continue accepting connections
-        size_t continue_accepting;
-
-        // get message from the client about player name
-        *msg_buffer = NULL;
-        while (1) {
-            // get the message from the client
-            char *msg = NULL;
-            if (get_message(client_socket, msg_buffer, &msg) == -1) {
-                // send INVL message to the client which is PROTOCOL[3]
-                if (send_message(client_socket, PROTOCOL[3], strlen(PROTOCOL[3])) == -1) {
-                    perror("send_message");
-                } else {
-                    is_sent = 1;
-                    log_message(PROTOCOL[3], *client_host, *client_port, &is_sent);
-                }
-                close(client_socket);
-                *client_host = Free(*client_host);
-                *client_port = Free(*client_port);
-                *msg_buffer = Free(*msg_buffer);
-                msg = Free(msg);
-                perror("get_message");
-                continue_accepting = 1;
-                break;
-            }
+        // reject clients that did not complete their message in time and hand clients to other shards
+        expire_deadlines(srv);
+        send_handoffs(srv);
+    }
+}
 
-            // log the message using log_message()
-            is_sent = 0;
-            log_message(msg, *client_host, *client_port, &is_sent);
-
-            // parse the message to get the player name
-            *player_name = NULL;
-            if (parse_play(msg, player_name) == -1) {
-                // send a protocol error message to the client
-                if (send_message(client_socket, PROTOCOL[3], strlen(PROTOCOL[3])) == -1) {
-                    close(client_socket);
-                    *client_host = Free(*client_host);
-                    *client_port = Free(*client_port);
-                    *msg_buffer = Free(*msg_buffer);
-                    msg = Free(msg);
-                    perror("send_message");
-                    continue_accepting = 1;
-                    break;
-                }
+// function that returns how long the event loop may wait (in milliseconds) before the timer wheel has to be advanced
+// returns -1 if there are no deadlines
+int get_event_timeout(server *srv) {
+    long timeout = timer_wheel_get_timeout(&srv->timers, get_time_in_ms());
+    if (timeout > INT_MAX) {
+        return INT_MAX;
+    }
+    return (int) timeout;
+}
 
-                // log the message using log_message()
-                is_sent = 1;
-                log_message(PROTOCOL[3], *client_host, *client_port, &is_sent);
-                msg = Free(msg);
+// function that accepts the pending connections on the server socket, up to one set of ready sockets per turn
+// the server socket stays ready while connections are pending, so the rest are accepted on its next turn
+void accept_clients(server *srv) {
+    for (size_t i = 0; i < MAX_READY_SOCKETS; i++) {
+        // accept an incoming connection until there are none left
+        char client_host[NUMERIC_HOST_LENGTH];
+        char client_port[NUMERIC_PORT_LENGTH];
+        errno = 0;
+        int client_socket = accept_incoming_connection(srv->server_socket, client_host, client_port);
+        if (client_socket == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            perror("accept_incoming_connection");
+            if (errno == 0 || errno == EINTR || errno == ECONNABORTED) {
                 continue;
             }
-
-            // check if the player name is taken
-            if (is_player_name_taken(*player_name)) {
-                // send a INVL message to the client
-                if (send_message(client_socket, PROTOCOL[4], strlen(PROTOCOL[4])) == -1) {
-                    close(client_socket);
-                    *client_host = Free(*client_host);
-                    *client_port = Free(*client_port);
-                    *msg_buffer = Free(*msg_buffer);
-                    msg = Free(msg);
-                    *player_name = Free(*player_name);
-                    perror("send_message");
-                    continue_accepting = 1;
-                    break;
-                }
-
-                // log the message using log_message()
-                is_sent = 1;
-                log_message(PROTOCOL[4], *client_host, *client_port, &is_sent);
-                msg = Free(msg);
-                *player_name = Free(*player_name);
+            if ((errno == EMFILE || errno == ENFILE) && shed_connection(srv) == 0) {
                 continue;
             }
-
-            // now we are done getting a valid player name so break out of the loop
-            continue_accepting = 0;
-            msg = Free(msg);
-            break;
+            return;
         }
 
-        // if we should continue accepting connections, then continue
-        if (continue_accepting == 1) {
+        // create the client and register its socket with the event loop
+        if (set_socket_nonblocking(client_socket) == -1) {
+            perror("set_socket_nonblocking");
+            close(client_socket);
             continue;
         }
-
-        // send a WAIT message to the client
-        if (send_message(client_socket, PROTOCOL[0], strlen(PROTOCOL[0])) == -1) {
-            close(client_socket);
-            *client_host = Free(*client_host);
-            *client_port = Free(*client_port);
-            *player_name = Free(*player_name);
-            *msg_buffer = Free(*msg_buffer);
-            perror("send_message");
+        client *cl = create_client(srv, client_socket, client_host, client_port);
+        if (cl == NULL) {
             continue;
         }
 
-        // log the message using log_message()
-        is_sent = 1;
-        log_message(PROTOCOL[0], *client_host, *client_port, &is_sent);
-
-        // add the player name to the list of player names
-        add_player_name(*player_name);
+        // the client may have sent data before its socket was registered
+        read_client(srv, cl);
+    }
+}
 
-        // return the client socket
-        return client_socket;
+// function that accepts a connection with the spare file descriptor and closes it right away
+// otherwise the connection would stay in the backlog and the server socket would never be ready again
+// returns -1 on error and 0 on success
+int shed_connection(server *srv) {
+    if (srv->reserve_socket == -1) {
+        return -1;
+    }
+    close(srv->reserve_socket);
+    int client_socket = accept(srv->server_socket, NULL, NULL);
+    if (client_socket != -1) {
+        close(client_socket);
     }
+    srv->reserve_socket = open("/dev/null", O_RDONLY);
+    return client_socket == -1 ? -1 : 0;
 }
 
-// function that gets a server socket that is ready to begin the game
-int get_server(const char *port) {
-    // create a server socket
-    int server_socket = create_server_socket(port);
-    if (server_socket == -1) {
-        perror("create_server_socket");
+// function that creates a client for the accepted socket and starts receiving from it
+// returns NULL on error, in which case the socket is closed
+client* create_client(server *srv, int client_socket, const char *client_host, const char *client_port) {
+    client *cl = pool_alloc(POOL_CLIENT);
+    if (cl == NULL) {
+        perror("pool_alloc");
         exit(EXIT_FAILURE);
     }
-    return server_socket;
+    memset(cl, 0, sizeof(client));
+
+    // the id of a connection is the index of its shard in the top bits and the number of the connection in the shard
+    srv->number_of_connections++;
+    cl->id = (uint64_t) (srv - srv->shards) << 48 | srv->number_of_connections;
+    cl->socket = client_socket;
+    strcpy(cl->host, client_host);
+    strcpy(cl->port, client_port);
+    cl->state = CLIENT_HANDSHAKE;
+    queue_init(&cl->input);
+
+    // the client has to send its PLAY message before the handshake timeout
+    timer_init(&cl->message_timer, TIMER_MESSAGE, cl);
+    timer_init(&cl->handshake_timer, TIMER_HANDSHAKE, cl);
+    timer_arm(&srv->timers, &cl->handshake_timer, get_time_in_ms() + srv->handshake_timeout);
+
+    // register the socket with the event loop or start a multishot receive
+    ssize_t result = 0;
+    if (srv->backend == BACKEND_IO_URING) {
+        result = uring_receive_multishot(&srv->ring, client_socket, (uint64_t) (uintptr_t) cl | REQUEST_RECEIVE);
+        cl->is_receiving = 1;
+    } else {
+        result = watch_socket(srv->readiness.event_loop, client_socket, cl);
+    }
+    if (result == -1) {
+        perror("create_client");
+        close(client_socket);
+        timer_cancel(&srv->timers, &cl->handshake_timer);
+        pool_free(POOL_CLIENT, cl);
+        return NULL;
+    }
+
+    // log the client's host and port using log_message()
+    log_message("Connected", cl->host, cl->port, NULL);
+    metrics_add(METRIC_CONNECTIONS_ACCEPTED, 1);
+    metrics_add(METRIC_HANDSHAKES_IN_FLIGHT, 1);
+    TRACE_ACCEPT(cl->id, client_socket);
+    recorder_record(FLIGHT_ACCEPT, cl->id, 0, (uint32_t) client_socket);
+    return cl;
 }
 
-// function that simulates the server
-void simulate_server(const char *port) {
-    // get a server socket
-    int server_socket = get_server(port);
+// function that receives what fits in the client's queue from its non-blocking socket and handles its messages
+// a client gets one receive per turn, and its socket stays ready if it has sent more, so the rest is received on its
+// next turn, after every other ready client has had its turn
+void read_client(server *srv, client *cl) {
+    size_t is_closed = 0;
+    size_t length = queue_receive(&cl->input, cl->socket, &is_closed);
+    handle_received(srv, cl, length, is_closed);
+}
 
-    while (1) {
-        // get a client socket
-        char *client1_host = NULL;
-        char *client1_port = NULL;
-        char *player1_name = NULL;
-        char *msg_buffer1 = NULL;
-        int client1_socket = get_client(server_socket, &client1_host, &client1_port, &player1_name, &msg_buffer1);
-
-        // get another client socket
-        char *client2_host = NULL;
-        char *client2_port = NULL;
-        char *player2_name = NULL;
-        char *msg_buffer2 = NULL;
-        int client2_socket = get_client(server_socket, &client2_host, &client2_port, &player2_name, &msg_buffer2);
-
-        // create a game struct
-        game *arg = malloc(sizeof(game));
-        if (arg == NULL) {
-            perror("malloc");
-            exit(EXIT_FAILURE);
+// function that handles the given number of bytes that were added to the client's queue
+// is_closed is 1 if the peer closed the connection or the connection failed
+void handle_received(server *srv, client *cl, size_t length, size_t is_closed) {
+    metrics_add(METRIC_BYTES_RECEIVED, length);
+    if (length > 0) {
+        cl->arrived_at = get_time_in_ns();
+    }
+
+    // a waiting client only keeps its messages until the game begins, but a dropped connection frees its name
+    // and a client that fills its queue while waiting is flooding the server
+    if (cl->state == CLIENT_WAITING) {
+        if (is_closed == 1) {
+            close_client(srv, cl);
+        } else if (queue_is_full(&cl->input)) {
+            reject_client(srv, cl, "Flooded while waiting");
         }
-        arg->client1_socket = client1_socket;
-        arg->client1_host = client1_host;
-        arg->client1_port = client1_port;
-        arg->player1_name = player1_name;
-        arg->msg_buffer1 = msg_buffer1;
-        arg->client2_socket = client2_socket;
-        arg->client2_host = client2_host;
-        arg->client2_port = client2_port;
-        arg->player2_name = player2_name;
-        arg->msg_buffer2 = msg_buffer2;
-
-        // create a game thread
-        pthread_t game_thread;
-        if (pthread_create(&game_thread, NULL, &handle_game, arg) != 0) {
-            perror("pthread_create");
-            exit(EXIT_FAILURE);
+        return;
+    }
+
+    // process every complete message that has arrived before dealing with a dropped connection
+    // a client that sent PLAY may now be handed off, and its next shard finds out by itself if the connection is gone
+    process_client(srv, cl);
+    if (cl->state == CLIENT_CLOSED || cl->state == CLIENT_MOVING) {
+        return;
+    }
+    if (is_closed == 1) {
+        if (cl->state == CLIENT_WAITING) {
+            close_client(srv, cl);
+        } else {
+            reject_client(srv, cl, "Connection dropped");
         }
+        return;
+    }
 
-        // detach the game thread
-        if (pthread_detach(game_thread) != 0) {
-            perror("pthread_detach");
-            exit(EXIT_FAILURE);
+    // a full queue that does not start with a complete message can never hold one, so the message is malformed
+    if (queue_is_full(&cl->input)) {
+        reject_client(srv, cl, "Malformed message");
+        return;
+    }
+
+    // restart the deadline for a partial message whenever new bytes arrive
+    update_deadline(srv, cl, length > 0);
+}
+
+// function that processes every complete message in the client's queue according to the state of the client
+void process_client(server *srv, client *cl) {
+    while (cl->state == CLIENT_HANDSHAKE || cl->state == CLIENT_PLAYING) {
+        // stop once the queue does not start with a complete message
+        frame view;
+        if (parse_frame(queue_peek(&cl->input), &view) == 0) {
+            break;
+        }
+
+        // take the message out of the queue in place, it stays valid until the queue is used again
+        char *msg = queue_take(&cl->input, view.length);
+        TRACE_PARSE(cl->id, view.code, view.length);
+        recorder_record(FLIGHT_FRAME_IN, cl->id, view.code, (uint32_t) view.length);
+
+        // log the message using log_message()
+        size_t is_sent = 0;
+        log_message(msg, cl->host, cl->port, &is_sent);
+        metrics_add(METRIC_MESSAGES_RECEIVED + view.code, 1);
+
+        // decode the fields of the message once, then handle it as a PLAY message or as a message of the game
+        // the responses to the message are timed from the receive that completed it
+        message decoded;
+        decode_message(msg, &view, &decoded);
+        srv->cause_arrived_at = cl->arrived_at;
+        srv->cause_code = view.code;
+        if (cl->state == CLIENT_HANDSHAKE) {
+            handle_handshake(srv, cl, &decoded);
+        } else if (handle_game(srv, cl->game, cl->index, &decoded) == -1) {
+            free_game(srv, cl->game);
+        } else if (cl->state == CLIENT_PLAYING) {
+            // every message of the game restarts its idle timeout
+            timer_arm(&srv->timers, &cl->game->idle_timer, get_time_in_ms() + srv->idle_timeout);
         }
+        srv->cause_arrived_at = 0;
     }
 }
 
-// function that handles a game thread
-void* handle_game(void *arg) {
-    // extract the variables from the game struct into local variables on the stack
-    game *args = (game*) arg;
-    int client1_socket = args->client1_socket;
-    char *client1_host = args->client1_host;
-    char *client1_port = args->client1_port;
-    char *player1_name = args->player1_name;
-    char **msg_buffer1 = &(args->msg_buffer1);
-    int client2_socket = args->client2_socket;
-    char *client2_host = args->client2_host;
-    char *client2_port = args->client2_port;
-    char *player2_name = args->player2_name;
-    char **msg_buffer2 = &(args->msg_buffer2);
+// function that rejects a client whose message could not be received, and logs the reason it was rejected
+// sends INVL to the client and closes its connection, which also ends its game
+void reject_client(server *srv, client *cl, const char *reason) {
+    recorder_record(FLIGHT_ERROR, cl->id, FLIGHT_ERROR_REJECT, 0);
+    log_message(reason, cl->host, cl->port, NULL);
 
-    // initialize the game board on the stack
-    char board[10] = ".........";
+    // send INVL message to the client which is PROTOCOL[3]
+    send_and_log(srv, cl, &PROTOCOL[3]);
+    metrics_add(METRIC_CLIENTS_REJECTED, 1);
 
-    // initialize variable to keep track of whose turn it is (0 for client1 and 1 for client2)
-    size_t turn = 0;
+    // end the game of the client or close the client by itself
+    if (cl->state == CLIENT_PLAYING) {
+        free_game(srv, cl->game);
+    } else {
+        close_client(srv, cl);
+    }
+}
 
-    // initialize variable to keep track of which client needs to respond to draw suggestion
-    size_t draw_response_index = 0;
-    size_t is_draw_suggested = 0;
+// function that closes the client and frees its name
+// with epoll, the socket is closed and the client is freed after the current batch of events has been flushed,
+// since the client may still have queued messages and later events may still point to it
+void close_client(server *srv, client *cl) {
+    if (cl->state == CLIENT_CLOSED) {
+        return;
+    }
 
-    // initialize variable that keeps track of each player's role
-    // client1 is X and client2 is O
-    char role[3] = "XO";
+    // make sure to remove the player name from the shared set of player names
+    remove_player_name(cl->player_name);
+    if (cl->state == CLIENT_HANDSHAKE) {
+        metrics_add(METRIC_HANDSHAKES_IN_FLIGHT, -1);
+    }
 
-    // initialize a sockets array that contains both client sockets in order
-    int sockets[2];
-    sockets[0] = client1_socket;
-    sockets[1] = client2_socket;
+    // stop tracking the client
+    timer_cancel(&srv->timers, &cl->message_timer);
+    timer_cancel(&srv->timers, &cl->handshake_timer);
+    if (srv->waiting_client == cl) {
+        srv->waiting_client = NULL;
+    }
 
-    // first generate BEGN message for each client
-    char *begn_msg1 = NULL;
-    char *begn_msg2 = NULL;
-    if (generate_BEGN(role[0], player2_name, &begn_msg1) == -1) {
-        perror("generate_BEGN");
-        free_game(args);
-        pthread_exit(NULL);
+    set_client_state(cl, CLIENT_CLOSED);
+
+    // with io_uring, the socket stays open until the queued messages have been sent and the receive has finished
+    if (srv->backend == BACKEND_IO_URING) {
+        add_flush(srv, cl);
+        return;
     }
-    if (generate_BEGN(role[1], player1_name, &begn_msg2) == -1) {
-        perror("generate_BEGN");
-        free_game(args);
-        pthread_exit(NULL);
+
+    cl->next_closed = srv->closed_clients;
+    srv->closed_clients = cl;
+}
+
+// function that closes the socket of every client that has been closed and frees the client
+void free_closed_clients(server *srv) {
+    while (srv->closed_clients != NULL) {
+        client *cl = srv->closed_clients;
+        srv->closed_clients = cl->next_closed;
+
+        // close the socket, which also removes it from the event loop
+        if (close(cl->socket) == -1) {
+            perror("close");
+        }
+        free_client(cl);
     }
+}
 
-    // initialize variable for logging
-    size_t is_sent = 1;
+// function that frees the client struct, its strings and the messages that could not be sent anymore
+void free_client(client *cl) {
+    free_outputs(cl, SIZE_MAX);
+    cl->player_name = free_player_name(cl->player_name);
+    leave_game(cl);
+    pool_free(POOL_CLIENT, cl);
+}
 
-    // send BEGN message to each client
-    if (send_message(sockets[0], begn_msg1, strlen(begn_msg1)) == -1) {
-        perror("send_message");
-        free_game(args);
-        pthread_exit(NULL);
+// function that finishes a closed client of the io_uring backend once nothing refers to it anymore
+// shutting the socket down ends its multishot receive, and the client is freed once that receive has completed
+void release_client(server *srv, client *cl) {
+    // wait until the client is closed, its messages have been sent and it has left the list of clients to flush
+    if (cl->state != CLIENT_CLOSED || cl->first_output != NULL || cl->sends_in_flight > 0 || cl->is_flushing == 1) {
+        return;
+    }
+
+    // wait until the multishot receive has completed
+    if (cl->is_receiving == 1) {
+        if (cl->is_shut_down == 0 && shutdown(cl->socket, SHUT_RDWR) == -1 && errno != ENOTCONN) {
+            perror("shutdown");
+        }
+        cl->is_shut_down = 1;
+        return;
     }
-    log_message(begn_msg1, client1_host, client1_port, &is_sent);
-    if (send_message(sockets[1], begn_msg2, strlen(begn_msg2)) == -1) {
-        perror("send_message");
-        free_game(args);
-        pthread_exit(NULL);
+
+    // close the socket and free the client
+    if (close(cl->socket) == -1) {
+        perror("close");
     }
-    log_message(begn_msg2, client2_host, client2_port, &is_sent);
+    free_client(cl);
+}
 
-    // free BEGN messages
-    Free(begn_msg1);
-    Free(begn_msg2);
+// function that moves the client to the given state and records the transition with the flight recorder
+void set_client_state(client *cl, client_state state) {
+    if (cl->state != state) {
+        recorder_record(FLIGHT_STATE, cl->id, state, cl->state);
+    }
+    cl->state = state;
+}
 
-    // wait for either client to respond and process the messages
-    while (1) {
-        // if both msg buffers are NULL, then get a readable socket
-        ssize_t index = -1;
-        if (*msg_buffer1 == NULL && *msg_buffer2 == NULL) {
-            index = get_readable_socket(sockets, 2, -1);
-            if (index == -1 || index > 1) {
-                perror("get_readable_socket");
-                break;
+// function that handles a completion of the io_uring backend
+void handle_completion(server *srv, const struct io_uring_cqe *completion) {
+    request_kind kind = completion->user_data & REQUEST_KIND_MASK;
+    void *data = (void *) (uintptr_t) (completion->user_data & ~(uint64_t) REQUEST_KIND_MASK);
+
+    if (kind == REQUEST_ACCEPT) {
+        // create a client for the accepted socket
+        if (completion->res >= 0) {
+            char client_host[NUMERIC_HOST_LENGTH];
+            char client_port[NUMERIC_PORT_LENGTH];
+            if (get_peer_name(completion->res, client_host, client_port) == -1) {
+                perror("get_peer_name");
+                close(completion->res);
+            } else {
+                create_client(srv, completion->res, client_host, client_port);
             }
-        } else if (*msg_buffer1 != NULL) {
-            index = 0;
         } else {
-            index = 1;
+            errno = -completion->res;
+            perror("accept_incoming_connection");
+            if (errno == EMFILE || errno == ENFILE) {
+                shed_connection(srv);
+            }
         }
 
-        // initialize msg variable
-        char *msg = NULL;
-
-        // check which client sent the message and read the message
-        is_sent = 0;
-        if (index == 0) {
-            // read the message from client1
-            if (get_message(sockets[0], msg_buffer1, &msg) == -1) {
-                // send INVL message to the client which is PROTOCOL[3]
-                if (send_message(sockets[0], PROTOCOL[3], strlen(PROTOCOL[3])) == -1) {
-                    perror("send_message");
-                } else {
-                    is_sent = 1;
-                    log_message(PROTOCOL[3], client1_host, client1_port, &is_sent);
-                }
-                perror("get_message");
-                break;
-            }
-            log_message(msg, client1_host, client1_port, &is_sent);
+        // the multishot accept has to be queued again once the kernel stops it
+        if ((completion->flags & IORING_CQE_F_MORE) == 0 &&
+            uring_accept_multishot(&srv->ring, srv->server_socket, REQUEST_ACCEPT) == -1) {
+            perror("uring_accept_multishot");
+            exit(EXIT_FAILURE);
+        }
+    } else if (kind == REQUEST_RECEIVE) {
+        receive_completion(srv, data, completion);
+    } else if (kind == REQUEST_SEND) {
+        send_completion(srv, data, completion->res);
+    } else if (data == NULL) {
+        // the handoff eventfd is readable, and the multishot poll has to be queued again once the kernel stops it
+        receive_handoffs(srv);
+        if ((completion->flags & IORING_CQE_F_MORE) == 0 &&
+            uring_poll_multishot(&srv->ring, srv->handoff_event, REQUEST_HANDOFF) == -1) {
+            perror("uring_poll_multishot");
+            exit(EXIT_FAILURE);
+        }
+    }
+    // otherwise this is the completion of the cancelled receive of a client that is being handed off,
+    // which the receive reports by itself
+}
+
+// function that handles a completion of the client's multishot receive
+void receive_completion(server *srv, client *cl, const struct io_uring_cqe *completion) {
+    if ((completion->flags & IORING_CQE_F_MORE) == 0) {
+        cl->is_receiving = 0;
+    }
+
+    // add the received bytes to the client's queue and give the provided buffer back to the kernel
+    size_t length = 0;
+    size_t is_closed = 0;
+    if (completion->res > 0) {
+        char *buffer = uring_get_buffer(&srv->ring, completion);
+        if (buffer == NULL ||
+            (cl->state != CLIENT_CLOSED && queue_push(&cl->input, buffer, completion->res) == -1)) {
+            is_closed = 1;
         } else {
-            // read the message from client2
-            if (get_message(sockets[1], msg_buffer2, &msg) == -1) {
-                // send INVL message to the client which is PROTOCOL[3]
-                if (send_message(sockets[1], PROTOCOL[3], strlen(PROTOCOL[3])) == -1) {
-                    perror("send_message");
-                } else {
-                    is_sent = 1;
-                    log_message(PROTOCOL[3], client2_host, client2_port, &is_sent);
-                }
-                perror("get_message");
-                break;
-            }
-            log_message(msg, client2_host, client2_port, &is_sent);
+            length = completion->res;
         }
-        is_sent = 1;
-
-        // initialize a variable that keeps track of whether any of these messages were sent
-        size_t is_valid_msg = 0;
-
-        // if a client sends a RSGN message, the server should send OVER to both clients
-        if (parse_rsgn(msg) == 0) {
-            is_valid_msg = 1;
-            // send OVER message to both clients which is in PROTOCOL[11] for winner
-            // and PROTOCOL[12] for loser
-            if (index == 0) {
-                if (send_message(sockets[0], PROTOCOL[12], strlen(PROTOCOL[12])) == -1) {
-                    perror("send_message");
-                    msg = Free(msg);
-                    break;
-                }
-                log_message(PROTOCOL[12], client1_host, client1_port, &is_sent);
-                if (send_message(sockets[1], PROTOCOL[11], strlen(PROTOCOL[11])) == -1) {
-                    perror("send_message");
-                    msg = Free(msg);
-                    break;
-                }
-                log_message(PROTOCOL[11], client2_host, client2_port, &is_sent);
-            } else {
-                if (send_message(sockets[1], PROTOCOL[12], strlen(PROTOCOL[12])) == -1) {
-                    perror("send_message");
-                    msg = Free(msg);
-                    break;
-                }
-                log_message(PROTOCOL[12], client2_host, client2_port, &is_sent);
-                if (send_message(sockets[0], PROTOCOL[11], strlen(PROTOCOL[11])) == -1) {
-                    perror("send_message");
-                    msg = Free(msg);
-                    break;
-                }
-                log_message(PROTOCOL[11], client1_host, client1_port, &is_sent);
-            }
-            msg = Free(msg);
-            break;
+        uring_recycle_buffer(&srv->ring, completion);
+    } else if (completion->res != -ENOBUFS) {
+        // the peer closed the connection or the connection failed
+        is_closed = 1;
+    }
+
+    // a closed client only waits for its requests to complete
+    if (cl->state == CLIENT_CLOSED) {
+        release_client(srv, cl);
+        return;
+    }
+
+    // a client that is being handed off keeps its bytes for its next shard, which finds out by itself if the
+    // connection is gone
+    if (cl->state == CLIENT_MOVING) {
+        return;
+    }
+
+    // queue the multishot receive again if the kernel stopped it while the connection is still open,
+    // which happens when it runs out of provided buffers
+    if (is_closed == 0 && cl->is_receiving == 0) {
+        if (uring_receive_multishot(&srv->ring, cl->socket, (uint64_t) (uintptr_t) cl | REQUEST_RECEIVE) == -1) {
+            perror("uring_receive_multishot");
+            is_closed = 1;
+        } else {
+            cl->is_receiving = 1;
         }
+    }
 
-        // process DRAW message
-        char action = '\0';
-        if (parse_draw(msg, &action) == 0) {
-            is_valid_msg = 1;
-            // if a draw has already been suggested, then check if this is the client that is expected to respond
-            if (is_draw_suggested == 1 && index == draw_response_index) {
-                if (action == 'R') {
-                    // if the client responds with reject, then send PROTOCOL[7] to the other client
-                    if (send_message(sockets[1 - index], PROTOCOL[7], strlen(PROTOCOL[7])) == -1) {
-                        perror("send_message");
-                        msg = Free(msg);
-                        break;
-                    }
-                    if (index == 0) {
-                        log_message(PROTOCOL[7], client2_host, client2_port, &is_sent);
-                    } else {
-                        log_message(PROTOCOL[7], client1_host, client1_port, &is_sent);
-                    }
-                    is_draw_suggested = 0;
-                } else if (action == 'A') {
-                    // if the client responds with accept, then send PROTOCOL[13] to both clients
-                    if (send_message(sockets[0], PROTOCOL[13], strlen(PROTOCOL[13])) == -1) {
-                        perror("send_message");
-                        msg = Free(msg);
-                        break;
-                    }
-                    log_message(PROTOCOL[13], client1_host, client1_port, &is_sent);
-                    if (send_message(sockets[1], PROTOCOL[13], strlen(PROTOCOL[13])) == -1) {
-                        perror("send_message");
-                        msg = Free(msg);
-                        break;
-                    }
-                    log_message(PROTOCOL[13], client2_host, client2_port, &is_sent);
-                    msg = Free(msg);
-                    break;
-                } else {
-                    // if the client responds with suggest or anything else, then send PROTOCOL[3] to the same client
-                    if (send_message(sockets[index], PROTOCOL[3], strlen(PROTOCOL[3])) == -1) {
-                        perror("send_message");
-                        msg = Free(msg);
-                        break;
-                    }
-                    if (index == 0) {
-                        log_message(PROTOCOL[3], client1_host, client1_port, &is_sent);
-                    } else {
-                        log_message(PROTOCOL[3], client2_host, client2_port, &is_sent);
-                    }
-                }
-            } else if (is_draw_suggested == 1) {
-                // if a draw has already been suggested, but this is not the client that is expected to respond
-                // then send PROTOCOL[3] to the same client
-                if (send_message(sockets[index], PROTOCOL[3], strlen(PROTOCOL[3])) == -1) {
-                    perror("send_message");
-                    msg = Free(msg);
-                    break;
-                }
-                if (index == 0) {
-                    log_message(PROTOCOL[3], client1_host, client1_port, &is_sent);
-                } else {
-                    log_message(PROTOCOL[3], client2_host, client2_port, &is_sent);
-                }
-            } else {
-                // if a draw has not been suggested, then check if the client wants to suggest a draw
-                // otherwise send PROTOCOL[3] to the same client
-                if (action == 'S') {
-                    // if the client wants to suggest a draw, then send PROTOCOL[5] to the other client
-                    if (send_message(sockets[1 - index], PROTOCOL[5], strlen(PROTOCOL[5])) == -1) {
-                        perror("send_message");
-                        msg = Free(msg);
-                        break;
-                    }
-                    if (index == 0) {
-                        log_message(PROTOCOL[5], client2_host, client2_port, &is_sent);
-                    } else {
-                        log_message(PROTOCOL[5], client1_host, client1_port, &is_sent);
-                    }
-                    is_draw_suggested = 1;
-                    draw_response_index = 1 - index;
-                } else {
-                    // if the client does not want to suggest a draw, then send PROTOCOL[3] to the same client
-                    if (send_message(sockets[index], PROTOCOL[3], strlen(PROTOCOL[3])) == -1) {
-                        perror("send_message");
-                        msg = Free(msg);
-                        break;
-                    }
-                    if (index == 0) {
-                        log_message(PROTOCOL[3], client1_host, client1_port, &is_sent);
-                    } else {
-                        log_message(PROTOCOL[3], client2_host, client2_port, &is_sent);
-                    }
-                }
-            }
+    handle_received(srv, cl, length, is_closed);
+    release_client(srv, cl);
+}
+
+// function that handles the completion of the sendmsg of the io_uring backend, which sent every gathered message
+void send_completion(server *srv, client *cl, int result) {
+    size_t length = 0;
+    for (size_t i = 0; i < cl->sends_in_flight; i++) {
+        length += cl->send_vectors[i].iov_len;
+    }
+    if (result > 0) {
+        metrics_add(METRIC_BYTES_SENT, result);
+    }
+    if (result >= 0 && (size_t) result == length) {
+        record_latencies(cl, cl->sends_in_flight);
+        TRACE_SEND(cl->id, cl->sends_in_flight, length);
+    }
+    free_outputs(cl, cl->sends_in_flight);
+    cl->sends_in_flight = 0;
+
+    // a failed send drops the connection, just like a failed writev() does with epoll
+    if (result < 0 || (size_t) result != length) {
+        if (result < 0) {
+            errno = -result;
         }
+        perror("send_messages");
+        recorder_record(FLIGHT_ERROR, cl->id, FLIGHT_ERROR_SEND, result < 0 ? (uint32_t) -result : 0);
+        free_outputs(cl, SIZE_MAX);
+        drop_client(srv, cl);
+    }
 
-        // process MOVE message
-        char rol = '\0';
-        size_t row = 0;
-        size_t col = 0;
-        if (parse_move(msg, &rol, &row, &col) == 0) {
-            is_valid_msg = 1;
-            // a move will only be processed if a draw has not been suggested
-            // so if a draw has been suggested, then send PROTOCOL[3] to the same client
-            if (is_draw_suggested == 1 || rol != role[index]) {
-                if (send_message(sockets[index], PROTOCOL[3], strlen(PROTOCOL[3])) == -1) {
-                    perror("send_message");
-                    msg = Free(msg);
-                    break;
-                }
-                if (index == 0) {
-                    log_message(PROTOCOL[3], client1_host, client1_port, &is_sent);
-                } else {
-                    log_message(PROTOCOL[3], client2_host, client2_port, &is_sent);
-                }
-            } else {
-                // if a draw has not been suggested, then process the move if it is the client's turn
-                // otherwise send PROTOCOL[3] to the same client
-                if (turn == index) {
-                    // if it is the client's turn, then process the move
-                    if (make_move(board, rol, row, col) == -1) {
-                        // if the move is invalid, then send PROTOCOL[2] to the same client
-                        if (send_message(sockets[index], PROTOCOL[2], strlen(PROTOCOL[2])) == -1) {
-                            perror("send_message");
-                            msg = Free(msg);
-                            break;
-                        }
-                        if (index == 0) {
-                            log_message(PROTOCOL[2], client1_host, client1_port, &is_sent);
-                        } else {
-                            log_message(PROTOCOL[2], client2_host, client2_port, &is_sent);
-                        }
-                        msg = Free(msg);
-                        continue;
-                    }
-
-                    // check if the game is over
-                    char status = '\0';
-                    char winner = '\0';
-                    if (get_game_status(board, &status, &winner) == -1) {
-                        perror("get_game_status");
-                        msg = Free(msg);
-                        break;
-                    }
-
-                    // check the status of the game
-                    if (status == 'W') {
-                        // get the winner's index
-                        size_t winner_index = 0;
-                        if (winner == role[index]) {
-                            winner_index = index;
-                        } else {
-                            winner_index = 1 - index;
-                        }
-
-                        // send PROTOCOL[9] to the winner and send PROTOCOL[10] to the loser
-                        if (send_message(sockets[winner_index], PROTOCOL[9], strlen(PROTOCOL[9])) == -1) {
-                            perror("send_message");
-                            msg = Free(msg);
-                            break;
-                        }
-                        if (winner_index == 0) {
-                            log_message(PROTOCOL[9], client1_host, client1_port, &is_sent);
-                        } else {
-                            log_message(PROTOCOL[9], client2_host, client2_port, &is_sent);
-                        }
-                        if (send_message(sockets[1 - winner_index], PROTOCOL[10], strlen(PROTOCOL[10])) == -1) {
-                            perror("send_message");
-                            msg = Free(msg);
-                            break;
-                        }
-                        if (winner_index == 0) {
-                            log_message(PROTOCOL[10], client2_host, client2_port, &is_sent);
-                        } else {
-                            log_message(PROTOCOL[10], client1_host, client1_port, &is_sent);
-                        }
-                        msg = Free(msg);
-                        break;
-                    } else if (status == 'D') {
-                        // if the game is a draw, then send PROTOCOL[14] to both clients
-                        if (send_message(sockets[0], PROTOCOL[14], strlen(PROTOCOL[14])) == -1) {
-                            perror("send_message");
-                            msg = Free(msg);
-                            break;
-                        }
-                        log_message(PROTOCOL[14], client1_host, client1_port, &is_sent);
-                        if (send_message(sockets[1], PROTOCOL[14], strlen(PROTOCOL[14])) == -1) {
-                            perror("send_message");
-                            msg = Free(msg);
-                            break;
-                        }
-                        log_message(PROTOCOL[14], client2_host, client2_port, &is_sent);
-                        msg = Free(msg);
-                        break;
-                    } else {
-                        // if the game is not over, then generate MOVD message
-                        char *movd_msg = NULL;
-                        if (generate_MOVD(board, rol, row, col, &movd_msg) == -1) {
-                            perror("generate_MOVD");
-                            msg = Free(msg);
-                            break;
-                        }
-
-                        // send the MOVD message to both clients
-                        if (send_message(sockets[0], movd_msg, strlen(movd_msg)) == -1) {
-                            perror("send_message");
-                            msg = Free(msg);
-                            break;
-                        }
-                        log_message(movd_msg, client1_host, client1_port, &is_sent);
-                        if (send_message(sockets[1], movd_msg, strlen(movd_msg)) == -1) {
-                            perror("send_message");
-                            msg = Free(msg);
-                            break;
-                        }
-                        log_message(movd_msg, client2_host, client2_port, &is_sent);
-
-                        // free the movd_msg variable
-                        movd_msg = Free(movd_msg);
-
-                        // update the turn
-                        turn = 1 - turn;
-                    }
-                } else {
-                    // if it is not the client's turn, then send PROTOCOL[3] to the same client
-                    if (send_message(sockets[index], PROTOCOL[3], strlen(PROTOCOL[3])) == -1) {
-                        perror("send_message");
-                        msg = Free(msg);
-                        break;
-                    }
-                    if (index == 0) {
-                        log_message(PROTOCOL[3], client1_host, client1_port, &is_sent);
-                    } else {
-                        log_message(PROTOCOL[3], client2_host, client2_port, &is_sent);
-                    }
-                }
+    // send the messages that were queued while this sendmsg was in flight
+    if (cl->first_output != NULL) {
+        add_flush(srv, cl);
+    }
+    release_client(srv, cl);
+}
+
+// function that queues a copy of the message for the client, which is sent when the clients are flushed
+// a client that does not read what it is sent can make the server hold at most MAX_QUEUED_MEMORY bytes of outputs for
+// it, counted by the size of their objects rather than of their messages, after which queueing fails with ENOBUFS and
+// the caller closes the client
+// returns -1 on error and 0 on success
+ssize_t queue_output(server *srv, client *cl, const char *message, size_t length) {
+    if (cl->state == CLIENT_CLOSED) {
+        errno = EPIPE;
+        return -1;
+    }
+    if (length > BEGN_CAPACITY) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    size_t footprint = get_output_footprint(length);
+    if (cl->output_memory + footprint > MAX_QUEUED_MEMORY) {
+        // with io_uring, the sendmsg in flight would wait for the client forever, so the socket is shut down to end it
+        if (srv->backend == BACKEND_IO_URING && cl->is_shut_down == 0) {
+            if (shutdown(cl->socket, SHUT_RDWR) == -1 && errno != ENOTCONN) {
+                perror("shutdown");
             }
+            cl->is_shut_down = 1;
         }
+        errno = ENOBUFS;
+        return -1;
+    }
 
-        // if none of the above messages were sent, then send PROTOCOL[3] to the same client
-        if (is_valid_msg == 0) {
-            if (send_message(sockets[index], PROTOCOL[3], strlen(PROTOCOL[3])) == -1) {
-                perror("send_message");
-                msg = Free(msg);
-                break;
-            }
-            if (index == 0) {
-                log_message(PROTOCOL[3], client1_host, client1_port, &is_sent);
-            } else {
-                log_message(PROTOCOL[3], client2_host, client2_port, &is_sent);
-            }
+    output *out = pool_alloc(get_output_pool(length));
+    if (out == NULL) {
+        return -1;
+    }
+    out->cause_arrived_at = srv->cause_arrived_at;
+    out->cause_code = srv->cause_code;
+    out->next = NULL;
+    out->length = length;
+    memcpy(out->message, message, length);
+    cl->output_memory += footprint;
+    if (cl->last_output == NULL) {
+        cl->first_output = out;
+    } else {
+        cl->last_output->next = out;
+    }
+    cl->last_output = out;
+    add_flush(srv, cl);
+    return 0;
+}
+
+// function that returns the pool that the output of a message of the given length comes from
+pool_kind get_output_pool(size_t length) {
+    return length <= SHORT_OUTPUT_CAPACITY ? POOL_SHORT_OUTPUT : POOL_LONG_OUTPUT;
+}
+
+// function that returns the memory that the output of a message of the given length takes, which is its whole object
+size_t get_output_footprint(size_t length) {
+    return sizeof(output) + (length <= SHORT_OUTPUT_CAPACITY ? SHORT_OUTPUT_CAPACITY : BEGN_CAPACITY);
+}
+
+// function that adds the client to the list of clients to flush
+void add_flush(server *srv, client *cl) {
+    if (cl->is_flushing == 1) {
+        return;
+    }
+    cl->is_flushing = 1;
+    cl->next_flush = srv->flush_clients;
+    srv->flush_clients = cl;
+}
+
+// function that sends the queued messages of every client in the list of clients to flush
+// every client is flushed once, so each peer of an event gets one system call (or one sendmsg) for all of its messages
+// and the messages leave in as few TCP segments as possible
+void flush_clients(server *srv) {
+    while (srv->flush_clients != NULL) {
+        client *cl = srv->flush_clients;
+        srv->flush_clients = cl->next_flush;
+        cl->is_flushing = 0;
+
+        if (srv->backend == BACKEND_IO_URING) {
+            send_outputs(srv, cl);
+            release_client(srv, cl);
+        } else {
+            write_outputs(srv, cl);
         }
+    }
+}
 
-        // free the msg variable
-        msg = Free(msg);
+// function that points the send header of the client to its first queued messages, past the bytes of the first one
+// that were already written
+// returns the number of gathered messages
+size_t gather_outputs(client *cl) {
+    size_t number_of_outputs = 0;
+    for (output *out = cl->first_output; out != NULL && number_of_outputs < MAX_GATHERED_MESSAGES; out = out->next) {
+        cl->send_vectors[number_of_outputs].iov_base = out->message;
+        cl->send_vectors[number_of_outputs].iov_len = out->length;
+        number_of_outputs++;
     }
+    if (number_of_outputs > 0) {
+        cl->send_vectors[0].iov_base = cl->first_output->message + cl->output_offset;
+        cl->send_vectors[0].iov_len -= cl->output_offset;
+    }
+    memset(&cl->send_header, 0, sizeof(struct msghdr));
+    cl->send_header.msg_iov = cl->send_vectors;
+    cl->send_header.msg_iovlen = number_of_outputs;
+    return number_of_outputs;
+}
 
-    // before exiting, free the game struct and any other dynamically allocated memory
-    free_game(args);
-    pthread_exit(NULL);
+// function that queues one sendmsg for the queued messages of the client with io_uring
+// a client only has one sendmsg in flight at a time, so its messages are sent in order
+void send_outputs(server *srv, client *cl) {
+    if (cl->sends_in_flight > 0 || cl->first_output == NULL) {
+        return;
+    }
+    size_t number_of_outputs = gather_outputs(cl);
+    uint64_t user_data = (uint64_t) (uintptr_t) cl | REQUEST_SEND;
+    if (uring_reserve(&srv->ring, 1) == -1 ||
+        uring_send_message(&srv->ring, cl->socket, &cl->send_header, user_data) == -1) {
+        perror("uring_send_message");
+        exit(EXIT_FAILURE);
+    }
+    cl->sends_in_flight = number_of_outputs;
 }
 
-// function that frees the game struct
-// returns NULL
-void free_game(game *arg) {
-    // input validation
-    if (arg == NULL) {
+// function that writes the queued messages of the client with epoll, gathering as many as fit in one writev()
+// the messages that do not fit in the send buffer stay queued and the client is blocked until its socket is writable,
+// so a client that does not read never stalls the shard
+void write_outputs(server *srv, client *cl) {
+    while (cl->first_output != NULL) {
+        size_t number_of_outputs = gather_outputs(cl);
+        size_t length = 0;
+        for (size_t i = 0; i < number_of_outputs; i++) {
+            length += cl->send_vectors[i].iov_len;
+        }
+        ssize_t bytes_written = send_messages(cl->socket, cl->send_vectors, number_of_outputs);
+        if (bytes_written == -1) {
+            // a failed write drops the connection and the messages that are still queued
+            perror("send_messages");
+            recorder_record(FLIGHT_ERROR, cl->id, FLIGHT_ERROR_SEND, (uint32_t) errno);
+            free_outputs(cl, SIZE_MAX);
+            cl->is_blocked = 0;
+            drop_client(srv, cl);
+            return;
+        }
+
+        // free the messages that were written completely, and keep how much of the next one was written
+        size_t bytes_left = bytes_written + cl->output_offset;
+        size_t number_of_written = 0;
+        for (output *out = cl->first_output; out != NULL && bytes_left >= out->length; out = out->next) {
+            bytes_left -= out->length;
+            number_of_written++;
+        }
+        metrics_add(METRIC_BYTES_SENT, bytes_written);
+        record_latencies(cl, number_of_written);
+        TRACE_SEND(cl->id, number_of_written, bytes_written);
+        free_outputs(cl, number_of_written);
+        cl->output_offset = bytes_left;
+
+        // the send buffer is full, so wait until the socket is writable
+        if ((size_t) bytes_written < length) {
+            block_client(srv, cl, 1);
+            return;
+        }
+    }
+    block_client(srv, cl, 0);
+}
+
+// function that blocks or unblocks a client with epoll, and watches its socket for room in its send buffer only while
+// it is blocked
+// a client is read from unless it is being handed off, and a closed client is not watched anymore
+void block_client(server *srv, client *cl, size_t is_blocked) {
+    if (cl->is_blocked == is_blocked || cl->state == CLIENT_CLOSED) {
         return;
     }
+    cl->is_blocked = is_blocked;
+    if (rewatch_socket(srv->readiness.event_loop, cl->socket, cl, cl->state != CLIENT_MOVING, is_blocked == 1) == -1) {
+        perror("rewatch_socket");
+    }
+}
 
-    // make sure to remove the player names from the shared list of players
-    remove_player_name(arg->player1_name);
-    remove_player_name(arg->player2_name);
+// function that frees the first messages of the client, up to the given number of messages
+void free_outputs(client *cl, size_t number_of_outputs) {
+    for (size_t i = 0; i < number_of_outputs && cl->first_output != NULL; i++) {
+        output *out = cl->first_output;
+        cl->first_output = out->next;
+        cl->output_memory -= get_output_footprint(out->length);
+        cl->output_offset = 0;
+        pool_free(get_output_pool(out->length), out);
+    }
+    if (cl->first_output == NULL) {
+        cl->last_output = NULL;
+    }
+}
 
-    // close the sockets and free the host and port strings
-    if (close(arg->client1_socket) == -1) {
-        perror("close");
+// function that records the latency of each of the first messages of the client that is a response, which have just
+// been written, from the arrival of the message they respond to
+void record_latencies(client *cl, size_t number_of_outputs) {
+    uint64_t now = 0;
+    output *out = cl->first_output;
+    for (size_t i = 0; i < number_of_outputs && out != NULL; i++, out = out->next) {
+        if (out->cause_arrived_at == 0) {
+            continue;
+        }
+        if (now == 0) {
+            now = get_time_in_ns();
+        }
+        metrics_record_latency(out->cause_code, now - out->cause_arrived_at);
     }
-    if (close(arg->client2_socket) == -1) {
-        perror("close");
+}
+
+// function that drops the connection of a client that could not be sent its messages, which also ends its game
+// a client that is being handed off finds out by itself on its next shard
+void drop_client(server *srv, client *cl) {
+    if (cl->state == CLIENT_PLAYING) {
+        free_game(srv, cl->game);
+    } else if (cl->state != CLIENT_MOVING) {
+        close_client(srv, cl);
     }
-    arg->client1_host = Free(arg->client1_host);
-    arg->client1_port = Free(arg->client1_port);
-    arg->player1_name = Free(arg->player1_name);
-    arg->msg_buffer1 = Free(arg->msg_buffer1);
-    arg->client2_host = Free(arg->client2_host);
-    arg->client2_port = Free(arg->client2_port);
-    arg->player2_name = Free(arg->player2_name);
-    arg->msg_buffer2 = Free(arg->msg_buffer2);
+}
 
-    // free the game struct
-    Free(arg);
+// function that keeps track of the deadline of a client with a partial message
+// the deadline restarts whenever new bytes arrive
+void update_deadline(server *srv, client *cl, size_t has_new_bytes) {
+    // only clients that are being read from and have a partial message have a deadline
+    if ((cl->state != CLIENT_HANDSHAKE && cl->state != CLIENT_PLAYING) ||
+        queue_length(&cl->input) == 0) {
+        timer_cancel(&srv->timers, &cl->message_timer);
+        return;
+    }
+
+    // keep the current deadline if nothing new has arrived
+    if (has_new_bytes == 0 && timer_is_armed(&cl->message_timer)) {
+        return;
+    }
+    timer_arm(&srv->timers, &cl->message_timer, get_time_in_ms() + get_message_timeout());
 }
 
-// function that writes the status of the game ("W" or "D" or "N") and the winner ("X" or "O") if there is one
-// returns -1 on error, 0 on success
-ssize_t get_game_status(const char *board, char *status, char *winner) {
-    // input validation
-    if (board == NULL || status == NULL || winner == NULL || strlen(board) != 9) {
-        return -1;
+// function that handles every timer of the shard that has expired
+void expire_deadlines(server *srv) {
+    long now = get_time_in_ms();
+    timer *expired;
+    while ((expired = timer_wheel_expire(&srv->timers, now)) != NULL) {
+        expire_timer(srv, expired);
     }
+}
 
-    // check if there is a winner horizontally
-    for (size_t i = 0; i < 9; i += 3) {
-        // make sure none of the spaces have a period (empty space)
-        if (board[i] != '.' && board[i] == board[i + 1] && board[i] == board[i + 2]) {
-            *status = 'W';
-            *winner = board[i];
-            return 0;
+// function that handles an expired timer
+// a partial message that stays quiet is malformed, a client that does not send PLAY in time is closed, a player whose
+// clock runs out loses, and a game without a message from either player for the idle timeout is abandoned, which
+// closes both clients
+void expire_timer(server *srv, timer *expired) {
+    if (expired->kind == TIMER_MESSAGE) {
+        reject_client(srv, expired->owner, "Message timed out");
+    } else if (expired->kind == TIMER_CLOCK) {
+        run_out_of_time(srv, expired->owner);
+    } else if (expired->kind == TIMER_HANDSHAKE) {
+        client *cl = expired->owner;
+        log_message("Handshake timed out", cl->host, cl->port, NULL);
+        recorder_record(FLIGHT_ERROR, cl->id, FLIGHT_ERROR_HANDSHAKE_TIMEOUT, 0);
+        close_client(srv, cl);
+    } else {
+        game *current = expired->owner;
+        for (size_t i = 0; i < 2; i++) {
+            log_message("Game abandoned", current->clients[i]->host, current->clients[i]->port, NULL);
+            recorder_record(FLIGHT_ERROR, current->clients[i]->id, FLIGHT_ERROR_GAME_ABANDONED, 0);
         }
+        free_game(srv, current);
     }
+}
 
-    // check if there is a winner vertically
-    for (size_t i = 0; i < 3; i++) {
-        // make sure none of the spaces have a period (empty space)
-        if (board[i] != '.' && board[i] == board[i + 3] && board[i] == board[i + 6]) {
-            *status = 'W';
-            *winner = board[i];
-            return 0;
+// function that stops the clock of the player who moved, adds the increment to it and starts the clock of the opponent
+void switch_clocks(server *srv, game *current, size_t index) {
+    if (srv->clock == 0) {
+        return;
+    }
+    long now = get_time_in_ms();
+    current->clocks[index] -= now - current->turn_started;
+    current->clocks[index] += srv->increment;
+    current->turn_started = now;
+    timer_arm(&srv->timers, &current->clock_timer, now + current->clocks[1 - index]);
+}
+
+// function that ends the game of a player whose clock has run out, who is the player to move
+// sends OVER to both clients, which the loser receives first, and closes them
+void run_out_of_time(server *srv, game *current) {
+    size_t index = current->turn;
+    if (send_and_log(srv, current->clients[index], &PROTOCOL[16]) == 0) {
+        send_and_log(srv, current->clients[1 - index], &PROTOCOL[15]);
+    }
+    free_game(srv, current);
+}
+
+// function that handles a message from a client that has not sent a valid PLAY message yet
+void handle_handshake(server *srv, client *cl, const message *decoded) {
+    // any message other than a valid PLAY message is a protocol error
+    if (decoded->code != CODE_PLAY) {
+        // send a protocol error message to the client
+        if (send_and_log(srv, cl, &PROTOCOL[3]) == -1) {
+            close_client(srv, cl);
         }
+        return;
     }
 
-    // check if there is a winner diagonally
-    if (board[0] != '.' && board[0] == board[4] && board[0] == board[8]) {
-        *status = 'W';
-        *winner = board[0];
-        return 0;
+    // copy the player name out of the message into an object of its size
+    char *player_name = copy_player_name(decoded->fields.play.name, decoded->fields.play.name_length);
+    if (player_name == NULL) {
+        perror("copy_player_name");
+        close_client(srv, cl);
+        return;
     }
-    if (board[2] != '.' && board[2] == board[4] && board[2] == board[6]) {
-        *status = 'W';
-        *winner = board[2];
-        return 0;
+
+    // add the player name to the set of player names, unless it is taken by a client of any shard
+    // the set points to the client's copy of the name, which close_client() removes from it before it is freed
+    if (add_player_name(player_name) == 1) {
+        // send a INVL message to the client
+        player_name = free_player_name(player_name);
+        if (send_and_log(srv, cl, &PROTOCOL[4]) == -1) {
+            close_client(srv, cl);
+        }
+        return;
+    }
+    cl->player_name = player_name;
+    set_client_state(cl, CLIENT_WAITING);
+    metrics_add(METRIC_HANDSHAKES_IN_FLIGHT, -1);
+    timer_cancel(&srv->timers, &cl->message_timer);
+    timer_cancel(&srv->timers, &cl->handshake_timer);
+
+    // every client waits for its opponent on the first shard
+    if (srv == &srv->shards[0]) {
+        wait_for_opponent(srv, cl);
+    } else {
+        move_clients(srv, &srv->shards[0], &cl, 1);
     }
+}
 
-    // check if there is a draw
-    for (size_t i = 0; i < 9; i++) {
-        // if there is an empty space, then there is no draw
-        if (board[i] == '.') {
-            *status = 'N';
-            *winner = '.';
-            return 0;
+// function that sends a WAIT message to a client that has reached the first shard, and pairs it with the client that
+// is already waiting, otherwise it waits for the next one
+// WAIT is only sent here, so a client that got WAIT is never paired before a client that got it earlier
+void wait_for_opponent(server *srv, client *cl) {
+    // send a WAIT message to the client, closing the client also frees its name
+    // WAIT is the response to the PLAY message, even if the client was handed over from another shard, and the BEGN
+    // messages of a new game are not a response to it
+    srv->cause_arrived_at = cl->arrived_at;
+    srv->cause_code = CODE_PLAY;
+    ssize_t result = send_and_log(srv, cl, &PROTOCOL[0]);
+    srv->cause_arrived_at = 0;
+    if (result == -1) {
+        close_client(srv, cl);
+        return;
+    }
+
+    if (srv->waiting_client == NULL) {
+        srv->waiting_client = cl;
+    } else {
+        client *opponent = srv->waiting_client;
+        srv->waiting_client = NULL;
+        pair_clients(srv, opponent, cl);
+    }
+}
+
+// function that starts a game between two waiting clients on the shard with the fewest games
+// client1 started waiting first and plays X
+// the game is counted right away, so the next pair already sees the shard as busier
+void pair_clients(server *srv, client *client1, client *client2) {
+    server *destination = get_least_loaded_shard(srv);
+    __atomic_add_fetch(&destination->number_of_games, 1, __ATOMIC_RELAXED);
+    if (destination == srv) {
+        start_game(srv, client1, client2);
+    } else {
+        client *clients[2] = {client1, client2};
+        move_clients(srv, destination, clients, 2);
+    }
+}
+
+// function that returns the shard with the fewest games, preferring the given shard so clients only move if it helps
+server* get_least_loaded_shard(server *srv) {
+    server *least_loaded = srv;
+    size_t fewest_games = __atomic_load_n(&srv->number_of_games, __ATOMIC_RELAXED);
+    for (size_t i = 0; i < srv->number_of_shards; i++) {
+        size_t number_of_games = __atomic_load_n(&srv->shards[i].number_of_games, __ATOMIC_RELAXED);
+        if (number_of_games < fewest_games) {
+            least_loaded = &srv->shards[i];
+            fewest_games = number_of_games;
         }
     }
+    return least_loaded;
+}
 
-    // if there is no winner and no empty spaces, then there is a draw
-    *status = 'D';
-    *winner = '.';
-    return 0;
+// function that starts handing the clients to another shard, which is done once nothing of this shard refers to them
+// with epoll, the sockets are no longer read from, and leave the event loop once their queued messages are written
+// with io_uring, the receives are cancelled and the messages that are queued for the clients are sent first
+void move_clients(server *srv, server *destination, client **clients, size_t number_of_clients) {
+    handoff *current = pool_alloc(POOL_HANDOFF);
+    if (current == NULL) {
+        perror("pool_alloc");
+        exit(EXIT_FAILURE);
+    }
+    memset(current, 0, sizeof(handoff));
+    current->destination = destination;
+    current->number_of_clients = number_of_clients;
+
+    for (size_t i = 0; i < number_of_clients; i++) {
+        client *cl = clients[i];
+        set_client_state(cl, CLIENT_MOVING);
+        current->clients[i] = cl;
+        if (srv->backend == BACKEND_EPOLL) {
+            if (cl->is_blocked == 1 &&
+                rewatch_socket(srv->readiness.event_loop, cl->socket, cl, 0, 1) == -1) {
+                perror("rewatch_socket");
+            }
+        } else if (cl->is_receiving == 1 &&
+                   uring_cancel(&srv->ring, (uint64_t) (uintptr_t) cl | REQUEST_RECEIVE,
+                                (uint64_t) (uintptr_t) cl | REQUEST_HANDOFF) == -1) {
+            perror("uring_cancel");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // the clients are handed off after the current batch of events, since later events may still point to them
+    current->next = srv->departures;
+    srv->departures = current;
 }
 
-// function that makes a move on the board
-// returns -1 on error, 0 on success
-ssize_t make_move(char *board, char role, size_t row, size_t col) {
-    // input validation
-    if (board == NULL || strlen(board) != 9) {
-        return -1;
+// function that checks whether no request of the io_uring backend refers to the client anymore, and whether every
+// message that was queued for it has been written
+size_t is_client_idle(const client *cl) {
+    return cl->first_output == NULL && cl->sends_in_flight == 0 && cl->is_flushing == 0 && cl->is_receiving == 0;
+}
+
+// function that hands every client that is ready to leave this shard to the shard it moves to
+void send_handoffs(server *srv) {
+    handoff **link = &srv->departures;
+    while (*link != NULL) {
+        handoff *current = *link;
+
+        // wait until nothing of this shard refers to the clients
+        size_t is_idle = 1;
+        for (size_t i = 0; i < current->number_of_clients; i++) {
+            is_idle = is_idle && is_client_idle(current->clients[i]);
+        }
+        if (is_idle == 0) {
+            link = &current->next;
+            continue;
+        }
+        *link = current->next;
+        server *destination = current->destination;
+
+        // with epoll, the sockets leave the event loop of this shard now that their messages have been written
+        for (size_t i = 0; srv->backend == BACKEND_EPOLL && i < current->number_of_clients; i++) {
+            if (unwatch_socket(srv->readiness.event_loop, current->clients[i]->socket) == -1) {
+                perror("unwatch_socket");
+            }
+        }
+
+        // count a waiting client that is handed to the first shard, and note when it left if the metrics are served
+        if (current->number_of_clients == 1) {
+            metrics_add(METRIC_PAIRING_DEPTH, 1);
+            metrics_add(METRIC_PAIRING_PUSHED, 1);
+            current->handed_at = metrics_are_served() == 1 ? get_time_in_ns() : 0;
+        }
+
+        // add the clients to the arrivals of the destination
+        current->next = NULL;
+        obtain_mutex_lock(&destination->handoff_mutex);
+        if (destination->last_arrival == NULL) {
+            destination->first_arrival = current;
+        } else {
+            destination->last_arrival->next = current;
+        }
+        destination->last_arrival = current;
+        release_mutex_lock(&destination->handoff_mutex);
+
+        // wake the destination up
+        uint64_t wake_up = 1;
+        if (write(destination->handoff_event, &wake_up, sizeof(wake_up)) != sizeof(wake_up)) {
+            perror("write");
+        }
     }
+}
 
-    // check role
-    if (role != 'X' && role != 'O') {
-        return -1;
+// function that takes over the clients that other shards have handed to this shard
+// a waiting client waits for its opponent here, and the two clients of a game start their game here
+// the first shard pairs the waiting clients in the order they were handed to it
+void receive_handoffs(server *srv) {
+    // reset the eventfd before taking the arrivals, so an arrival that is added afterwards wakes the shard again
+    uint64_t wake_ups = 0;
+    if (read(srv->handoff_event, &wake_ups, sizeof(wake_ups)) == -1 && errno != EAGAIN) {
+        perror("read");
     }
+    obtain_mutex_lock(&srv->handoff_mutex);
+    handoff *arrivals = srv->first_arrival;
+    srv->first_arrival = NULL;
+    srv->last_arrival = NULL;
+    release_mutex_lock(&srv->handoff_mutex);
+
+    while (arrivals != NULL) {
+        handoff *current = arrivals;
+        arrivals = current->next;
+
+        // register the sockets with this shard, and close the clients if that fails
+        ssize_t result = 0;
+        for (size_t i = 0; i < current->number_of_clients; i++) {
+            if (adopt_client(srv, current->clients[i]) == -1) {
+                perror("adopt_client");
+                recorder_record(FLIGHT_ERROR, current->clients[i]->id, FLIGHT_ERROR_HANDOFF, (uint32_t) errno);
+                result = -1;
+            }
+        }
 
-    // check row and col
-    if (row > 2 || col > 2) {
-        return -1;
+        if (current->number_of_clients == 1) {
+            metrics_add(METRIC_PAIRING_DEPTH, -1);
+            if (current->handed_at != 0) {
+                metrics_add(METRIC_PAIRING_WAIT, (int64_t) (get_time_in_ns() - current->handed_at));
+            }
+        }
+
+        if (current->number_of_clients == 1 && result == 0) {
+            set_client_state(current->clients[0], CLIENT_WAITING);
+            wait_for_opponent(srv, current->clients[0]);
+        } else if (current->number_of_clients == 2 && result == 0) {
+            start_game(srv, current->clients[0], current->clients[1]);
+        } else {
+            for (size_t i = 0; i < current->number_of_clients; i++) {
+                close_client(srv, current->clients[i]);
+            }
+            if (current->number_of_clients == 2) {
+                __atomic_sub_fetch(&srv->number_of_games, 1, __ATOMIC_RELAXED);
+            }
+        }
+        pool_free(POOL_HANDOFF, current);
     }
+}
 
-    // check if the space is empty
-    if (board[row * 3 + col] != '.') {
+// function that registers the socket of a client that was handed to this shard with its event loop
+// the bytes the client sent while it was moving are still in its queue
+// returns -1 on error and 0 on success
+ssize_t adopt_client(server *srv, client *cl) {
+    set_client_state(cl, CLIENT_WAITING);
+    if (srv->backend == BACKEND_EPOLL) {
+        return watch_socket(srv->readiness.event_loop, cl->socket, cl);
+    }
+    if (uring_receive_multishot(&srv->ring, cl->socket, (uint64_t) (uintptr_t) cl | REQUEST_RECEIVE) == -1) {
         return -1;
     }
+    cl->is_receiving = 1;
+    return 0;
+}
+
+// function that starts a game between two waiting clients
+void start_game(server *srv, client *client1, client *client2) {
+    // create a game struct
+    game *current = pool_alloc(POOL_GAME);
+    if (current == NULL) {
+        perror("pool_alloc");
+        exit(EXIT_FAILURE);
+    }
+    memset(current, 0, sizeof(game));
+    board_init(&current->board);
+    current->number_of_clients = 2;
+    metrics_add(METRIC_GAMES_STARTED, 1);
+    metrics_add(METRIC_LIVE_GAMES, 1);
+    timer_init(&current->idle_timer, TIMER_GAME, current);
+    timer_arm(&srv->timers, &current->idle_timer, get_time_in_ms() + srv->idle_timeout);
+
+    // with time controls, the clock of X starts with the game
+    timer_init(&current->clock_timer, TIMER_CLOCK, current);
+    if (srv->clock > 0) {
+        current->clocks[0] = srv->clock;
+        current->clocks[1] = srv->clock;
+        current->turn_started = get_time_in_ms();
+        timer_arm(&srv->timers, &current->clock_timer, current->turn_started + srv->clock);
+    }
+    current->clients[0] = client1;
+    current->clients[1] = client2;
+    for (size_t i = 0; i < 2; i++) {
+        current->clients[i]->game = current;
+        current->clients[i]->index = i;
+        set_client_state(current->clients[i], CLIENT_PLAYING);
+    }
+
+    // first generate BEGN message for each client
+    // client1 is X and client2 is O
+    char begn_msg1[BEGN_CAPACITY];
+    char begn_msg2[BEGN_CAPACITY];
+    wire_frame begn_frame1;
+    wire_frame begn_frame2;
+    if (generate_BEGN('X', client2->player_name, begn_msg1, &begn_frame1) == -1 ||
+        generate_BEGN('O', client1->player_name, begn_msg2, &begn_frame2) == -1) {
+        perror("generate_BEGN");
+        free_game(srv, current);
+        return;
+    }
+
+    // send BEGN message to each client
+    if (send_and_log(srv, client1, &begn_frame1) == -1 || send_and_log(srv, client2, &begn_frame2) == -1) {
+        free_game(srv, current);
+        return;
+    }
+
+    // process the messages that arrived while the clients were waiting, whose responses are not timed, since they
+    // waited for the game to begin
+    for (size_t i = 0; i < 2; i++) {
+        current->clients[i]->arrived_at = 0;
+    }
+    for (size_t i = 0; i < 2; i++) {
+        process_client(srv, current->clients[i]);
+        if (client1->state == CLIENT_CLOSED) {
+            return;
+        }
+        update_deadline(srv, current->clients[i], 1);
+    }
+}
 
-    // make the move
-    board[row * 3 + col] = role;
+// function that handles a decoded message from the client at the given index of the game
+// returns -1 if the game is over and 0 if the game continues
+ssize_t handle_game(server *srv, game *current, size_t index, const message *decoded) {
+    client **clients = current->clients;
+
+    switch (decoded->code) {
+        case CODE_RSGN:
+            // if a client sends a RSGN message, the server should send OVER to both clients
+            // which is in PROTOCOL[11] for winner and PROTOCOL[12] for loser
+            if (send_and_log(srv, clients[index], &PROTOCOL[12]) == -1) {
+                return -1;
+            }
+            send_and_log(srv, clients[1 - index], &PROTOCOL[11]);
+            return -1;
+        case CODE_DRAW:
+            return handle_draw(srv, current, index, decoded->fields.draw.action);
+        case CODE_MOVE:
+            return handle_move(srv, current, index, decoded->fields.move.role,
+                               decoded->fields.move.row, decoded->fields.move.col);
+        default:
+            // any other message is a protocol error, so send PROTOCOL[3] to the same client
+            if (send_and_log(srv, clients[index], &PROTOCOL[3]) == -1) {
+                return -1;
+            }
+            return 0;
+    }
+}
+
+// function that handles a DRAW message with the given action from the client at the given index of the game
+// returns -1 if the game is over and 0 if the game continues
+ssize_t handle_draw(server *srv, game *current, size_t index, char action) {
+    client **clients = current->clients;
+
+    // if a draw has already been suggested, then check if this is the client that is expected to respond
+    if (current->is_draw_suggested == 1 && index == current->draw_response_index) {
+        if (action == 'R') {
+            // if the client responds with reject, then send PROTOCOL[7] to the other client
+            if (send_and_log(srv, clients[1 - index], &PROTOCOL[7]) == -1) {
+                return -1;
+            }
+            current->is_draw_suggested = 0;
+        } else if (action == 'A') {
+            // if the client responds with accept, then send PROTOCOL[13] to both clients
+            if (send_and_log(srv, clients[0], &PROTOCOL[13]) == -1) {
+                return -1;
+            }
+            send_and_log(srv, clients[1], &PROTOCOL[13]);
+            return -1;
+        } else {
+            // if the client responds with suggest or anything else, then send PROTOCOL[3] to the same client
+            if (send_and_log(srv, clients[index], &PROTOCOL[3]) == -1) {
+                return -1;
+            }
+        }
+    } else if (current->is_draw_suggested == 1) {
+        // if a draw has already been suggested, but this is not the client that is expected to respond
+        // then send PROTOCOL[3] to the same client
+        if (send_and_log(srv, clients[index], &PROTOCOL[3]) == -1) {
+            return -1;
+        }
+    } else {
+        // if a draw has not been suggested, then check if the client wants to suggest a draw
+        // otherwise send PROTOCOL[3] to the same client
+        if (action == 'S') {
+            // if the client wants to suggest a draw, then send PROTOCOL[5] to the other client
+            if (send_and_log(srv, clients[1 - index], &PROTOCOL[5]) == -1) {
+                return -1;
+            }
+            current->is_draw_suggested = 1;
+            current->draw_response_index = 1 - index;
+        } else {
+            // if the client does not want to suggest a draw, then send PROTOCOL[3] to the same client
+            if (send_and_log(srv, clients[index], &PROTOCOL[3]) == -1) {
+                return -1;
+            }
+        }
+    }
 
     return 0;
 }
 
-// function that generates a MOVD message
-// returns -1 on error, 0 on success
-ssize_t generate_MOVD(const char *board, char role, size_t row, size_t col, char **movd_msg) {
-    // input validation
-    if (board == NULL || strlen(board) != 9 || movd_msg == NULL) {
-        return -1;
+// function that handles a MOVE message from the client at the given index of the game
+// returns -1 if the game is over and 0 if the game continues
+ssize_t handle_move(server *srv, game *current, size_t index, char rol, size_t row, size_t col) {
+    client **clients = current->clients;
+
+    // initialize variable that keeps track of each player's role
+    // client1 is X and client2 is O
+    char role[3] = "XO";
+
+    // a move will only be processed if a draw has not been suggested and it is the client's turn
+    // otherwise send PROTOCOL[3] to the same client
+    if (current->is_draw_suggested == 1 || rol != role[index] || current->turn != index) {
+        if (send_and_log(srv, clients[index], &PROTOCOL[3]) == -1) {
+            return -1;
+        }
+        return 0;
     }
 
-    // check role
-    if (role != 'X' && role != 'O') {
-        return -1;
+    // a move that arrives after the clock of the player ran out loses on time, even if the timer has not expired yet
+    if (srv->clock > 0 && get_time_in_ms() - current->turn_started >= current->clocks[index]) {
+        run_out_of_time(srv, current);
+        return 0;
     }
 
-    // check row and col
-    if (row > 2 || col > 2) {
+    // if the move is invalid, then send PROTOCOL[2] to the same client
+    if (board_make_move(&current->board, rol, row, col) == -1) {
+        if (send_and_log(srv, clients[index], &PROTOCOL[2]) == -1) {
+            return -1;
+        }
+        return 0;
+    }
+    TRACE_MOVE(clients[index]->id, rol, row, col);
+
+    // check if the game is over
+    char status = '\0';
+    char winner = '\0';
+    board_get_status(&current->board, &status, &winner);
+
+    // check the status of the game
+    if (status == 'W') {
+        // get the winner's index
+        size_t winner_index = 0;
+        if (winner == role[index]) {
+            winner_index = index;
+        } else {
+            winner_index = 1 - index;
+        }
+
+        // send PROTOCOL[9] to the winner and send PROTOCOL[10] to the loser
+        if (send_and_log(srv, clients[winner_index], &PROTOCOL[9]) == -1) {
+            return -1;
+        }
+        send_and_log(srv, clients[1 - winner_index], &PROTOCOL[10]);
+        return -1;
+    } else if (status == 'D') {
+        // if the game is a draw, then send PROTOCOL[14] to both clients
+        if (send_and_log(srv, clients[0], &PROTOCOL[14]) == -1) {
+            return -1;
+        }
+        send_and_log(srv, clients[1], &PROTOCOL[14]);
         return -1;
     }
 
-    // check if the space is empty
-    if (board[row * 3 + col] != role) {
+    // if the game is not over, then look up the MOVD message
+    wire_frame movd_frame;
+    if (get_movd_frame(&current->board, row, col, &movd_frame) == -1) {
+        perror("get_movd_frame");
         return -1;
     }
 
-    // generate the message
-    char *message = malloc(strlen(PROTOCOL[1]) + 17);
-    if (message == NULL) {
+    // send the MOVD message to both clients
+    if (send_and_log(srv, clients[0], &movd_frame) == -1 || send_and_log(srv, clients[1], &movd_frame) == -1) {
         return -1;
     }
-    strcpy(message, PROTOCOL[1]);
-    message[8] = role;
-    message[9] = '|';
-    message[10] = row + 1 + '0'; // NOLINT(cppcoreguidelines-narrowing-conversions)
-    message[11] = ',';
-    message[12] = col + 1 + '0'; // NOLINT(cppcoreguidelines-narrowing-conversions)
-    message[13] = '|';
-    message[14] = '\0';
-    strcat(message, board);
-    strcat(message, "|");
-
-    // set the movd_msg pointer to point to the message
-    *movd_msg = message;
+
+    // update the turn and hand the clock to the other player
+    switch_clocks(srv, current, index);
+    current->turn = 1 - current->turn;
+
     return 0;
 }
 
-// function that generates a BEGN message
-// returns -1 on error, 0 on success
-ssize_t generate_BEGN(char role, const char *opponent_name, char **begn_msg) {
+// function that ends the game by closing both clients, the game struct is freed once both clients have been freed
+void free_game(server *srv, game *current) {
     // input validation
-    if (role != 'X' && role != 'O') {
-        return -1;
-    }
-    if (opponent_name == NULL || strlen(opponent_name) == 0) {
-        return -1;
+    if (current == NULL) {
+        return;
     }
 
-    // calculate number of remaining bytes
-    size_t remaining_bytes = 2 + strlen(opponent_name) + 1;
+    TRACE_GAME_OVER(current->clients[0]->id, current->clients[1]->id,
+                    __builtin_popcount(current->board.x | current->board.o));
 
-    // calculate the number of digits in remaining_bytes
-    size_t num_digits = 0;
-    size_t temp = remaining_bytes;
-    while (temp > 0) {
-        temp /= 10;
-        num_digits++;
-    }
+    // close both clients, which removes their names from the shared set of player names
+    timer_cancel(&srv->timers, &current->idle_timer);
+    timer_cancel(&srv->timers, &current->clock_timer);
+    close_client(srv, current->clients[0]);
+    close_client(srv, current->clients[1]);
 
-    // calculate size of the message BEGN|6|X|bar| + 1 for null terminator
-    size_t size = strlen(PROTOCOL[8]) + num_digits + 1 + 2 + strlen(opponent_name) + 1 + 1;
+    // the game is no longer counted by the shard, and it is freed once both clients have been freed
+    __atomic_sub_fetch(&srv->number_of_games, 1, __ATOMIC_RELAXED);
+    metrics_add(METRIC_LIVE_GAMES, -1);
+}
 
-    // example of message is BEGN|6|X|bar|, where 6 is the remaining number of bytes after "|" and "X" is the role
-    // and bar is the opponent's name
+// function that drops the reference of a client that is being freed to its game
+// the last client to leave frees the game struct
+void leave_game(client *cl) {
+    game *current = cl->game;
+    cl->game = NULL;
+    if (current == NULL || --current->number_of_clients > 0) {
+        return;
+    }
+    pool_free(POOL_GAME, current);
+}
 
-    // allocate memory for the message
-    char *message = malloc(size);
-    if (message == NULL) {
+// function that queues a message for the client, which is sent when the clients are flushed, and logs it using
+// log_message()
+// returns -1 on error and 0 on success
+ssize_t send_and_log(server *srv, client *cl, const wire_frame *frame) {
+    if (queue_output(srv, cl, frame->bytes, frame->length) == -1) {
+        perror("queue_output");
+        recorder_record(FLIGHT_ERROR, cl->id, FLIGHT_ERROR_QUEUE, (uint32_t) errno);
         return -1;
     }
+    size_t is_sent = 1;
+    log_message(frame->bytes, cl->host, cl->port, &is_sent);
 
-    // generate the message
-    strcpy(message, PROTOCOL[8]);
-    // convert remaining_bytes to a string
-    char *remaining_bytes_str = malloc(num_digits + 1);
-    if (remaining_bytes_str == NULL) {
-        Free(message);
-        return -1;
+    // count the message by its opcode, and an INVL message by its reason, which are PROTOCOL[2] to PROTOCOL[4]
+    message_code code;
+    if (translate_code(frame->bytes, &code) == 0) {
+        metrics_add(METRIC_MESSAGES_SENT + code, 1);
+        recorder_record(FLIGHT_FRAME_OUT, cl->id, code, (uint32_t) frame->length);
+    }
+    if (frame >= &PROTOCOL[2] && frame <= &PROTOCOL[4]) {
+        metrics_add(METRIC_INVALID_MESSAGES + (frame - &PROTOCOL[2]), 1);
     }
-    sprintf(remaining_bytes_str, "%zu", remaining_bytes);
-    strcat(message, remaining_bytes_str);
-    Free(remaining_bytes_str);
-    strcat(message, "|");
-    size_t intermediate_size = strlen(message);
-    message[intermediate_size] = role;
-    message[intermediate_size + 1] = '\0';
-    strcat(message, "|");
-    strcat(message, opponent_name);
-    strcat(message, "|");
-
-    // set the begn_msg pointer to point to the message
-    *begn_msg = message;
     return 0;
 }
 
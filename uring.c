@@ -0,0 +1,377 @@
+#define _DEFAULT_SOURCE
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include "uring.h"
+
+// prototypes of internal functions
+static int uring_setup(unsigned entries, struct io_uring_params *params);
+static int uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags, void *arg, size_t size);
+static int uring_register(int ring_fd, unsigned opcode, void *arg, unsigned number_of_args);
+static int uring_is_supported(int ring_fd);
+static int uring_setup_buffers(uring *ring);
+static struct io_uring_sqe* uring_get_sqe(uring *ring);
+static int uring_submit(uring *ring);
+
+// function that creates an io_uring instance with a registered ring of provided buffers
+// fails on kernels without multishot accept, multishot receive or provided buffer rings, so the caller can fall back
+// returns -1 on error and 0 on success
+int uring_create(uring *ring) {
+    // input validation
+    if (ring == NULL) {
+        return -1;
+    }
+    memset(ring, 0, sizeof(uring));
+
+    // create the ring with a larger completion queue, since multishot requests post many completions
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(struct io_uring_params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = URING_ENTRIES * 8;
+    ring->ring_fd = uring_setup(URING_ENTRIES, &params);
+    if (ring->ring_fd == -1) {
+        return -1;
+    }
+
+    // waiting with a timeout requires IORING_FEAT_EXT_ARG and the rings are mapped once with IORING_FEAT_SINGLE_MMAP
+    if ((params.features & IORING_FEAT_EXT_ARG) == 0 || (params.features & IORING_FEAT_SINGLE_MMAP) == 0 ||
+        uring_is_supported(ring->ring_fd) == 0) {
+        close(ring->ring_fd);
+        errno = ENOSYS;
+        return -1;
+    }
+
+    // map the submission and completion queue rings, which share one mapping
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (ring->cq_ring_size > ring->sq_ring_size) {
+        ring->sq_ring_size = ring->cq_ring_size;
+    }
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         ring->ring_fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED) {
+        close(ring->ring_fd);
+        return -1;
+    }
+    ring->cq_ring = ring->sq_ring;
+
+    // map the submission queue entries
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring->ring_fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        munmap(ring->sq_ring, ring->sq_ring_size);
+        close(ring->ring_fd);
+        return -1;
+    }
+
+    // save pointers to the fields of the rings
+    char *sq = ring->sq_ring;
+    char *cq = ring->cq_ring;
+    ring->sq_head = (unsigned *) (sq + params.sq_off.head);
+    ring->sq_tail = (unsigned *) (sq + params.sq_off.tail);
+    ring->sq_mask = *(unsigned *) (sq + params.sq_off.ring_mask);
+    ring->sq_entries = params.sq_entries;
+    ring->sq_local_tail = *ring->sq_tail;
+    ring->cq_head = (unsigned *) (cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *) (cq + params.cq_off.tail);
+    ring->cq_mask = *(unsigned *) (cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+
+    // every submission queue slot always refers to the entry with the same index
+    unsigned *sq_array = (unsigned *) (sq + params.sq_off.array);
+    for (unsigned i = 0; i < params.sq_entries; i++) {
+        sq_array[i] = i;
+    }
+
+    // register the ring of provided buffers
+    if (uring_setup_buffers(ring) == -1) {
+        int error = errno;
+        munmap(ring->sqes, ring->sqes_size);
+        munmap(ring->sq_ring, ring->sq_ring_size);
+        close(ring->ring_fd);
+        errno = error;
+        return -1;
+    }
+
+    // return 0 on success
+    return 0;
+}
+
+// function that unmaps and closes the io_uring instance
+void uring_destroy(uring *ring) {
+    if (ring == NULL || ring->ring_fd <= 0) {
+        return;
+    }
+    munmap(ring->buffer_ring, ring->buffer_ring_size);
+    ring->buffers = Free(ring->buffers);
+    munmap(ring->sqes, ring->sqes_size);
+    munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->ring_fd);
+    ring->ring_fd = -1;
+}
+
+// function that submits queued entries until the given number of entries fit in the submission queue
+// returns -1 on error and 0 on success
+int uring_reserve(uring *ring, unsigned number_of_entries) {
+    if (number_of_entries > ring->sq_entries) {
+        return -1;
+    }
+    while (ring->sq_local_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) + number_of_entries >
+           ring->sq_entries) {
+        unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        if (uring_submit(ring) == -1 || head == __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// function that queues a multishot accept on the server socket
+// returns -1 on error and 0 on success
+int uring_accept_multishot(uring *ring, int server_socket, uint64_t user_data) {
+    struct io_uring_sqe *sqe = uring_get_sqe(ring);
+    if (sqe == NULL) {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = server_socket;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = user_data;
+    return 0;
+}
+
+// function that queues a multishot receive on the socket that reads into the provided buffers
+// returns -1 on error and 0 on success
+int uring_receive_multishot(uring *ring, int socket, uint64_t user_data) {
+    struct io_uring_sqe *sqe = uring_get_sqe(ring);
+    if (sqe == NULL) {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = socket;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BUFFER_GROUP;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->user_data = user_data;
+    return 0;
+}
+
+// function that queues a multishot poll that completes whenever the file descriptor is readable
+// returns -1 on error and 0 on success
+int uring_poll_multishot(uring *ring, int fd, uint64_t user_data) {
+    struct io_uring_sqe *sqe = uring_get_sqe(ring);
+    if (sqe == NULL) {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = user_data;
+    return 0;
+}
+
+// function that queues the cancellation of the request with the given user data
+// the cancelled request completes with -ECANCELED, and the cancellation itself completes with the given user data
+// returns -1 on error and 0 on success
+int uring_cancel(uring *ring, uint64_t target_user_data, uint64_t user_data) {
+    struct io_uring_sqe *sqe = uring_get_sqe(ring);
+    if (sqe == NULL) {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = target_user_data;
+    sqe->user_data = user_data;
+    return 0;
+}
+
+// function that queues a send of every message that the header gathers on the socket, which leaves in a single sendmsg
+// the header, its vectors and the messages must stay valid until the completion of the send
+// returns -1 on error and 0 on success
+int uring_send_message(uring *ring, int socket, const struct msghdr *header, uint64_t user_data) {
+    struct io_uring_sqe *sqe = uring_get_sqe(ring);
+    if (sqe == NULL) {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = socket;
+    sqe->addr = (uint64_t) (uintptr_t) header;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_WAITALL | MSG_NOSIGNAL;
+    sqe->user_data = user_data;
+    return 0;
+}
+
+// function that submits every queued entry and waits for at least one completion or the timeout (in milliseconds)
+// a timeout of -1 waits indefinitely
+// returns -1 on error and 0 on success or timeout
+int uring_wait(uring *ring, int timeout) {
+    // publish the queued entries to the kernel
+    __atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+
+    struct __kernel_timespec wait_time;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(struct io_uring_getevents_arg));
+    if (timeout >= 0) {
+        wait_time.tv_sec = timeout / 1000;
+        wait_time.tv_nsec = (timeout % 1000) * 1000000L;
+        arg.ts = (uint64_t) (uintptr_t) &wait_time;
+    }
+
+    int submitted = uring_enter(ring->ring_fd, ring->to_submit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                                &arg, sizeof(struct io_uring_getevents_arg));
+    if (submitted == -1) {
+        if (errno == ETIME || errno == EINTR || errno == EBUSY) {
+            return 0;
+        }
+        return -1;
+    }
+    ring->to_submit -= submitted;
+    return 0;
+}
+
+// function that returns the next completion or NULL if there is none
+struct io_uring_cqe* uring_get_completion(uring *ring) {
+    unsigned head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    return &ring->cqes[head & ring->cq_mask];
+}
+
+// function that marks the completion returned by uring_get_completion() as consumed
+void uring_complete(uring *ring) {
+    __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+// function that returns the provided buffer that the completion's data was received into
+// returns NULL if the completion does not carry a buffer
+char* uring_get_buffer(uring *ring, const struct io_uring_cqe *completion) {
+    if ((completion->flags & IORING_CQE_F_BUFFER) == 0) {
+        return NULL;
+    }
+    unsigned buffer_id = completion->flags >> IORING_CQE_BUFFER_SHIFT;
+    return ring->buffers + (size_t) buffer_id * URING_BUFFER_SIZE;
+}
+
+// function that gives the provided buffer of the completion back to the kernel
+void uring_recycle_buffer(uring *ring, const struct io_uring_cqe *completion) {
+    if ((completion->flags & IORING_CQE_F_BUFFER) == 0) {
+        return;
+    }
+    unsigned short buffer_id = completion->flags >> IORING_CQE_BUFFER_SHIFT;
+    struct io_uring_buf *buffer = &ring->buffer_ring->bufs[ring->buffer_tail & (URING_BUFFER_COUNT - 1)];
+    buffer->addr = (uint64_t) (uintptr_t) (ring->buffers + (size_t) buffer_id * URING_BUFFER_SIZE);
+    buffer->len = URING_BUFFER_SIZE;
+    buffer->bid = buffer_id;
+    ring->buffer_tail++;
+    __atomic_store_n(&ring->buffer_ring->tail, ring->buffer_tail, __ATOMIC_RELEASE);
+}
+
+// function that wraps the io_uring_setup system call
+static int uring_setup(unsigned entries, struct io_uring_params *params) {
+    return (int) syscall(__NR_io_uring_setup, entries, params);
+}
+
+// function that wraps the io_uring_enter system call
+static int uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags, void *arg, size_t size) {
+    return (int) syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg, size);
+}
+
+// function that wraps the io_uring_register system call
+static int uring_register(int ring_fd, unsigned opcode, void *arg, unsigned number_of_args) {
+    return (int) syscall(__NR_io_uring_register, ring_fd, opcode, arg, number_of_args);
+}
+
+// function that checks whether the kernel supports every operation of the backend
+// multishot receive arrived in the same release as IORING_OP_SEND_ZC, so that operation stands in for it
+// returns 1 if supported and 0 otherwise
+static int uring_is_supported(int ring_fd) {
+    size_t size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = malloc(size);
+    if (probe == NULL) {
+        return 0;
+    }
+    memset(probe, 0, size);
+    if (uring_register(ring_fd, IORING_REGISTER_PROBE, probe, 256) == -1) {
+        Free(probe);
+        return 0;
+    }
+
+    int is_supported = 1;
+    const unsigned char operations[] = {IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_SEND_ZC};
+    for (size_t i = 0; i < sizeof(operations); i++) {
+        if (operations[i] > probe->last_op || (probe->ops[operations[i]].flags & IO_URING_OP_SUPPORTED) == 0) {
+            is_supported = 0;
+        }
+    }
+    Free(probe);
+    return is_supported;
+}
+
+// function that allocates the provided buffers and registers them as a buffer ring
+// returns -1 on error and 0 on success
+static int uring_setup_buffers(uring *ring) {
+    // the buffer ring must be page aligned, so map it
+    ring->buffer_ring_size = URING_BUFFER_COUNT * sizeof(struct io_uring_buf);
+    ring->buffer_ring = mmap(NULL, ring->buffer_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring->buffer_ring == MAP_FAILED) {
+        return -1;
+    }
+    ring->buffers = malloc((size_t) URING_BUFFER_COUNT * URING_BUFFER_SIZE);
+    if (ring->buffers == NULL) {
+        munmap(ring->buffer_ring, ring->buffer_ring_size);
+        return -1;
+    }
+
+    // register the buffer ring, which fails on kernels without provided buffer rings
+    struct io_uring_buf_reg registration;
+    memset(&registration, 0, sizeof(struct io_uring_buf_reg));
+    registration.ring_addr = (uint64_t) (uintptr_t) ring->buffer_ring;
+    registration.ring_entries = URING_BUFFER_COUNT;
+    registration.bgid = URING_BUFFER_GROUP;
+    if (uring_register(ring->ring_fd, IORING_REGISTER_PBUF_RING, &registration, 1) == -1) {
+        munmap(ring->buffer_ring, ring->buffer_ring_size);
+        ring->buffers = Free(ring->buffers);
+        return -1;
+    }
+
+    // hand every buffer to the kernel
+    ring->buffer_tail = 0;
+    for (unsigned i = 0; i < URING_BUFFER_COUNT; i++) {
+        struct io_uring_buf *buffer = &ring->buffer_ring->bufs[i];
+        buffer->addr = (uint64_t) (uintptr_t) (ring->buffers + (size_t) i * URING_BUFFER_SIZE);
+        buffer->len = URING_BUFFER_SIZE;
+        buffer->bid = i;
+    }
+    ring->buffer_tail = URING_BUFFER_COUNT;
+    __atomic_store_n(&ring->buffer_ring->tail, ring->buffer_tail, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// function that returns a cleared submission queue entry, submitting queued entries first if the queue is full
+// returns NULL on error
+static struct io_uring_sqe* uring_get_sqe(uring *ring) {
+    if (uring_reserve(ring, 1) == -1) {
+        return NULL;
+    }
+    struct io_uring_sqe *sqe = &ring->sqes[ring->sq_local_tail & ring->sq_mask];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    ring->sq_local_tail++;
+    ring->to_submit++;
+    return sqe;
+}
+
+// function that submits every queued entry without waiting for completions
+// returns -1 on error and 0 on success
+static int uring_submit(uring *ring) {
+    __atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+    int submitted = uring_enter(ring->ring_fd, ring->to_submit, 0, 0, NULL, 0);
+    if (submitted == -1) {
+        return -1;
+    }
+    ring->to_submit -= submitted;
+    return 0;
+}
@@ -0,0 +1,59 @@
+#ifndef P3_URING_H
+#define P3_URING_H
+
+#include <stdint.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <linux/io_uring.h>
+#include "helper.h"
+
+// declare enumeration for constants of the io_uring backend
+// the number of provided buffers must be a power of 2
+typedef enum uring_constant {
+    URING_ENTRIES = 256,
+    URING_BUFFER_COUNT = 1024,
+    URING_BUFFER_SIZE = 2048,
+    URING_BUFFER_GROUP = 0,
+} uring_constant;
+
+// define struct for an io_uring instance and the ring of provided buffers that multishot receives read into
+typedef struct uring {
+    int ring_fd;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned sq_mask;
+    unsigned sq_entries;
+    unsigned sq_local_tail;
+    unsigned to_submit;
+    struct io_uring_sqe *sqes;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe *cqes;
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+    struct io_uring_buf_ring *buffer_ring;
+    size_t buffer_ring_size;
+    char *buffers;
+    unsigned short buffer_tail;
+} uring;
+
+// prototypes of all functions
+int uring_create(uring *ring);
+void uring_destroy(uring *ring);
+int uring_reserve(uring *ring, unsigned number_of_entries);
+int uring_accept_multishot(uring *ring, int server_socket, uint64_t user_data);
+int uring_receive_multishot(uring *ring, int socket, uint64_t user_data);
+int uring_poll_multishot(uring *ring, int fd, uint64_t user_data);
+int uring_cancel(uring *ring, uint64_t target_user_data, uint64_t user_data);
+int uring_send_message(uring *ring, int socket, const struct msghdr *header, uint64_t user_data);
+int uring_wait(uring *ring, int timeout);
+struct io_uring_cqe* uring_get_completion(uring *ring);
+void uring_complete(uring *ring);
+char* uring_get_buffer(uring *ring, const struct io_uring_cqe *completion);
+void uring_recycle_buffer(uring *ring, const struct io_uring_cqe *completion);
+
+#endif //P3_URING_H